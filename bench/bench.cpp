@@ -0,0 +1,371 @@
+/// Benchmarks on synthetic dictionaries of several sizes, written by
+/// gen_body. For each size this times:
+///   - build_ms      macDict building the index cache from Body.data
+///   - open_us       opening the index cache, which replaced read_index()
+///   - lookup_ns     exact lookup of a headword
+///   - prefix_ns     listing the words with a prefix
+///   - link_ns       finding the entries a link goes to
+///   - render_us     macDict rendering the definition of a word, with -b,
+///                   less the time of a run of -b with no words, which is
+///                   that of starting and opening the index
+/// Each is the best of several runs. The results are written as a flat
+/// JSON object, "size.name": value, and if a baseline of earlier results
+/// is given, compared with it. The exit status is 1 if any result is
+/// slower than the baseline by more than g_slower.
+///
+/// bench [-b baseline.json] [-o results.json] macDict gen_body dir sizes...
+
+#include "Index.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <iterator>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+using std::cout;
+using std::cerr;
+
+/// Runs of each benchmark, the best of which is kept
+static const int g_runs = 3;
+/// Passes over the words in a run of the benchmarks in this process
+static const int g_passes = 20;
+/// Ratio to the baseline above which a result is shown as slower
+static const double g_slower = 1.10;
+
+typedef std::chrono::steady_clock ClockT;
+typedef std::map<std::string, double> ResultsT;
+
+static double seconds_since(const ClockT::time_point &start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static std::string quote(const std::string &s) {
+	std::string out = "'";
+	for (size_t i=0; i<s.size(); ++i) {
+		out += s[i] == '\'' ? std::string("'\\''") : std::string(1, s[i]);
+	}
+	return out + "'";
+}
+
+static bool file_exists(const std::string &fn) {
+	struct stat st;
+	return stat(fn.c_str(), &st) == 0;
+}
+
+/// Seconds 'command' took, or a negative number if it failed
+static double time_command(const std::string &command) {
+	const ClockT::time_point start = ClockT::now();
+	const int ret = system(command.c_str());
+	const double t = seconds_since(start);
+	if (ret != 0) {
+		cerr << "bench : failed: " << command << "\n";
+		return -1;
+	}
+	return t;
+}
+
+static int read_words(const std::string &fn, std::vector<std::string> &words) {
+	std::ifstream f(fn.c_str());
+	if (!f.is_open()) {
+		cerr << "bench : failed to read \"" << fn << "\"\n";
+		return 1;
+	}
+	std::string line;
+	while (std::getline(f, line)) {
+		if (!line.empty()) {
+			// keys of the index are downcased
+			for (size_t i=0; i<line.size(); ++i) {
+				if (line[i] >= 'A' && line[i] <= 'Z') {
+					line[i] += 'a' - 'A';
+				}
+			}
+			words.push_back(line);
+		}
+	}
+	return 0;
+}
+
+/// Best time of g_runs runs of g_passes passes of 'func' over 'words', per
+/// word. 'func' returns a number that depends on what it looked up, so the
+/// work isn't optimised away, and which should be more than 0 for the
+/// words to have been found.
+template <typename FuncT>
+static double time_words(
+	const char * const name,
+	const std::vector<std::string> &words,
+	FuncT func
+) {
+	double best = -1;
+	size_t found = 0;
+	for (int run=0; run<g_runs; ++run) {
+		const ClockT::time_point start = ClockT::now();
+		found = 0;
+		for (int pass=0; pass<g_passes; ++pass) {
+			for (size_t i=0; i<words.size(); ++i) {
+				found += func(words[i]);
+			}
+		}
+		const double t = seconds_since(start);
+		best = best < 0 ? t : std::min(best, t);
+	}
+	if (!found) {
+		cerr << "bench : " << name << " found nothing\n";
+		return -1;
+	}
+	return best / (double(g_passes) * words.size());
+}
+
+static int bench_size(
+	const std::string &macdict,
+	const std::string &gen_body,
+	const std::string &dir,
+	const std::string &size,
+	ResultsT &results
+) {
+	const std::string data_dir = dir + "/" + size;
+	const std::string body = data_dir + "/Body.data";
+	const std::string index_fn = data_dir + "/index";
+
+	// the same size always gives the same file, so it's kept
+	if (!file_exists(body)) {
+		cout << "Generating " << size << " entries\n";
+		if (	time_command("mkdir -p " + quote(data_dir)) < 0 ||
+			time_command(quote(gen_body) + " " + quote(data_dir) + " " + size) < 0
+		) {
+			return 1;
+		}
+	}
+
+	std::vector<std::string> lookups, prefixes, links;
+	if (	read_words(data_dir + "/lookups.txt", lookups) ||
+		read_words(data_dir + "/prefixes.txt", prefixes) ||
+		read_words(data_dir + "/links.txt", links)
+	) {
+		return 1;
+	}
+
+	cout << "Timing " << size << " entries\n";
+	const std::string dict = quote(macdict) + " -d " + quote(body) + " -i " + quote(index_fn);
+
+	double build = -1;
+	for (int run=0; run<g_runs; ++run) {
+		unlink(index_fn.c_str());
+		const double t = time_command(dict + " -l " + quote(lookups[0]) + " > /dev/null 2>&1");
+		if (t < 0) {
+			return 1;
+		}
+		build = build < 0 ? t : std::min(build, t);
+	}
+	results[size + ".build_ms"] = build * 1e3;
+
+	double open = -1;
+	for (int run=0; run<g_runs * g_passes; ++run) {
+		MappedIndex index;
+		const ClockT::time_point start = ClockT::now();
+		if (index.open(index_fn, cerr)) {
+			return 1;
+		}
+		const double t = seconds_since(start);
+		open = open < 0 ? t : std::min(open, t);
+	}
+	results[size + ".open_us"] = open * 1e6;
+
+	MappedIndex index;
+	if (index.open(index_fn, cerr)) {
+		return 1;
+	}
+
+	const double lookup = time_words("lookup", lookups,
+		[&index](const std::string &w) {
+			const RowRangeT r = index.entries(w);
+			return r.second - r.first;
+		});
+
+	const double prefix = time_words("prefix", prefixes,
+		[&index](const std::string &w) {
+			RowRangeT e, l;
+			index.words_with_prefix(w, e, l);
+			size_t bytes = 0;
+			for (size_t i=e.first; i<e.second; ++i) {
+				bytes += index.entry_key(i).size;
+			}
+			for (size_t i=l.first; i<l.second; ++i) {
+				bytes += index.link_key(i).size;
+			}
+			return bytes;
+		});
+
+	const double link = time_words("link", links,
+		[&index](const std::string &w) {
+			StringRef target;
+			if (!index.link(w, target)) {
+				return size_t(0);
+			}
+			const RowRangeT r = index.entries(target.str());
+			return r.second - r.first;
+		});
+
+	if (lookup < 0 || prefix < 0 || link < 0) {
+		return 1;
+	}
+	results[size + ".lookup_ns"] = lookup * 1e9;
+	results[size + ".prefix_ns"] = prefix * 1e9;
+	results[size + ".link_ns"] = link * 1e9;
+
+	const std::string none_fn = data_dir + "/none.txt";
+	if (!file_exists(none_fn) && time_command(": > " + quote(none_fn)) < 0) {
+		return 1;
+	}
+	double render = -1, startup = -1;
+	for (int run=0; run<g_runs; ++run) {
+		const double t = time_command(dict + " -b " + quote(data_dir + "/lookups.txt") +
+					      " -o /dev/null 2> /dev/null");
+		const double s = time_command(dict + " -b " + quote(none_fn) +
+					      " -o /dev/null 2> /dev/null");
+		if (t < 0 || s < 0) {
+			return 1;
+		}
+		render = render < 0 ? t : std::min(render, t);
+		startup = startup < 0 ? s : std::min(startup, s);
+	}
+	results[size + ".render_us"] = std::max(render - startup, 0.0) / lookups.size() * 1e6;
+
+	return 0;
+}
+
+static int write_results(const ResultsT &results, std::ostream &out) {
+	out << "{\n";
+	for (ResultsT::const_iterator it=results.begin(); it!=results.end(); ++it) {
+		out << "  \"" << it->first << "\": " << std::fixed << std::setprecision(3) <<
+			it->second << (std::next(it) == results.end() ? "\n" : ",\n");
+	}
+	out << "}\n";
+	return out ? 0 : 1;
+}
+
+/// Read results written by write_results
+static int read_results(const std::string &fn, ResultsT &results) {
+	std::ifstream f(fn.c_str());
+	if (!f.is_open()) {
+		cerr << "bench : failed to read \"" << fn << "\"\n";
+		return 1;
+	}
+	std::string line;
+	while (std::getline(f, line)) {
+		const size_t open = line.find('"');
+		const size_t close = line.find("\": ", open + 1);
+		if (open == std::string::npos || close == std::string::npos) {
+			continue;
+		}
+		results[line.substr(open + 1, close - open - 1)] = atof(line.c_str() + close + 3);
+	}
+	return 0;
+}
+
+/// Returns the number of results slower than the baseline
+static size_t compare_results(const ResultsT &baseline, const ResultsT &results) {
+	size_t slower = 0;
+	cout << std::left << std::setw(20) << "" << std::right <<
+		std::setw(12) << "baseline" << std::setw(12) << "now" << std::setw(8) << "ratio" << "\n";
+	for (ResultsT::const_iterator it=results.begin(); it!=results.end(); ++it) {
+		const ResultsT::const_iterator b = baseline.find(it->first);
+		cout << std::left << std::setw(20) << it->first << std::right << std::fixed;
+		if (b == baseline.end() || b->second <= 0) {
+			cout << std::setw(12) << "-" << std::setw(12) << std::setprecision(1) <<
+				it->second << "\n";
+			continue;
+		}
+		const double ratio = it->second / b->second;
+		slower += ratio > g_slower;
+		cout << std::setw(12) << std::setprecision(1) << b->second <<
+			std::setw(12) << it->second <<
+			std::setw(8) << std::setprecision(2) << ratio <<
+			(ratio > g_slower ? "  slower" : "") << "\n";
+	}
+	return slower;
+}
+
+static void usage(const char * const bin) {
+	cerr << bin << " [-h] [-b baseline.json] [-o results.json] macDict gen_body dir sizes...\n";
+	cerr << "\n";
+	cerr << "-h    Print help.\n";
+	cerr << "-b    Compare the results with those of an earlier run, and fail if any are\n";
+	cerr << "      slower.\n";
+	cerr << "-o    File to write the results to, as JSON. Defaults to stdout.\n";
+	cerr << "dir   Directory for the generated dictionaries, which are kept for later runs.\n";
+	cerr << "sizes Numbers of entries of the dictionaries.\n";
+}
+
+int main(int argc, char *argv[]) {
+	std::string baseline_fn, out_fn;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "hb:o:")) != -1) {
+		switch (opt) {
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		case 'b':
+			baseline_fn = optarg;
+			break;
+		case 'o':
+			out_fn = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind < 4) {
+		usage(argv[0]);
+		return 1;
+	}
+	const std::string macdict = argv[optind];
+	const std::string gen_body = argv[optind + 1];
+	const std::string dir = argv[optind + 2];
+
+	ResultsT results;
+	for (int i=optind+3; i<argc; ++i) {
+		if (atoi(argv[i]) < 1) {
+			cerr << argv[0] << " : sizes are numbers of entries\n";
+			return 1;
+		}
+		if (bench_size(macdict, gen_body, dir, argv[i], results)) {
+			return 1;
+		}
+	}
+
+	if (out_fn.empty()) {
+		write_results(results, cout);
+	} else {
+		std::ofstream out(out_fn.c_str(), std::ios::out|std::ios::trunc);
+		if (write_results(results, out)) {
+			cerr << argv[0] << " : failed to write \"" << out_fn << "\"\n";
+			return 1;
+		}
+		cout << "Results written to \"" << out_fn << "\"\n";
+	}
+
+	if (!baseline_fn.empty()) {
+		ResultsT baseline;
+		if (read_results(baseline_fn, baseline)) {
+			return 1;
+		}
+		const size_t slower = compare_results(baseline, results);
+		if (slower) {
+			cerr << argv[0] << " : " << slower << " results slower than the baseline\n";
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,299 @@
+/// Writes a synthetic Body.data for the benchmarks, with entries shaped like
+/// those of the Oxford dictionaries: the classes the headword and link
+/// XPath queries of macDict.cpp look for, senses with cross-references,
+/// phrases, phrasal verbs and derivatives. The same size and seed always
+/// give the same file.
+///
+/// gen_body dir entries [seed]
+///
+/// writes dir/Body.data, dir/DefaultStyle.css, and the words the
+/// benchmarks look up:
+///   - dir/lookups.txt   headwords
+///   - dir/prefixes.txt  prefixes of headwords
+///   - dir/links.txt     words found through links to their entries
+
+#include <zlib.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <stdint.h>
+
+using std::cerr;
+
+/// Inflated size after which a block is written
+static const size_t g_block_size = 16 << 10;
+/// Words written to each of the lists of words to look up
+static const size_t g_sample_size = 2000;
+/// Headwords with more than one entry, in percent
+static const unsigned int g_homographs = 3;
+
+static const char * const g_syllables[] = {
+	"ka", "lo", "mi", "pe", "ru", "sa", "ti", "vo", "ne", "bra", "cal",
+	"li", "py", "gi", "an", "dor", "ster", "qu", "ex", "ol", "ine", "ment",
+	"ph", "th", "un", "re", "é", "ç"
+};
+static const size_t g_num_syllables = sizeof(g_syllables) / sizeof(g_syllables[0]);
+
+static const char * const g_parts_of_speech[] = {
+	"noun", "verb", "adjective", "adverb"
+};
+
+/// Same sequence on every platform, unlike the std distributions
+class Random {
+public:
+	explicit Random(const uint32_t seed) : _state(seed * 2654435761u + 1) {}
+
+	uint32_t next() {
+		_state ^= _state << 13;
+		_state ^= _state >> 17;
+		_state ^= _state << 5;
+		return _state;
+	}
+	/// In [0, n)
+	size_t below(const size_t n) {
+		return next() % n;
+	}
+	bool chance(const unsigned int percent) {
+		return below(100) < percent;
+	}
+
+private:
+	uint32_t _state;
+};
+
+static std::string make_word(Random &r) {
+	std::string w;
+	const size_t n = 1 + r.below(4);
+	for (size_t i=0; i<n; ++i) {
+		w += g_syllables[r.below(g_num_syllables)];
+	}
+	return w;
+}
+
+static void append_le32(std::string &out, const uint32_t v) {
+	out += char(v & 0xff);
+	out += char((v >> 8) & 0xff);
+	out += char((v >> 16) & 0xff);
+	out += char((v >> 24) & 0xff);
+}
+
+static void put_le32(std::string &out, const size_t at, const uint32_t v) {
+	std::string s;
+	append_le32(s, v);
+	out.replace(at, 4, s);
+}
+
+/// Sentence of 'n' words, some of them from the dictionary
+static void append_text(
+	std::ostringstream &out,
+	Random &r,
+	const std::vector<std::string> &words,
+	const size_t n
+) {
+	for (size_t i=0; i<n; ++i) {
+		out << (i ? " " : "");
+		if (r.chance(30)) {
+			out << words[r.below(words.size())];
+		} else {
+			out << make_word(r);
+		}
+	}
+}
+
+/// An entry on one line, as each ends at a newline in Body.data. Sets
+/// 'headword' to the word it's the entry of.
+static std::string make_entry(
+	const size_t id,
+	Random &r,
+	const std::vector<std::string> &words,
+	const std::string &word,
+	std::string &headword
+) {
+	std::string title = word;
+	headword = word;
+	if (r.chance(5)) {
+		title[0] = toupper((unsigned char)title[0]);
+		headword = title;
+	} else if (r.chance(2)) {
+		title += " &amp; co";
+		headword += " & co";
+	}
+
+	std::ostringstream e;
+	char id_attr[32];
+	snprintf(id_attr, sizeof(id_attr), "m_en_gbus%07u", (unsigned int)id);
+
+	e << "<d:entry xmlns:d=\"http://www.apple.com/DTDs/DictionaryService-1.0.rng\" id=\"" <<
+		id_attr << "\" d:title=\"" << title << "\" class=\"entry\">";
+
+	e << "<span class=\"hg x_xh0\"><span role=\"text\" class=\"hw\">" << title << "</span>" <<
+		"<span class=\"prx\"> | <span class=\"ph\">" << make_word(r) << "</span> | </span>";
+	if (r.chance(15)) {
+		e << "<span class=\"vg\">(also <span class=\"v\">" << make_word(r) << "</span>)</span>";
+	}
+	e << "</span>";
+
+	const size_t num_groups = 1 + r.below(2);
+	for (size_t g=0; g<num_groups; ++g) {
+		const char * const pos = g_parts_of_speech[r.below(4)];
+		e << "<span class=\"sg\"><span class=\"se1\">" <<
+			"<span role=\"text\" class=\"posg x_xdh\"><span class=\"pos\">" << pos << "</span></span>";
+		if (!strcmp(pos, "noun") && r.chance(50)) {
+			e << "<span class=\"fg\"><span class=\"f\">" << word << "s</span></span>";
+		}
+
+		const size_t num_senses = 1 + r.below(4);
+		for (size_t s=0; s<num_senses; ++s) {
+			e << "<span class=\"msDict x_xo1 t_core\"><span class=\"sn\">" << s+1 << "</span>" <<
+				"<span class=\"df\">";
+			append_text(e, r, words, 6 + r.below(14));
+			e << "</span><span class=\"eg\"><span class=\"ex\">";
+			append_text(e, r, words, 4 + r.below(8));
+			e << "</span></span>";
+			if (r.chance(25)) {
+				const std::string &to = words[r.below(words.size())];
+				e << "<span class=\"xrg\">see <a href=\"x-dictionary:d:" << to <<
+					":com.apple.dictionary.ODE\"><span class=\"xr\">" << to << "</span></a></span>";
+			}
+			e << "</span>";
+		}
+		e << "</span></span>";
+	}
+
+	if (r.chance(30)) {
+		const std::string phrase = word + " " + words[r.below(words.size())];
+		std::string other = phrase;
+		other[word.size()] = '-';
+		e << "<span class=\"t_phrases\"><span class=\"x_xoLblBlk\">PHRASES</span>" <<
+			"<span class=\"subEntry\"><span role=\"text\" class=\"l\">" << phrase << "</span>" <<
+			"<span class=\"vg\"><span class=\"v\">" << other << "</span></span>" <<
+			"<span class=\"df\">";
+		append_text(e, r, words, 8);
+		e << "</span></span></span>";
+	}
+
+	if (r.chance(15)) {
+		e << "<span class=\"t_phrasalVerbs\"><span class=\"x_xoLblBlk\">PHRASAL VERBS</span>" <<
+			"<span class=\"subEntry\"><span class=\"l\" role=\"text\">" << word << " on</span>" <<
+			"<span class=\"df\">";
+		append_text(e, r, words, 6);
+		e << "</span></span></span>";
+	}
+
+	if (r.chance(40)) {
+		e << "<span class=\"t_derivatives\"><span class=\"x_xoLblBlk\">DERIVATIVES</span>" <<
+			"<span class=\"subEntry\"><span class=\"x_xoh\">" <<
+			"<span role=\"text\" class=\"l\">" << word << "ness</span>" <<
+			"<span role=\"text\" class=\"gg\">noun</span></span></span></span>";
+	}
+
+	e << "</d:entry>";
+	return e.str();
+}
+
+/// Write the block of the inflated 'raw' to 'out'
+static int write_block(const std::string &raw, std::string &out) {
+	uLongf size = compressBound(raw.size());
+	std::string z(size, '\0');
+	if (compress2((Bytef*)&z[0], &size, (const Bytef*)raw.data(), raw.size(), 6) != Z_OK) {
+		return 1;
+	}
+	z.resize(size);
+
+	append_le32(out, z.size() + 8);
+	append_le32(out, z.size() + 4);
+	append_le32(out, raw.size());
+	out += z;
+	return 0;
+}
+
+static int write_file(const std::string &fn, const std::string &data) {
+	std::ofstream f(fn.c_str(), std::ios::out|std::ios::trunc|std::ios::binary);
+	f.write(data.data(), data.size());
+	f.close();
+	if (!f) {
+		cerr << "gen_body : failed to write \"" << fn << "\"\n";
+		return 1;
+	}
+	return 0;
+}
+
+static void add_sample(std::string &list, const std::string &word) {
+	list += word;
+	list += '\n';
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3 || atoi(argv[2]) < 1) {
+		cerr << "gen_body dir entries [seed]\n";
+		return 1;
+	}
+	const std::string dir = argv[1];
+	const size_t num_entries = atoi(argv[2]);
+	Random r(argc > 3 ? atoi(argv[3]) : 1);
+
+	// headwords are mostly unique, as in a real dictionary
+	std::vector<std::string> words;
+	std::set<std::string> seen;
+	while (words.size() < num_entries) {
+		if (!words.empty() && r.chance(g_homographs)) {
+			words.push_back(words[r.below(words.size())]);
+			continue;
+		}
+		std::string w = make_word(r);
+		while (!seen.insert(w).second) {
+			w += g_syllables[r.below(g_num_syllables)];
+		}
+		words.push_back(w);
+	}
+
+	// every n-th word, so the samples are spread over the dictionary
+	const size_t step = std::max(num_entries / g_sample_size, size_t(1));
+	std::string lookups, prefixes, links;
+
+	// header, with the size of the rest at 0x40
+	std::string body(0x60, '\0');
+	std::string block, headword;
+	for (size_t i=0; i<num_entries; ++i) {
+		const std::string entry = make_entry(i, r, words, words[i], headword);
+		// each entry is preceded by its size, with the newline
+		append_le32(block, entry.size() + 1);
+		block += entry;
+		block += '\n';
+
+		if (i % step == 0) {
+			add_sample(lookups, headword);
+			add_sample(prefixes, words[i].substr(0, 2));
+			if (entry.find("ness</span>") != std::string::npos) {
+				add_sample(links, words[i] + "ness");
+			}
+		}
+
+		if (block.size() >= g_block_size || i + 1 == num_entries) {
+			if (write_block(block, body)) {
+				cerr << "gen_body : failed to compress a block\n";
+				return 1;
+			}
+			block.clear();
+		}
+	}
+	put_le32(body, 0x40, body.size() - 0x40);
+
+	if (	write_file(dir + "/Body.data", body) ||
+		write_file(dir + "/DefaultStyle.css", ".hw { font-weight: bold; }\n") ||
+		write_file(dir + "/lookups.txt", lookups) ||
+		write_file(dir + "/prefixes.txt", prefixes) ||
+		write_file(dir + "/links.txt", links)
+	) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef INCLUDED_BLOCKCACHE_H
+#define INCLUDED_BLOCKCACHE_H
+
+#include "Index.h"
+#include "LruCache.h"
+#include <string>
+
+/// Least recently used cache of inflated blocks of Body.data, keyed by the
+/// range of bytes of the compressed block in the file. Thread safe.
+typedef LruCache<ByteRangeT, std::string> BlockCache;
+
+#endif
@@ -0,0 +1,18 @@
+#include "DefinitionPage.h"
+
+DefinitionPage::DefinitionPage(QObject *parent)
+	: QWebEnginePage(parent) {}
+
+DefinitionPage::~DefinitionPage() {}
+
+bool DefinitionPage::acceptNavigationRequest(
+	const QUrl &url,
+	NavigationType type,
+	bool isMainFrame
+) {
+	if (type == NavigationTypeLinkClicked) {
+		emit link_clicked(url);
+		return false;
+	}
+	return QWebEnginePage::acceptNavigationRequest(url, type, isMainFrame);
+}
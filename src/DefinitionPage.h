@@ -0,0 +1,21 @@
+#ifndef INCLUDED_DEFINITIONPAGE_H
+#define INCLUDED_DEFINITIONPAGE_H
+
+#include <QtWebEngineWidgets/QWebEnginePage>
+
+/// Page of the definition view. Clicked links aren't loaded, they're
+/// passed to link_clicked() so the window can look them up.
+class DefinitionPage : public QWebEnginePage {
+Q_OBJECT
+public:
+	DefinitionPage(QObject *parent);
+	virtual ~DefinitionPage();
+
+signals:
+	void link_clicked(const QUrl &url);
+
+protected:
+	virtual bool acceptNavigationRequest(const QUrl &url, NavigationType type, bool isMainFrame);
+};
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef INCLUDED_DICTIONARY_H
 #define INCLUDED_DICTIONARY_H
 
+#include <string>
+#include <iosfwd>
+#include <cstddef>
+
 struct DictionaryRef;
 
 void output_color_css(const char *text, const char *background, std::ostream &out);
@@ -9,6 +13,10 @@ void output_body_css(const bool dark, std::ostream &out);
 /// Trim whitespace at the left and right
 void strip(std::string &s);
 
+/// Call at the start of a thread, other than the main one, which outputs
+/// definitions
+void init_lookup_thread();
+
 int output_definition(
 	const DictionaryRef &d,
 	const std::string &target,
@@ -17,10 +25,69 @@ int output_definition(
 	std::ostream &out,
 	std::ostream &err);
 
+/// List the words for which 'target' is a prefix, or if there are none,
+/// those for which it is a prefix ignoring case, accents and punctuation
+void list_words(
+	const DictionaryRef &d,
+	const std::string &target,
+	void (*func)(const std::string &, void *data),
+	void *data);
+
+/// Like list_words, for at most 'count' of the words, skipping the first
+/// 'first'. The words are in the same order as list_words.
 void list_words(
 	const DictionaryRef &d,
 	const std::string &target,
+	const size_t first,
+	const size_t count,
 	void (*func)(const std::string &, void *data),
 	void *data);
 
+/// Number of words list_words would list, without listing them
+size_t count_words(const DictionaryRef &d, const std::string &target);
+
+/// Words spelt like 'target', closest first, for when it has no
+/// definition or isn't a prefix of any word
+void suggest_words(
+	const DictionaryRef &d,
+	const std::string &target,
+	void (*func)(const std::string &, void *data),
+	void *data);
+
+/// Words of the entries that match the full-text 'query', best first.
+/// Returns non-zero and writes a message to 'err' if there is no full-text
+/// index or the query is invalid.
+int search_words(
+	const DictionaryRef &d,
+	const std::string &query,
+	void (*func)(const std::string &, void *data),
+	void *data,
+	std::ostream &err);
+
+/// True if 'target' has a definition
+bool word_exists(const DictionaryRef &d, const std::string &target);
+
+/// Sets 'word' to the word an entry link of a definition goes to, named by
+/// its 'href', which is decoded, or else by its 'text', as links to entry
+/// ids don't name one. Returns false if the word has no definition.
+bool resolve_link(
+	const DictionaryRef &d,
+	const std::string &href,
+	const std::string &text,
+	std::string &word);
+
+/// Progress of building the index. Until it is complete, lookups use the
+/// part of the index built so far.
+struct IndexStatus {
+	/// Fraction of Body.data that has been indexed, from 0 to 1. The
+	/// links are found after that.
+	double progress;
+	/// All the entries and links are indexed
+	bool complete;
+	/// Changes each time a bigger index is used for lookups
+	unsigned int generation;
+};
+
+IndexStatus index_status(const DictionaryRef &d);
+
 #endif
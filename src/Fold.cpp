@@ -0,0 +1,1726 @@
+#include "Fold.h"
+#include <algorithm>
+#include <stdint.h>
+
+struct FoldEntry {
+	uint32_t cp;
+	/// UTF-8, a space for punctuation
+	const char *folded;
+};
+
+/// Characters which fold to something else, sorted. Generated with
+/// Python's unicodedata: NFKD, case folded, NFKD again, combining marks
+/// removed, punctuation, symbols and spaces as a space, and some letters
+/// which don't decompose folded by hand (æ ae, œ oe, ø o, đ d, ł l, ħ h,
+/// ı i, ŧ t, ð d, ƒ f, ŋ n, ſ s). Cyrillic is only case folded. Ranges:
+/// U+00A0-05FF, U+1E00-209F, U+FB00-FB06 and U+FF01-FF5E.
+static const FoldEntry g_fold_table[] = {
+	{ 0x00a0, " " },
+	{ 0x00a1, " " },
+	{ 0x00a2, " " },
+	{ 0x00a3, " " },
+	{ 0x00a4, " " },
+	{ 0x00a5, " " },
+	{ 0x00a6, " " },
+	{ 0x00a7, " " },
+	{ 0x00a8, " " },
+	{ 0x00a9, " " },
+	{ 0x00aa, "a" },
+	{ 0x00ab, " " },
+	{ 0x00ac, " " },
+	{ 0x00ae, " " },
+	{ 0x00af, " " },
+	{ 0x00b0, " " },
+	{ 0x00b1, " " },
+	{ 0x00b2, "2" },
+	{ 0x00b3, "3" },
+	{ 0x00b4, " " },
+	{ 0x00b5, "\316\274" },
+	{ 0x00b6, " " },
+	{ 0x00b7, " " },
+	{ 0x00b8, " " },
+	{ 0x00b9, "1" },
+	{ 0x00ba, "o" },
+	{ 0x00bb, " " },
+	{ 0x00bc, "1 4" },
+	{ 0x00bd, "1 2" },
+	{ 0x00be, "3 4" },
+	{ 0x00bf, " " },
+	{ 0x00c0, "a" },
+	{ 0x00c1, "a" },
+	{ 0x00c2, "a" },
+	{ 0x00c3, "a" },
+	{ 0x00c4, "a" },
+	{ 0x00c5, "a" },
+	{ 0x00c6, "ae" },
+	{ 0x00c7, "c" },
+	{ 0x00c8, "e" },
+	{ 0x00c9, "e" },
+	{ 0x00ca, "e" },
+	{ 0x00cb, "e" },
+	{ 0x00cc, "i" },
+	{ 0x00cd, "i" },
+	{ 0x00ce, "i" },
+	{ 0x00cf, "i" },
+	{ 0x00d0, "d" },
+	{ 0x00d1, "n" },
+	{ 0x00d2, "o" },
+	{ 0x00d3, "o" },
+	{ 0x00d4, "o" },
+	{ 0x00d5, "o" },
+	{ 0x00d6, "o" },
+	{ 0x00d7, " " },
+	{ 0x00d8, "o" },
+	{ 0x00d9, "u" },
+	{ 0x00da, "u" },
+	{ 0x00db, "u" },
+	{ 0x00dc, "u" },
+	{ 0x00dd, "y" },
+	{ 0x00de, "\303\276" },
+	{ 0x00df, "ss" },
+	{ 0x00e0, "a" },
+	{ 0x00e1, "a" },
+	{ 0x00e2, "a" },
+	{ 0x00e3, "a" },
+	{ 0x00e4, "a" },
+	{ 0x00e5, "a" },
+	{ 0x00e6, "ae" },
+	{ 0x00e7, "c" },
+	{ 0x00e8, "e" },
+	{ 0x00e9, "e" },
+	{ 0x00ea, "e" },
+	{ 0x00eb, "e" },
+	{ 0x00ec, "i" },
+	{ 0x00ed, "i" },
+	{ 0x00ee, "i" },
+	{ 0x00ef, "i" },
+	{ 0x00f0, "d" },
+	{ 0x00f1, "n" },
+	{ 0x00f2, "o" },
+	{ 0x00f3, "o" },
+	{ 0x00f4, "o" },
+	{ 0x00f5, "o" },
+	{ 0x00f6, "o" },
+	{ 0x00f7, " " },
+	{ 0x00f8, "o" },
+	{ 0x00f9, "u" },
+	{ 0x00fa, "u" },
+	{ 0x00fb, "u" },
+	{ 0x00fc, "u" },
+	{ 0x00fd, "y" },
+	{ 0x00ff, "y" },
+	{ 0x0100, "a" },
+	{ 0x0101, "a" },
+	{ 0x0102, "a" },
+	{ 0x0103, "a" },
+	{ 0x0104, "a" },
+	{ 0x0105, "a" },
+	{ 0x0106, "c" },
+	{ 0x0107, "c" },
+	{ 0x0108, "c" },
+	{ 0x0109, "c" },
+	{ 0x010a, "c" },
+	{ 0x010b, "c" },
+	{ 0x010c, "c" },
+	{ 0x010d, "c" },
+	{ 0x010e, "d" },
+	{ 0x010f, "d" },
+	{ 0x0110, "d" },
+	{ 0x0111, "d" },
+	{ 0x0112, "e" },
+	{ 0x0113, "e" },
+	{ 0x0114, "e" },
+	{ 0x0115, "e" },
+	{ 0x0116, "e" },
+	{ 0x0117, "e" },
+	{ 0x0118, "e" },
+	{ 0x0119, "e" },
+	{ 0x011a, "e" },
+	{ 0x011b, "e" },
+	{ 0x011c, "g" },
+	{ 0x011d, "g" },
+	{ 0x011e, "g" },
+	{ 0x011f, "g" },
+	{ 0x0120, "g" },
+	{ 0x0121, "g" },
+	{ 0x0122, "g" },
+	{ 0x0123, "g" },
+	{ 0x0124, "h" },
+	{ 0x0125, "h" },
+	{ 0x0126, "h" },
+	{ 0x0127, "h" },
+	{ 0x0128, "i" },
+	{ 0x0129, "i" },
+	{ 0x012a, "i" },
+	{ 0x012b, "i" },
+	{ 0x012c, "i" },
+	{ 0x012d, "i" },
+	{ 0x012e, "i" },
+	{ 0x012f, "i" },
+	{ 0x0130, "i" },
+	{ 0x0131, "i" },
+	{ 0x0132, "ij" },
+	{ 0x0133, "ij" },
+	{ 0x0134, "j" },
+	{ 0x0135, "j" },
+	{ 0x0136, "k" },
+	{ 0x0137, "k" },
+	{ 0x0139, "l" },
+	{ 0x013a, "l" },
+	{ 0x013b, "l" },
+	{ 0x013c, "l" },
+	{ 0x013d, "l" },
+	{ 0x013e, "l" },
+	{ 0x013f, "l " },
+	{ 0x0140, "l " },
+	{ 0x0141, "l" },
+	{ 0x0142, "l" },
+	{ 0x0143, "n" },
+	{ 0x0144, "n" },
+	{ 0x0145, "n" },
+	{ 0x0146, "n" },
+	{ 0x0147, "n" },
+	{ 0x0148, "n" },
+	{ 0x0149, "\312\274n" },
+	{ 0x014a, "n" },
+	{ 0x014b, "n" },
+	{ 0x014c, "o" },
+	{ 0x014d, "o" },
+	{ 0x014e, "o" },
+	{ 0x014f, "o" },
+	{ 0x0150, "o" },
+	{ 0x0151, "o" },
+	{ 0x0152, "oe" },
+	{ 0x0153, "oe" },
+	{ 0x0154, "r" },
+	{ 0x0155, "r" },
+	{ 0x0156, "r" },
+	{ 0x0157, "r" },
+	{ 0x0158, "r" },
+	{ 0x0159, "r" },
+	{ 0x015a, "s" },
+	{ 0x015b, "s" },
+	{ 0x015c, "s" },
+	{ 0x015d, "s" },
+	{ 0x015e, "s" },
+	{ 0x015f, "s" },
+	{ 0x0160, "s" },
+	{ 0x0161, "s" },
+	{ 0x0162, "t" },
+	{ 0x0163, "t" },
+	{ 0x0164, "t" },
+	{ 0x0165, "t" },
+	{ 0x0166, "t" },
+	{ 0x0167, "t" },
+	{ 0x0168, "u" },
+	{ 0x0169, "u" },
+	{ 0x016a, "u" },
+	{ 0x016b, "u" },
+	{ 0x016c, "u" },
+	{ 0x016d, "u" },
+	{ 0x016e, "u" },
+	{ 0x016f, "u" },
+	{ 0x0170, "u" },
+	{ 0x0171, "u" },
+	{ 0x0172, "u" },
+	{ 0x0173, "u" },
+	{ 0x0174, "w" },
+	{ 0x0175, "w" },
+	{ 0x0176, "y" },
+	{ 0x0177, "y" },
+	{ 0x0178, "y" },
+	{ 0x0179, "z" },
+	{ 0x017a, "z" },
+	{ 0x017b, "z" },
+	{ 0x017c, "z" },
+	{ 0x017d, "z" },
+	{ 0x017e, "z" },
+	{ 0x017f, "s" },
+	{ 0x0181, "\311\223" },
+	{ 0x0182, "\306\203" },
+	{ 0x0184, "\306\205" },
+	{ 0x0186, "\311\224" },
+	{ 0x0187, "\306\210" },
+	{ 0x0189, "\311\226" },
+	{ 0x018a, "\311\227" },
+	{ 0x018b, "\306\214" },
+	{ 0x018e, "\307\235" },
+	{ 0x018f, "\311\231" },
+	{ 0x0190, "\311\233" },
+	{ 0x0191, "f" },
+	{ 0x0192, "f" },
+	{ 0x0193, "\311\240" },
+	{ 0x0194, "\311\243" },
+	{ 0x0196, "\311\251" },
+	{ 0x0197, "\311\250" },
+	{ 0x0198, "\306\231" },
+	{ 0x019c, "\311\257" },
+	{ 0x019d, "\311\262" },
+	{ 0x019f, "\311\265" },
+	{ 0x01a0, "o" },
+	{ 0x01a1, "o" },
+	{ 0x01a2, "\306\243" },
+	{ 0x01a4, "\306\245" },
+	{ 0x01a6, "\312\200" },
+	{ 0x01a7, "\306\250" },
+	{ 0x01a9, "\312\203" },
+	{ 0x01ac, "\306\255" },
+	{ 0x01ae, "\312\210" },
+	{ 0x01af, "u" },
+	{ 0x01b0, "u" },
+	{ 0x01b1, "\312\212" },
+	{ 0x01b2, "\312\213" },
+	{ 0x01b3, "\306\264" },
+	{ 0x01b5, "\306\266" },
+	{ 0x01b7, "\312\222" },
+	{ 0x01b8, "\306\271" },
+	{ 0x01bc, "\306\275" },
+	{ 0x01c4, "dz" },
+	{ 0x01c5, "dz" },
+	{ 0x01c6, "dz" },
+	{ 0x01c7, "lj" },
+	{ 0x01c8, "lj" },
+	{ 0x01c9, "lj" },
+	{ 0x01ca, "nj" },
+	{ 0x01cb, "nj" },
+	{ 0x01cc, "nj" },
+	{ 0x01cd, "a" },
+	{ 0x01ce, "a" },
+	{ 0x01cf, "i" },
+	{ 0x01d0, "i" },
+	{ 0x01d1, "o" },
+	{ 0x01d2, "o" },
+	{ 0x01d3, "u" },
+	{ 0x01d4, "u" },
+	{ 0x01d5, "u" },
+	{ 0x01d6, "u" },
+	{ 0x01d7, "u" },
+	{ 0x01d8, "u" },
+	{ 0x01d9, "u" },
+	{ 0x01da, "u" },
+	{ 0x01db, "u" },
+	{ 0x01dc, "u" },
+	{ 0x01de, "a" },
+	{ 0x01df, "a" },
+	{ 0x01e0, "a" },
+	{ 0x01e1, "a" },
+	{ 0x01e2, "ae" },
+	{ 0x01e3, "ae" },
+	{ 0x01e4, "\307\245" },
+	{ 0x01e6, "g" },
+	{ 0x01e7, "g" },
+	{ 0x01e8, "k" },
+	{ 0x01e9, "k" },
+	{ 0x01ea, "o" },
+	{ 0x01eb, "o" },
+	{ 0x01ec, "o" },
+	{ 0x01ed, "o" },
+	{ 0x01ee, "\312\222" },
+	{ 0x01ef, "\312\222" },
+	{ 0x01f0, "j" },
+	{ 0x01f1, "dz" },
+	{ 0x01f2, "dz" },
+	{ 0x01f3, "dz" },
+	{ 0x01f4, "g" },
+	{ 0x01f5, "g" },
+	{ 0x01f6, "\306\225" },
+	{ 0x01f7, "\306\277" },
+	{ 0x01f8, "n" },
+	{ 0x01f9, "n" },
+	{ 0x01fa, "a" },
+	{ 0x01fb, "a" },
+	{ 0x01fc, "ae" },
+	{ 0x01fd, "ae" },
+	{ 0x01fe, "o" },
+	{ 0x01ff, "o" },
+	{ 0x0200, "a" },
+	{ 0x0201, "a" },
+	{ 0x0202, "a" },
+	{ 0x0203, "a" },
+	{ 0x0204, "e" },
+	{ 0x0205, "e" },
+	{ 0x0206, "e" },
+	{ 0x0207, "e" },
+	{ 0x0208, "i" },
+	{ 0x0209, "i" },
+	{ 0x020a, "i" },
+	{ 0x020b, "i" },
+	{ 0x020c, "o" },
+	{ 0x020d, "o" },
+	{ 0x020e, "o" },
+	{ 0x020f, "o" },
+	{ 0x0210, "r" },
+	{ 0x0211, "r" },
+	{ 0x0212, "r" },
+	{ 0x0213, "r" },
+	{ 0x0214, "u" },
+	{ 0x0215, "u" },
+	{ 0x0216, "u" },
+	{ 0x0217, "u" },
+	{ 0x0218, "s" },
+	{ 0x0219, "s" },
+	{ 0x021a, "t" },
+	{ 0x021b, "t" },
+	{ 0x021c, "\310\235" },
+	{ 0x021e, "h" },
+	{ 0x021f, "h" },
+	{ 0x0220, "\306\236" },
+	{ 0x0222, "\310\243" },
+	{ 0x0224, "\310\245" },
+	{ 0x0226, "a" },
+	{ 0x0227, "a" },
+	{ 0x0228, "e" },
+	{ 0x0229, "e" },
+	{ 0x022a, "o" },
+	{ 0x022b, "o" },
+	{ 0x022c, "o" },
+	{ 0x022d, "o" },
+	{ 0x022e, "o" },
+	{ 0x022f, "o" },
+	{ 0x0230, "o" },
+	{ 0x0231, "o" },
+	{ 0x0232, "y" },
+	{ 0x0233, "y" },
+	{ 0x023a, "\342\261\245" },
+	{ 0x023b, "\310\274" },
+	{ 0x023d, "\306\232" },
+	{ 0x023e, "\342\261\246" },
+	{ 0x0241, "\311\202" },
+	{ 0x0243, "\306\200" },
+	{ 0x0244, "\312\211" },
+	{ 0x0245, "\312\214" },
+	{ 0x0246, "\311\207" },
+	{ 0x0248, "\311\211" },
+	{ 0x024a, "\311\213" },
+	{ 0x024c, "\311\215" },
+	{ 0x024e, "\311\217" },
+	{ 0x02b0, "h" },
+	{ 0x02b1, "\311\246" },
+	{ 0x02b2, "j" },
+	{ 0x02b3, "r" },
+	{ 0x02b4, "\311\271" },
+	{ 0x02b5, "\311\273" },
+	{ 0x02b6, "\312\201" },
+	{ 0x02b7, "w" },
+	{ 0x02b8, "y" },
+	{ 0x02c2, " " },
+	{ 0x02c3, " " },
+	{ 0x02c4, " " },
+	{ 0x02c5, " " },
+	{ 0x02d2, " " },
+	{ 0x02d3, " " },
+	{ 0x02d4, " " },
+	{ 0x02d5, " " },
+	{ 0x02d6, " " },
+	{ 0x02d7, " " },
+	{ 0x02d8, " " },
+	{ 0x02d9, " " },
+	{ 0x02da, " " },
+	{ 0x02db, " " },
+	{ 0x02dc, " " },
+	{ 0x02dd, " " },
+	{ 0x02de, " " },
+	{ 0x02df, " " },
+	{ 0x02e0, "\311\243" },
+	{ 0x02e1, "l" },
+	{ 0x02e2, "s" },
+	{ 0x02e3, "x" },
+	{ 0x02e4, "\312\225" },
+	{ 0x02e5, " " },
+	{ 0x02e6, " " },
+	{ 0x02e7, " " },
+	{ 0x02e8, " " },
+	{ 0x02e9, " " },
+	{ 0x02ea, " " },
+	{ 0x02eb, " " },
+	{ 0x02ed, " " },
+	{ 0x02ef, " " },
+	{ 0x02f0, " " },
+	{ 0x02f1, " " },
+	{ 0x02f2, " " },
+	{ 0x02f3, " " },
+	{ 0x02f4, " " },
+	{ 0x02f5, " " },
+	{ 0x02f6, " " },
+	{ 0x02f7, " " },
+	{ 0x02f8, " " },
+	{ 0x02f9, " " },
+	{ 0x02fa, " " },
+	{ 0x02fb, " " },
+	{ 0x02fc, " " },
+	{ 0x02fd, " " },
+	{ 0x02fe, " " },
+	{ 0x02ff, " " },
+	{ 0x0300, "" },
+	{ 0x0301, "" },
+	{ 0x0302, "" },
+	{ 0x0303, "" },
+	{ 0x0304, "" },
+	{ 0x0305, "" },
+	{ 0x0306, "" },
+	{ 0x0307, "" },
+	{ 0x0308, "" },
+	{ 0x0309, "" },
+	{ 0x030a, "" },
+	{ 0x030b, "" },
+	{ 0x030c, "" },
+	{ 0x030d, "" },
+	{ 0x030e, "" },
+	{ 0x030f, "" },
+	{ 0x0310, "" },
+	{ 0x0311, "" },
+	{ 0x0312, "" },
+	{ 0x0313, "" },
+	{ 0x0314, "" },
+	{ 0x0315, "" },
+	{ 0x0316, "" },
+	{ 0x0317, "" },
+	{ 0x0318, "" },
+	{ 0x0319, "" },
+	{ 0x031a, "" },
+	{ 0x031b, "" },
+	{ 0x031c, "" },
+	{ 0x031d, "" },
+	{ 0x031e, "" },
+	{ 0x031f, "" },
+	{ 0x0320, "" },
+	{ 0x0321, "" },
+	{ 0x0322, "" },
+	{ 0x0323, "" },
+	{ 0x0324, "" },
+	{ 0x0325, "" },
+	{ 0x0326, "" },
+	{ 0x0327, "" },
+	{ 0x0328, "" },
+	{ 0x0329, "" },
+	{ 0x032a, "" },
+	{ 0x032b, "" },
+	{ 0x032c, "" },
+	{ 0x032d, "" },
+	{ 0x032e, "" },
+	{ 0x032f, "" },
+	{ 0x0330, "" },
+	{ 0x0331, "" },
+	{ 0x0332, "" },
+	{ 0x0333, "" },
+	{ 0x0334, "" },
+	{ 0x0335, "" },
+	{ 0x0336, "" },
+	{ 0x0337, "" },
+	{ 0x0338, "" },
+	{ 0x0339, "" },
+	{ 0x033a, "" },
+	{ 0x033b, "" },
+	{ 0x033c, "" },
+	{ 0x033d, "" },
+	{ 0x033e, "" },
+	{ 0x033f, "" },
+	{ 0x0340, "" },
+	{ 0x0341, "" },
+	{ 0x0342, "" },
+	{ 0x0343, "" },
+	{ 0x0344, "" },
+	{ 0x0345, "" },
+	{ 0x0346, "" },
+	{ 0x0347, "" },
+	{ 0x0348, "" },
+	{ 0x0349, "" },
+	{ 0x034a, "" },
+	{ 0x034b, "" },
+	{ 0x034c, "" },
+	{ 0x034d, "" },
+	{ 0x034e, "" },
+	{ 0x034f, "" },
+	{ 0x0350, "" },
+	{ 0x0351, "" },
+	{ 0x0352, "" },
+	{ 0x0353, "" },
+	{ 0x0354, "" },
+	{ 0x0355, "" },
+	{ 0x0356, "" },
+	{ 0x0357, "" },
+	{ 0x0358, "" },
+	{ 0x0359, "" },
+	{ 0x035a, "" },
+	{ 0x035b, "" },
+	{ 0x035c, "" },
+	{ 0x035d, "" },
+	{ 0x035e, "" },
+	{ 0x035f, "" },
+	{ 0x0360, "" },
+	{ 0x0361, "" },
+	{ 0x0362, "" },
+	{ 0x0363, "" },
+	{ 0x0364, "" },
+	{ 0x0365, "" },
+	{ 0x0366, "" },
+	{ 0x0367, "" },
+	{ 0x0368, "" },
+	{ 0x0369, "" },
+	{ 0x036a, "" },
+	{ 0x036b, "" },
+	{ 0x036c, "" },
+	{ 0x036d, "" },
+	{ 0x036e, "" },
+	{ 0x036f, "" },
+	{ 0x0370, "\315\261" },
+	{ 0x0372, "\315\263" },
+	{ 0x0374, "\312\271" },
+	{ 0x0375, " " },
+	{ 0x0376, "\315\267" },
+	{ 0x037a, " \316\271" },
+	{ 0x037e, " " },
+	{ 0x037f, "\317\263" },
+	{ 0x0384, " " },
+	{ 0x0385, " " },
+	{ 0x0386, "\316\261" },
+	{ 0x0387, " " },
+	{ 0x0388, "\316\265" },
+	{ 0x0389, "\316\267" },
+	{ 0x038a, "\316\271" },
+	{ 0x038c, "\316\277" },
+	{ 0x038e, "\317\205" },
+	{ 0x038f, "\317\211" },
+	{ 0x0390, "\316\271" },
+	{ 0x0391, "\316\261" },
+	{ 0x0392, "\316\262" },
+	{ 0x0393, "\316\263" },
+	{ 0x0394, "\316\264" },
+	{ 0x0395, "\316\265" },
+	{ 0x0396, "\316\266" },
+	{ 0x0397, "\316\267" },
+	{ 0x0398, "\316\270" },
+	{ 0x0399, "\316\271" },
+	{ 0x039a, "\316\272" },
+	{ 0x039b, "\316\273" },
+	{ 0x039c, "\316\274" },
+	{ 0x039d, "\316\275" },
+	{ 0x039e, "\316\276" },
+	{ 0x039f, "\316\277" },
+	{ 0x03a0, "\317\200" },
+	{ 0x03a1, "\317\201" },
+	{ 0x03a3, "\317\203" },
+	{ 0x03a4, "\317\204" },
+	{ 0x03a5, "\317\205" },
+	{ 0x03a6, "\317\206" },
+	{ 0x03a7, "\317\207" },
+	{ 0x03a8, "\317\210" },
+	{ 0x03a9, "\317\211" },
+	{ 0x03aa, "\316\271" },
+	{ 0x03ab, "\317\205" },
+	{ 0x03ac, "\316\261" },
+	{ 0x03ad, "\316\265" },
+	{ 0x03ae, "\316\267" },
+	{ 0x03af, "\316\271" },
+	{ 0x03b0, "\317\205" },
+	{ 0x03c2, "\317\203" },
+	{ 0x03ca, "\316\271" },
+	{ 0x03cb, "\317\205" },
+	{ 0x03cc, "\316\277" },
+	{ 0x03cd, "\317\205" },
+	{ 0x03ce, "\317\211" },
+	{ 0x03cf, "\317\227" },
+	{ 0x03d0, "\316\262" },
+	{ 0x03d1, "\316\270" },
+	{ 0x03d2, "\317\205" },
+	{ 0x03d3, "\317\205" },
+	{ 0x03d4, "\317\205" },
+	{ 0x03d5, "\317\206" },
+	{ 0x03d6, "\317\200" },
+	{ 0x03d8, "\317\231" },
+	{ 0x03da, "\317\233" },
+	{ 0x03dc, "\317\235" },
+	{ 0x03de, "\317\237" },
+	{ 0x03e0, "\317\241" },
+	{ 0x03e2, "\317\243" },
+	{ 0x03e4, "\317\245" },
+	{ 0x03e6, "\317\247" },
+	{ 0x03e8, "\317\251" },
+	{ 0x03ea, "\317\253" },
+	{ 0x03ec, "\317\255" },
+	{ 0x03ee, "\317\257" },
+	{ 0x03f0, "\316\272" },
+	{ 0x03f1, "\317\201" },
+	{ 0x03f2, "\317\203" },
+	{ 0x03f4, "\316\270" },
+	{ 0x03f5, "\316\265" },
+	{ 0x03f6, " " },
+	{ 0x03f7, "\317\270" },
+	{ 0x03f9, "\317\203" },
+	{ 0x03fa, "\317\273" },
+	{ 0x03fd, "\315\273" },
+	{ 0x03fe, "\315\274" },
+	{ 0x03ff, "\315\275" },
+	{ 0x0400, "\321\220" },
+	{ 0x0401, "\321\221" },
+	{ 0x0402, "\321\222" },
+	{ 0x0403, "\321\223" },
+	{ 0x0404, "\321\224" },
+	{ 0x0405, "\321\225" },
+	{ 0x0406, "\321\226" },
+	{ 0x0407, "\321\227" },
+	{ 0x0408, "\321\230" },
+	{ 0x0409, "\321\231" },
+	{ 0x040a, "\321\232" },
+	{ 0x040b, "\321\233" },
+	{ 0x040c, "\321\234" },
+	{ 0x040d, "\321\235" },
+	{ 0x040e, "\321\236" },
+	{ 0x040f, "\321\237" },
+	{ 0x0410, "\320\260" },
+	{ 0x0411, "\320\261" },
+	{ 0x0412, "\320\262" },
+	{ 0x0413, "\320\263" },
+	{ 0x0414, "\320\264" },
+	{ 0x0415, "\320\265" },
+	{ 0x0416, "\320\266" },
+	{ 0x0417, "\320\267" },
+	{ 0x0418, "\320\270" },
+	{ 0x0419, "\320\271" },
+	{ 0x041a, "\320\272" },
+	{ 0x041b, "\320\273" },
+	{ 0x041c, "\320\274" },
+	{ 0x041d, "\320\275" },
+	{ 0x041e, "\320\276" },
+	{ 0x041f, "\320\277" },
+	{ 0x0420, "\321\200" },
+	{ 0x0421, "\321\201" },
+	{ 0x0422, "\321\202" },
+	{ 0x0423, "\321\203" },
+	{ 0x0424, "\321\204" },
+	{ 0x0425, "\321\205" },
+	{ 0x0426, "\321\206" },
+	{ 0x0427, "\321\207" },
+	{ 0x0428, "\321\210" },
+	{ 0x0429, "\321\211" },
+	{ 0x042a, "\321\212" },
+	{ 0x042b, "\321\213" },
+	{ 0x042c, "\321\214" },
+	{ 0x042d, "\321\215" },
+	{ 0x042e, "\321\216" },
+	{ 0x042f, "\321\217" },
+	{ 0x0460, "\321\241" },
+	{ 0x0462, "\321\243" },
+	{ 0x0464, "\321\245" },
+	{ 0x0466, "\321\247" },
+	{ 0x0468, "\321\251" },
+	{ 0x046a, "\321\253" },
+	{ 0x046c, "\321\255" },
+	{ 0x046e, "\321\257" },
+	{ 0x0470, "\321\261" },
+	{ 0x0472, "\321\263" },
+	{ 0x0474, "\321\265" },
+	{ 0x0476, "\321\267" },
+	{ 0x0478, "\321\271" },
+	{ 0x047a, "\321\273" },
+	{ 0x047c, "\321\275" },
+	{ 0x047e, "\321\277" },
+	{ 0x0480, "\322\201" },
+	{ 0x0482, " " },
+	{ 0x0483, "" },
+	{ 0x0484, "" },
+	{ 0x0485, "" },
+	{ 0x0486, "" },
+	{ 0x0487, "" },
+	{ 0x048a, "\322\213" },
+	{ 0x048c, "\322\215" },
+	{ 0x048e, "\322\217" },
+	{ 0x0490, "\322\221" },
+	{ 0x0492, "\322\223" },
+	{ 0x0494, "\322\225" },
+	{ 0x0496, "\322\227" },
+	{ 0x0498, "\322\231" },
+	{ 0x049a, "\322\233" },
+	{ 0x049c, "\322\235" },
+	{ 0x049e, "\322\237" },
+	{ 0x04a0, "\322\241" },
+	{ 0x04a2, "\322\243" },
+	{ 0x04a4, "\322\245" },
+	{ 0x04a6, "\322\247" },
+	{ 0x04a8, "\322\251" },
+	{ 0x04aa, "\322\253" },
+	{ 0x04ac, "\322\255" },
+	{ 0x04ae, "\322\257" },
+	{ 0x04b0, "\322\261" },
+	{ 0x04b2, "\322\263" },
+	{ 0x04b4, "\322\265" },
+	{ 0x04b6, "\322\267" },
+	{ 0x04b8, "\322\271" },
+	{ 0x04ba, "\322\273" },
+	{ 0x04bc, "\322\275" },
+	{ 0x04be, "\322\277" },
+	{ 0x04c0, "\323\217" },
+	{ 0x04c1, "\323\202" },
+	{ 0x04c3, "\323\204" },
+	{ 0x04c5, "\323\206" },
+	{ 0x04c7, "\323\210" },
+	{ 0x04c9, "\323\212" },
+	{ 0x04cb, "\323\214" },
+	{ 0x04cd, "\323\216" },
+	{ 0x04d0, "\323\221" },
+	{ 0x04d2, "\323\223" },
+	{ 0x04d4, "\323\225" },
+	{ 0x04d6, "\323\227" },
+	{ 0x04d8, "\323\231" },
+	{ 0x04da, "\323\233" },
+	{ 0x04dc, "\323\235" },
+	{ 0x04de, "\323\237" },
+	{ 0x04e0, "\323\241" },
+	{ 0x04e2, "\323\243" },
+	{ 0x04e4, "\323\245" },
+	{ 0x04e6, "\323\247" },
+	{ 0x04e8, "\323\251" },
+	{ 0x04ea, "\323\253" },
+	{ 0x04ec, "\323\255" },
+	{ 0x04ee, "\323\257" },
+	{ 0x04f0, "\323\261" },
+	{ 0x04f2, "\323\263" },
+	{ 0x04f4, "\323\265" },
+	{ 0x04f6, "\323\267" },
+	{ 0x04f8, "\323\271" },
+	{ 0x04fa, "\323\273" },
+	{ 0x04fc, "\323\275" },
+	{ 0x04fe, "\323\277" },
+	{ 0x0500, "\324\201" },
+	{ 0x0502, "\324\203" },
+	{ 0x0504, "\324\205" },
+	{ 0x0506, "\324\207" },
+	{ 0x0508, "\324\211" },
+	{ 0x050a, "\324\213" },
+	{ 0x050c, "\324\215" },
+	{ 0x050e, "\324\217" },
+	{ 0x0510, "\324\221" },
+	{ 0x0512, "\324\223" },
+	{ 0x0514, "\324\225" },
+	{ 0x0516, "\324\227" },
+	{ 0x0518, "\324\231" },
+	{ 0x051a, "\324\233" },
+	{ 0x051c, "\324\235" },
+	{ 0x051e, "\324\237" },
+	{ 0x0520, "\324\241" },
+	{ 0x0522, "\324\243" },
+	{ 0x0524, "\324\245" },
+	{ 0x0526, "\324\247" },
+	{ 0x0528, "\324\251" },
+	{ 0x052a, "\324\253" },
+	{ 0x052c, "\324\255" },
+	{ 0x052e, "\324\257" },
+	{ 0x0531, "\325\241" },
+	{ 0x0532, "\325\242" },
+	{ 0x0533, "\325\243" },
+	{ 0x0534, "\325\244" },
+	{ 0x0535, "\325\245" },
+	{ 0x0536, "\325\246" },
+	{ 0x0537, "\325\247" },
+	{ 0x0538, "\325\250" },
+	{ 0x0539, "\325\251" },
+	{ 0x053a, "\325\252" },
+	{ 0x053b, "\325\253" },
+	{ 0x053c, "\325\254" },
+	{ 0x053d, "\325\255" },
+	{ 0x053e, "\325\256" },
+	{ 0x053f, "\325\257" },
+	{ 0x0540, "\325\260" },
+	{ 0x0541, "\325\261" },
+	{ 0x0542, "\325\262" },
+	{ 0x0543, "\325\263" },
+	{ 0x0544, "\325\264" },
+	{ 0x0545, "\325\265" },
+	{ 0x0546, "\325\266" },
+	{ 0x0547, "\325\267" },
+	{ 0x0548, "\325\270" },
+	{ 0x0549, "\325\271" },
+	{ 0x054a, "\325\272" },
+	{ 0x054b, "\325\273" },
+	{ 0x054c, "\325\274" },
+	{ 0x054d, "\325\275" },
+	{ 0x054e, "\325\276" },
+	{ 0x054f, "\325\277" },
+	{ 0x0550, "\326\200" },
+	{ 0x0551, "\326\201" },
+	{ 0x0552, "\326\202" },
+	{ 0x0553, "\326\203" },
+	{ 0x0554, "\326\204" },
+	{ 0x0555, "\326\205" },
+	{ 0x0556, "\326\206" },
+	{ 0x055a, " " },
+	{ 0x055b, " " },
+	{ 0x055c, " " },
+	{ 0x055d, " " },
+	{ 0x055e, " " },
+	{ 0x055f, " " },
+	{ 0x0587, "\325\245\326\202" },
+	{ 0x0589, " " },
+	{ 0x058a, " " },
+	{ 0x058d, " " },
+	{ 0x058e, " " },
+	{ 0x058f, " " },
+	{ 0x0591, "" },
+	{ 0x0592, "" },
+	{ 0x0593, "" },
+	{ 0x0594, "" },
+	{ 0x0595, "" },
+	{ 0x0596, "" },
+	{ 0x0597, "" },
+	{ 0x0598, "" },
+	{ 0x0599, "" },
+	{ 0x059a, "" },
+	{ 0x059b, "" },
+	{ 0x059c, "" },
+	{ 0x059d, "" },
+	{ 0x059e, "" },
+	{ 0x059f, "" },
+	{ 0x05a0, "" },
+	{ 0x05a1, "" },
+	{ 0x05a2, "" },
+	{ 0x05a3, "" },
+	{ 0x05a4, "" },
+	{ 0x05a5, "" },
+	{ 0x05a6, "" },
+	{ 0x05a7, "" },
+	{ 0x05a8, "" },
+	{ 0x05a9, "" },
+	{ 0x05aa, "" },
+	{ 0x05ab, "" },
+	{ 0x05ac, "" },
+	{ 0x05ad, "" },
+	{ 0x05ae, "" },
+	{ 0x05af, "" },
+	{ 0x05b0, "" },
+	{ 0x05b1, "" },
+	{ 0x05b2, "" },
+	{ 0x05b3, "" },
+	{ 0x05b4, "" },
+	{ 0x05b5, "" },
+	{ 0x05b6, "" },
+	{ 0x05b7, "" },
+	{ 0x05b8, "" },
+	{ 0x05b9, "" },
+	{ 0x05ba, "" },
+	{ 0x05bb, "" },
+	{ 0x05bc, "" },
+	{ 0x05bd, "" },
+	{ 0x05be, " " },
+	{ 0x05bf, "" },
+	{ 0x05c0, " " },
+	{ 0x05c1, "" },
+	{ 0x05c2, "" },
+	{ 0x05c3, " " },
+	{ 0x05c4, "" },
+	{ 0x05c5, "" },
+	{ 0x05c6, " " },
+	{ 0x05c7, "" },
+	{ 0x05f3, " " },
+	{ 0x05f4, " " },
+	{ 0x1e00, "a" },
+	{ 0x1e01, "a" },
+	{ 0x1e02, "b" },
+	{ 0x1e03, "b" },
+	{ 0x1e04, "b" },
+	{ 0x1e05, "b" },
+	{ 0x1e06, "b" },
+	{ 0x1e07, "b" },
+	{ 0x1e08, "c" },
+	{ 0x1e09, "c" },
+	{ 0x1e0a, "d" },
+	{ 0x1e0b, "d" },
+	{ 0x1e0c, "d" },
+	{ 0x1e0d, "d" },
+	{ 0x1e0e, "d" },
+	{ 0x1e0f, "d" },
+	{ 0x1e10, "d" },
+	{ 0x1e11, "d" },
+	{ 0x1e12, "d" },
+	{ 0x1e13, "d" },
+	{ 0x1e14, "e" },
+	{ 0x1e15, "e" },
+	{ 0x1e16, "e" },
+	{ 0x1e17, "e" },
+	{ 0x1e18, "e" },
+	{ 0x1e19, "e" },
+	{ 0x1e1a, "e" },
+	{ 0x1e1b, "e" },
+	{ 0x1e1c, "e" },
+	{ 0x1e1d, "e" },
+	{ 0x1e1e, "f" },
+	{ 0x1e1f, "f" },
+	{ 0x1e20, "g" },
+	{ 0x1e21, "g" },
+	{ 0x1e22, "h" },
+	{ 0x1e23, "h" },
+	{ 0x1e24, "h" },
+	{ 0x1e25, "h" },
+	{ 0x1e26, "h" },
+	{ 0x1e27, "h" },
+	{ 0x1e28, "h" },
+	{ 0x1e29, "h" },
+	{ 0x1e2a, "h" },
+	{ 0x1e2b, "h" },
+	{ 0x1e2c, "i" },
+	{ 0x1e2d, "i" },
+	{ 0x1e2e, "i" },
+	{ 0x1e2f, "i" },
+	{ 0x1e30, "k" },
+	{ 0x1e31, "k" },
+	{ 0x1e32, "k" },
+	{ 0x1e33, "k" },
+	{ 0x1e34, "k" },
+	{ 0x1e35, "k" },
+	{ 0x1e36, "l" },
+	{ 0x1e37, "l" },
+	{ 0x1e38, "l" },
+	{ 0x1e39, "l" },
+	{ 0x1e3a, "l" },
+	{ 0x1e3b, "l" },
+	{ 0x1e3c, "l" },
+	{ 0x1e3d, "l" },
+	{ 0x1e3e, "m" },
+	{ 0x1e3f, "m" },
+	{ 0x1e40, "m" },
+	{ 0x1e41, "m" },
+	{ 0x1e42, "m" },
+	{ 0x1e43, "m" },
+	{ 0x1e44, "n" },
+	{ 0x1e45, "n" },
+	{ 0x1e46, "n" },
+	{ 0x1e47, "n" },
+	{ 0x1e48, "n" },
+	{ 0x1e49, "n" },
+	{ 0x1e4a, "n" },
+	{ 0x1e4b, "n" },
+	{ 0x1e4c, "o" },
+	{ 0x1e4d, "o" },
+	{ 0x1e4e, "o" },
+	{ 0x1e4f, "o" },
+	{ 0x1e50, "o" },
+	{ 0x1e51, "o" },
+	{ 0x1e52, "o" },
+	{ 0x1e53, "o" },
+	{ 0x1e54, "p" },
+	{ 0x1e55, "p" },
+	{ 0x1e56, "p" },
+	{ 0x1e57, "p" },
+	{ 0x1e58, "r" },
+	{ 0x1e59, "r" },
+	{ 0x1e5a, "r" },
+	{ 0x1e5b, "r" },
+	{ 0x1e5c, "r" },
+	{ 0x1e5d, "r" },
+	{ 0x1e5e, "r" },
+	{ 0x1e5f, "r" },
+	{ 0x1e60, "s" },
+	{ 0x1e61, "s" },
+	{ 0x1e62, "s" },
+	{ 0x1e63, "s" },
+	{ 0x1e64, "s" },
+	{ 0x1e65, "s" },
+	{ 0x1e66, "s" },
+	{ 0x1e67, "s" },
+	{ 0x1e68, "s" },
+	{ 0x1e69, "s" },
+	{ 0x1e6a, "t" },
+	{ 0x1e6b, "t" },
+	{ 0x1e6c, "t" },
+	{ 0x1e6d, "t" },
+	{ 0x1e6e, "t" },
+	{ 0x1e6f, "t" },
+	{ 0x1e70, "t" },
+	{ 0x1e71, "t" },
+	{ 0x1e72, "u" },
+	{ 0x1e73, "u" },
+	{ 0x1e74, "u" },
+	{ 0x1e75, "u" },
+	{ 0x1e76, "u" },
+	{ 0x1e77, "u" },
+	{ 0x1e78, "u" },
+	{ 0x1e79, "u" },
+	{ 0x1e7a, "u" },
+	{ 0x1e7b, "u" },
+	{ 0x1e7c, "v" },
+	{ 0x1e7d, "v" },
+	{ 0x1e7e, "v" },
+	{ 0x1e7f, "v" },
+	{ 0x1e80, "w" },
+	{ 0x1e81, "w" },
+	{ 0x1e82, "w" },
+	{ 0x1e83, "w" },
+	{ 0x1e84, "w" },
+	{ 0x1e85, "w" },
+	{ 0x1e86, "w" },
+	{ 0x1e87, "w" },
+	{ 0x1e88, "w" },
+	{ 0x1e89, "w" },
+	{ 0x1e8a, "x" },
+	{ 0x1e8b, "x" },
+	{ 0x1e8c, "x" },
+	{ 0x1e8d, "x" },
+	{ 0x1e8e, "y" },
+	{ 0x1e8f, "y" },
+	{ 0x1e90, "z" },
+	{ 0x1e91, "z" },
+	{ 0x1e92, "z" },
+	{ 0x1e93, "z" },
+	{ 0x1e94, "z" },
+	{ 0x1e95, "z" },
+	{ 0x1e96, "h" },
+	{ 0x1e97, "t" },
+	{ 0x1e98, "w" },
+	{ 0x1e99, "y" },
+	{ 0x1e9a, "a\312\276" },
+	{ 0x1e9b, "s" },
+	{ 0x1e9e, "ss" },
+	{ 0x1ea0, "a" },
+	{ 0x1ea1, "a" },
+	{ 0x1ea2, "a" },
+	{ 0x1ea3, "a" },
+	{ 0x1ea4, "a" },
+	{ 0x1ea5, "a" },
+	{ 0x1ea6, "a" },
+	{ 0x1ea7, "a" },
+	{ 0x1ea8, "a" },
+	{ 0x1ea9, "a" },
+	{ 0x1eaa, "a" },
+	{ 0x1eab, "a" },
+	{ 0x1eac, "a" },
+	{ 0x1ead, "a" },
+	{ 0x1eae, "a" },
+	{ 0x1eaf, "a" },
+	{ 0x1eb0, "a" },
+	{ 0x1eb1, "a" },
+	{ 0x1eb2, "a" },
+	{ 0x1eb3, "a" },
+	{ 0x1eb4, "a" },
+	{ 0x1eb5, "a" },
+	{ 0x1eb6, "a" },
+	{ 0x1eb7, "a" },
+	{ 0x1eb8, "e" },
+	{ 0x1eb9, "e" },
+	{ 0x1eba, "e" },
+	{ 0x1ebb, "e" },
+	{ 0x1ebc, "e" },
+	{ 0x1ebd, "e" },
+	{ 0x1ebe, "e" },
+	{ 0x1ebf, "e" },
+	{ 0x1ec0, "e" },
+	{ 0x1ec1, "e" },
+	{ 0x1ec2, "e" },
+	{ 0x1ec3, "e" },
+	{ 0x1ec4, "e" },
+	{ 0x1ec5, "e" },
+	{ 0x1ec6, "e" },
+	{ 0x1ec7, "e" },
+	{ 0x1ec8, "i" },
+	{ 0x1ec9, "i" },
+	{ 0x1eca, "i" },
+	{ 0x1ecb, "i" },
+	{ 0x1ecc, "o" },
+	{ 0x1ecd, "o" },
+	{ 0x1ece, "o" },
+	{ 0x1ecf, "o" },
+	{ 0x1ed0, "o" },
+	{ 0x1ed1, "o" },
+	{ 0x1ed2, "o" },
+	{ 0x1ed3, "o" },
+	{ 0x1ed4, "o" },
+	{ 0x1ed5, "o" },
+	{ 0x1ed6, "o" },
+	{ 0x1ed7, "o" },
+	{ 0x1ed8, "o" },
+	{ 0x1ed9, "o" },
+	{ 0x1eda, "o" },
+	{ 0x1edb, "o" },
+	{ 0x1edc, "o" },
+	{ 0x1edd, "o" },
+	{ 0x1ede, "o" },
+	{ 0x1edf, "o" },
+	{ 0x1ee0, "o" },
+	{ 0x1ee1, "o" },
+	{ 0x1ee2, "o" },
+	{ 0x1ee3, "o" },
+	{ 0x1ee4, "u" },
+	{ 0x1ee5, "u" },
+	{ 0x1ee6, "u" },
+	{ 0x1ee7, "u" },
+	{ 0x1ee8, "u" },
+	{ 0x1ee9, "u" },
+	{ 0x1eea, "u" },
+	{ 0x1eeb, "u" },
+	{ 0x1eec, "u" },
+	{ 0x1eed, "u" },
+	{ 0x1eee, "u" },
+	{ 0x1eef, "u" },
+	{ 0x1ef0, "u" },
+	{ 0x1ef1, "u" },
+	{ 0x1ef2, "y" },
+	{ 0x1ef3, "y" },
+	{ 0x1ef4, "y" },
+	{ 0x1ef5, "y" },
+	{ 0x1ef6, "y" },
+	{ 0x1ef7, "y" },
+	{ 0x1ef8, "y" },
+	{ 0x1ef9, "y" },
+	{ 0x1efa, "\341\273\273" },
+	{ 0x1efc, "\341\273\275" },
+	{ 0x1efe, "\341\273\277" },
+	{ 0x1f00, "\316\261" },
+	{ 0x1f01, "\316\261" },
+	{ 0x1f02, "\316\261" },
+	{ 0x1f03, "\316\261" },
+	{ 0x1f04, "\316\261" },
+	{ 0x1f05, "\316\261" },
+	{ 0x1f06, "\316\261" },
+	{ 0x1f07, "\316\261" },
+	{ 0x1f08, "\316\261" },
+	{ 0x1f09, "\316\261" },
+	{ 0x1f0a, "\316\261" },
+	{ 0x1f0b, "\316\261" },
+	{ 0x1f0c, "\316\261" },
+	{ 0x1f0d, "\316\261" },
+	{ 0x1f0e, "\316\261" },
+	{ 0x1f0f, "\316\261" },
+	{ 0x1f10, "\316\265" },
+	{ 0x1f11, "\316\265" },
+	{ 0x1f12, "\316\265" },
+	{ 0x1f13, "\316\265" },
+	{ 0x1f14, "\316\265" },
+	{ 0x1f15, "\316\265" },
+	{ 0x1f18, "\316\265" },
+	{ 0x1f19, "\316\265" },
+	{ 0x1f1a, "\316\265" },
+	{ 0x1f1b, "\316\265" },
+	{ 0x1f1c, "\316\265" },
+	{ 0x1f1d, "\316\265" },
+	{ 0x1f20, "\316\267" },
+	{ 0x1f21, "\316\267" },
+	{ 0x1f22, "\316\267" },
+	{ 0x1f23, "\316\267" },
+	{ 0x1f24, "\316\267" },
+	{ 0x1f25, "\316\267" },
+	{ 0x1f26, "\316\267" },
+	{ 0x1f27, "\316\267" },
+	{ 0x1f28, "\316\267" },
+	{ 0x1f29, "\316\267" },
+	{ 0x1f2a, "\316\267" },
+	{ 0x1f2b, "\316\267" },
+	{ 0x1f2c, "\316\267" },
+	{ 0x1f2d, "\316\267" },
+	{ 0x1f2e, "\316\267" },
+	{ 0x1f2f, "\316\267" },
+	{ 0x1f30, "\316\271" },
+	{ 0x1f31, "\316\271" },
+	{ 0x1f32, "\316\271" },
+	{ 0x1f33, "\316\271" },
+	{ 0x1f34, "\316\271" },
+	{ 0x1f35, "\316\271" },
+	{ 0x1f36, "\316\271" },
+	{ 0x1f37, "\316\271" },
+	{ 0x1f38, "\316\271" },
+	{ 0x1f39, "\316\271" },
+	{ 0x1f3a, "\316\271" },
+	{ 0x1f3b, "\316\271" },
+	{ 0x1f3c, "\316\271" },
+	{ 0x1f3d, "\316\271" },
+	{ 0x1f3e, "\316\271" },
+	{ 0x1f3f, "\316\271" },
+	{ 0x1f40, "\316\277" },
+	{ 0x1f41, "\316\277" },
+	{ 0x1f42, "\316\277" },
+	{ 0x1f43, "\316\277" },
+	{ 0x1f44, "\316\277" },
+	{ 0x1f45, "\316\277" },
+	{ 0x1f48, "\316\277" },
+	{ 0x1f49, "\316\277" },
+	{ 0x1f4a, "\316\277" },
+	{ 0x1f4b, "\316\277" },
+	{ 0x1f4c, "\316\277" },
+	{ 0x1f4d, "\316\277" },
+	{ 0x1f50, "\317\205" },
+	{ 0x1f51, "\317\205" },
+	{ 0x1f52, "\317\205" },
+	{ 0x1f53, "\317\205" },
+	{ 0x1f54, "\317\205" },
+	{ 0x1f55, "\317\205" },
+	{ 0x1f56, "\317\205" },
+	{ 0x1f57, "\317\205" },
+	{ 0x1f59, "\317\205" },
+	{ 0x1f5b, "\317\205" },
+	{ 0x1f5d, "\317\205" },
+	{ 0x1f5f, "\317\205" },
+	{ 0x1f60, "\317\211" },
+	{ 0x1f61, "\317\211" },
+	{ 0x1f62, "\317\211" },
+	{ 0x1f63, "\317\211" },
+	{ 0x1f64, "\317\211" },
+	{ 0x1f65, "\317\211" },
+	{ 0x1f66, "\317\211" },
+	{ 0x1f67, "\317\211" },
+	{ 0x1f68, "\317\211" },
+	{ 0x1f69, "\317\211" },
+	{ 0x1f6a, "\317\211" },
+	{ 0x1f6b, "\317\211" },
+	{ 0x1f6c, "\317\211" },
+	{ 0x1f6d, "\317\211" },
+	{ 0x1f6e, "\317\211" },
+	{ 0x1f6f, "\317\211" },
+	{ 0x1f70, "\316\261" },
+	{ 0x1f71, "\316\261" },
+	{ 0x1f72, "\316\265" },
+	{ 0x1f73, "\316\265" },
+	{ 0x1f74, "\316\267" },
+	{ 0x1f75, "\316\267" },
+	{ 0x1f76, "\316\271" },
+	{ 0x1f77, "\316\271" },
+	{ 0x1f78, "\316\277" },
+	{ 0x1f79, "\316\277" },
+	{ 0x1f7a, "\317\205" },
+	{ 0x1f7b, "\317\205" },
+	{ 0x1f7c, "\317\211" },
+	{ 0x1f7d, "\317\211" },
+	{ 0x1f80, "\316\261\316\271" },
+	{ 0x1f81, "\316\261\316\271" },
+	{ 0x1f82, "\316\261\316\271" },
+	{ 0x1f83, "\316\261\316\271" },
+	{ 0x1f84, "\316\261\316\271" },
+	{ 0x1f85, "\316\261\316\271" },
+	{ 0x1f86, "\316\261\316\271" },
+	{ 0x1f87, "\316\261\316\271" },
+	{ 0x1f88, "\316\261\316\271" },
+	{ 0x1f89, "\316\261\316\271" },
+	{ 0x1f8a, "\316\261\316\271" },
+	{ 0x1f8b, "\316\261\316\271" },
+	{ 0x1f8c, "\316\261\316\271" },
+	{ 0x1f8d, "\316\261\316\271" },
+	{ 0x1f8e, "\316\261\316\271" },
+	{ 0x1f8f, "\316\261\316\271" },
+	{ 0x1f90, "\316\267\316\271" },
+	{ 0x1f91, "\316\267\316\271" },
+	{ 0x1f92, "\316\267\316\271" },
+	{ 0x1f93, "\316\267\316\271" },
+	{ 0x1f94, "\316\267\316\271" },
+	{ 0x1f95, "\316\267\316\271" },
+	{ 0x1f96, "\316\267\316\271" },
+	{ 0x1f97, "\316\267\316\271" },
+	{ 0x1f98, "\316\267\316\271" },
+	{ 0x1f99, "\316\267\316\271" },
+	{ 0x1f9a, "\316\267\316\271" },
+	{ 0x1f9b, "\316\267\316\271" },
+	{ 0x1f9c, "\316\267\316\271" },
+	{ 0x1f9d, "\316\267\316\271" },
+	{ 0x1f9e, "\316\267\316\271" },
+	{ 0x1f9f, "\316\267\316\271" },
+	{ 0x1fa0, "\317\211\316\271" },
+	{ 0x1fa1, "\317\211\316\271" },
+	{ 0x1fa2, "\317\211\316\271" },
+	{ 0x1fa3, "\317\211\316\271" },
+	{ 0x1fa4, "\317\211\316\271" },
+	{ 0x1fa5, "\317\211\316\271" },
+	{ 0x1fa6, "\317\211\316\271" },
+	{ 0x1fa7, "\317\211\316\271" },
+	{ 0x1fa8, "\317\211\316\271" },
+	{ 0x1fa9, "\317\211\316\271" },
+	{ 0x1faa, "\317\211\316\271" },
+	{ 0x1fab, "\317\211\316\271" },
+	{ 0x1fac, "\317\211\316\271" },
+	{ 0x1fad, "\317\211\316\271" },
+	{ 0x1fae, "\317\211\316\271" },
+	{ 0x1faf, "\317\211\316\271" },
+	{ 0x1fb0, "\316\261" },
+	{ 0x1fb1, "\316\261" },
+	{ 0x1fb2, "\316\261\316\271" },
+	{ 0x1fb3, "\316\261\316\271" },
+	{ 0x1fb4, "\316\261\316\271" },
+	{ 0x1fb6, "\316\261" },
+	{ 0x1fb7, "\316\261\316\271" },
+	{ 0x1fb8, "\316\261" },
+	{ 0x1fb9, "\316\261" },
+	{ 0x1fba, "\316\261" },
+	{ 0x1fbb, "\316\261" },
+	{ 0x1fbc, "\316\261\316\271" },
+	{ 0x1fbd, " " },
+	{ 0x1fbe, "\316\271" },
+	{ 0x1fbf, " " },
+	{ 0x1fc0, " " },
+	{ 0x1fc1, " " },
+	{ 0x1fc2, "\316\267\316\271" },
+	{ 0x1fc3, "\316\267\316\271" },
+	{ 0x1fc4, "\316\267\316\271" },
+	{ 0x1fc6, "\316\267" },
+	{ 0x1fc7, "\316\267\316\271" },
+	{ 0x1fc8, "\316\265" },
+	{ 0x1fc9, "\316\265" },
+	{ 0x1fca, "\316\267" },
+	{ 0x1fcb, "\316\267" },
+	{ 0x1fcc, "\316\267\316\271" },
+	{ 0x1fcd, " " },
+	{ 0x1fce, " " },
+	{ 0x1fcf, " " },
+	{ 0x1fd0, "\316\271" },
+	{ 0x1fd1, "\316\271" },
+	{ 0x1fd2, "\316\271" },
+	{ 0x1fd3, "\316\271" },
+	{ 0x1fd6, "\316\271" },
+	{ 0x1fd7, "\316\271" },
+	{ 0x1fd8, "\316\271" },
+	{ 0x1fd9, "\316\271" },
+	{ 0x1fda, "\316\271" },
+	{ 0x1fdb, "\316\271" },
+	{ 0x1fdd, " " },
+	{ 0x1fde, " " },
+	{ 0x1fdf, " " },
+	{ 0x1fe0, "\317\205" },
+	{ 0x1fe1, "\317\205" },
+	{ 0x1fe2, "\317\205" },
+	{ 0x1fe3, "\317\205" },
+	{ 0x1fe4, "\317\201" },
+	{ 0x1fe5, "\317\201" },
+	{ 0x1fe6, "\317\205" },
+	{ 0x1fe7, "\317\205" },
+	{ 0x1fe8, "\317\205" },
+	{ 0x1fe9, "\317\205" },
+	{ 0x1fea, "\317\205" },
+	{ 0x1feb, "\317\205" },
+	{ 0x1fec, "\317\201" },
+	{ 0x1fed, " " },
+	{ 0x1fee, " " },
+	{ 0x1fef, " " },
+	{ 0x1ff2, "\317\211\316\271" },
+	{ 0x1ff3, "\317\211\316\271" },
+	{ 0x1ff4, "\317\211\316\271" },
+	{ 0x1ff6, "\317\211" },
+	{ 0x1ff7, "\317\211\316\271" },
+	{ 0x1ff8, "\316\277" },
+	{ 0x1ff9, "\316\277" },
+	{ 0x1ffa, "\317\211" },
+	{ 0x1ffb, "\317\211" },
+	{ 0x1ffc, "\317\211\316\271" },
+	{ 0x1ffd, " " },
+	{ 0x1ffe, " " },
+	{ 0x2000, " " },
+	{ 0x2001, " " },
+	{ 0x2002, " " },
+	{ 0x2003, " " },
+	{ 0x2004, " " },
+	{ 0x2005, " " },
+	{ 0x2006, " " },
+	{ 0x2007, " " },
+	{ 0x2008, " " },
+	{ 0x2009, " " },
+	{ 0x200a, " " },
+	{ 0x2010, " " },
+	{ 0x2011, " " },
+	{ 0x2012, " " },
+	{ 0x2013, " " },
+	{ 0x2014, " " },
+	{ 0x2015, " " },
+	{ 0x2016, " " },
+	{ 0x2017, " " },
+	{ 0x2018, " " },
+	{ 0x2019, " " },
+	{ 0x201a, " " },
+	{ 0x201b, " " },
+	{ 0x201c, " " },
+	{ 0x201d, " " },
+	{ 0x201e, " " },
+	{ 0x201f, " " },
+	{ 0x2020, " " },
+	{ 0x2021, " " },
+	{ 0x2022, " " },
+	{ 0x2023, " " },
+	{ 0x2024, " " },
+	{ 0x2025, " " },
+	{ 0x2026, " " },
+	{ 0x2027, " " },
+	{ 0x2028, " " },
+	{ 0x2029, " " },
+	{ 0x202f, " " },
+	{ 0x2030, " " },
+	{ 0x2031, " " },
+	{ 0x2032, " " },
+	{ 0x2033, " " },
+	{ 0x2034, " " },
+	{ 0x2035, " " },
+	{ 0x2036, " " },
+	{ 0x2037, " " },
+	{ 0x2038, " " },
+	{ 0x2039, " " },
+	{ 0x203a, " " },
+	{ 0x203b, " " },
+	{ 0x203c, " " },
+	{ 0x203d, " " },
+	{ 0x203e, " " },
+	{ 0x203f, " " },
+	{ 0x2040, " " },
+	{ 0x2041, " " },
+	{ 0x2042, " " },
+	{ 0x2043, " " },
+	{ 0x2044, " " },
+	{ 0x2045, " " },
+	{ 0x2046, " " },
+	{ 0x2047, " " },
+	{ 0x2048, " " },
+	{ 0x2049, " " },
+	{ 0x204a, " " },
+	{ 0x204b, " " },
+	{ 0x204c, " " },
+	{ 0x204d, " " },
+	{ 0x204e, " " },
+	{ 0x204f, " " },
+	{ 0x2050, " " },
+	{ 0x2051, " " },
+	{ 0x2052, " " },
+	{ 0x2053, " " },
+	{ 0x2054, " " },
+	{ 0x2055, " " },
+	{ 0x2056, " " },
+	{ 0x2057, " " },
+	{ 0x2058, " " },
+	{ 0x2059, " " },
+	{ 0x205a, " " },
+	{ 0x205b, " " },
+	{ 0x205c, " " },
+	{ 0x205d, " " },
+	{ 0x205e, " " },
+	{ 0x205f, " " },
+	{ 0x2070, "0" },
+	{ 0x2071, "i" },
+	{ 0x2074, "4" },
+	{ 0x2075, "5" },
+	{ 0x2076, "6" },
+	{ 0x2077, "7" },
+	{ 0x2078, "8" },
+	{ 0x2079, "9" },
+	{ 0x207a, " " },
+	{ 0x207b, " " },
+	{ 0x207c, " " },
+	{ 0x207d, " " },
+	{ 0x207e, " " },
+	{ 0x207f, "n" },
+	{ 0x2080, "0" },
+	{ 0x2081, "1" },
+	{ 0x2082, "2" },
+	{ 0x2083, "3" },
+	{ 0x2084, "4" },
+	{ 0x2085, "5" },
+	{ 0x2086, "6" },
+	{ 0x2087, "7" },
+	{ 0x2088, "8" },
+	{ 0x2089, "9" },
+	{ 0x208a, " " },
+	{ 0x208b, " " },
+	{ 0x208c, " " },
+	{ 0x208d, " " },
+	{ 0x208e, " " },
+	{ 0x2090, "a" },
+	{ 0x2091, "e" },
+	{ 0x2092, "o" },
+	{ 0x2093, "x" },
+	{ 0x2094, "\311\231" },
+	{ 0x2095, "h" },
+	{ 0x2096, "k" },
+	{ 0x2097, "l" },
+	{ 0x2098, "m" },
+	{ 0x2099, "n" },
+	{ 0x209a, "p" },
+	{ 0x209b, "s" },
+	{ 0x209c, "t" },
+	{ 0xfb00, "ff" },
+	{ 0xfb01, "fi" },
+	{ 0xfb02, "fl" },
+	{ 0xfb03, "ffi" },
+	{ 0xfb04, "ffl" },
+	{ 0xfb05, "st" },
+	{ 0xfb06, "st" },
+	{ 0xff01, " " },
+	{ 0xff02, " " },
+	{ 0xff03, " " },
+	{ 0xff04, " " },
+	{ 0xff05, " " },
+	{ 0xff06, " " },
+	{ 0xff07, " " },
+	{ 0xff08, " " },
+	{ 0xff09, " " },
+	{ 0xff0a, " " },
+	{ 0xff0b, " " },
+	{ 0xff0c, " " },
+	{ 0xff0d, " " },
+	{ 0xff0e, " " },
+	{ 0xff0f, " " },
+	{ 0xff10, "0" },
+	{ 0xff11, "1" },
+	{ 0xff12, "2" },
+	{ 0xff13, "3" },
+	{ 0xff14, "4" },
+	{ 0xff15, "5" },
+	{ 0xff16, "6" },
+	{ 0xff17, "7" },
+	{ 0xff18, "8" },
+	{ 0xff19, "9" },
+	{ 0xff1a, " " },
+	{ 0xff1b, " " },
+	{ 0xff1c, " " },
+	{ 0xff1d, " " },
+	{ 0xff1e, " " },
+	{ 0xff1f, " " },
+	{ 0xff20, " " },
+	{ 0xff21, "a" },
+	{ 0xff22, "b" },
+	{ 0xff23, "c" },
+	{ 0xff24, "d" },
+	{ 0xff25, "e" },
+	{ 0xff26, "f" },
+	{ 0xff27, "g" },
+	{ 0xff28, "h" },
+	{ 0xff29, "i" },
+	{ 0xff2a, "j" },
+	{ 0xff2b, "k" },
+	{ 0xff2c, "l" },
+	{ 0xff2d, "m" },
+	{ 0xff2e, "n" },
+	{ 0xff2f, "o" },
+	{ 0xff30, "p" },
+	{ 0xff31, "q" },
+	{ 0xff32, "r" },
+	{ 0xff33, "s" },
+	{ 0xff34, "t" },
+	{ 0xff35, "u" },
+	{ 0xff36, "v" },
+	{ 0xff37, "w" },
+	{ 0xff38, "x" },
+	{ 0xff39, "y" },
+	{ 0xff3a, "z" },
+	{ 0xff3b, " " },
+	{ 0xff3c, " " },
+	{ 0xff3d, " " },
+	{ 0xff3e, " " },
+	{ 0xff3f, " " },
+	{ 0xff40, " " },
+	{ 0xff41, "a" },
+	{ 0xff42, "b" },
+	{ 0xff43, "c" },
+	{ 0xff44, "d" },
+	{ 0xff45, "e" },
+	{ 0xff46, "f" },
+	{ 0xff47, "g" },
+	{ 0xff48, "h" },
+	{ 0xff49, "i" },
+	{ 0xff4a, "j" },
+	{ 0xff4b, "k" },
+	{ 0xff4c, "l" },
+	{ 0xff4d, "m" },
+	{ 0xff4e, "n" },
+	{ 0xff4f, "o" },
+	{ 0xff50, "p" },
+	{ 0xff51, "q" },
+	{ 0xff52, "r" },
+	{ 0xff53, "s" },
+	{ 0xff54, "t" },
+	{ 0xff55, "u" },
+	{ 0xff56, "v" },
+	{ 0xff57, "w" },
+	{ 0xff58, "x" },
+	{ 0xff59, "y" },
+	{ 0xff5a, "z" },
+	{ 0xff5b, " " },
+	{ 0xff5c, " " },
+	{ 0xff5d, " " },
+	{ 0xff5e, " " },
+};
+
+static const size_t g_fold_table_size = sizeof(g_fold_table)/sizeof(g_fold_table[0]);
+
+/// Decode the UTF-8 character at 'p'. Returns its length, or 0 if it isn't
+/// valid.
+static size_t decode_utf8(const unsigned char *p, const size_t n, uint32_t &cp) {
+	const unsigned char c = p[0];
+	size_t len;
+	if (c < 0x80) {
+		cp = c;
+		return 1;
+	} else if (c >= 0xc2 && c < 0xe0) {
+		len = 2;
+		cp = c & 0x1f;
+	} else if (c >= 0xe0 && c < 0xf0) {
+		len = 3;
+		cp = c & 0x0f;
+	} else if (c >= 0xf0 && c < 0xf5) {
+		len = 4;
+		cp = c & 0x07;
+	} else {
+		return 0;
+	}
+	if (len > n) {
+		return 0;
+	}
+	for (size_t i=1; i<len; ++i) {
+		if ((p[i] & 0xc0) != 0x80) {
+			return 0;
+		}
+		cp = (cp << 6) | (p[i] & 0x3f);
+	}
+	return len;
+}
+
+void fold_key(const std::string &name, std::string &out) {
+	out.clear();
+	out.reserve(name.size());
+
+	// a space is only added before the next character, so there are
+	// none at the end
+	bool space = false;
+	const auto append = [&out, &space](const char *s, const size_t n) {
+		for (size_t i=0; i<n; ++i) {
+			if (s[i] == ' ') {
+				space = !out.empty();
+				continue;
+			}
+			if (space) {
+				out += ' ';
+				space = false;
+			}
+			out += s[i];
+		}
+	};
+
+	const unsigned char * const s = (const unsigned char*)name.data();
+	const size_t size = name.size();
+	for (size_t i=0; i<size; ) {
+		const unsigned char c = s[i];
+		if (c < 0x80) {
+			char a = c;
+			if (c >= 'A' && c <= 'Z') {
+				a = c-'A'+'a';
+			} else if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))) {
+				a = ' ';
+			}
+			append(&a, 1);
+			++i;
+			continue;
+		}
+
+		uint32_t cp;
+		const size_t n = decode_utf8(s+i, size-i, cp);
+		if (!n) {
+			// not UTF-8, keep the byte
+			append((const char*)s+i, 1);
+			++i;
+			continue;
+		}
+
+		const FoldEntry * const end = g_fold_table + g_fold_table_size;
+		const FoldEntry * const f = std::lower_bound(g_fold_table, end, cp,
+			[](const FoldEntry &e, const uint32_t cp) {
+				return e.cp < cp;
+			});
+		if (f != end && f->cp == cp) {
+			const char * const folded = f->folded;
+			size_t len = 0;
+			while (folded[len]) {
+				++len;
+			}
+			append(folded, len);
+		} else {
+			append((const char*)s+i, n);
+		}
+		i += n;
+	}
+}
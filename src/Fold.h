@@ -0,0 +1,16 @@
+#ifndef INCLUDED_FOLD_H
+#define INCLUDED_FOLD_H
+
+#include <string>
+
+/// The key of 'name' for lookups which ignore case, accents and
+/// punctuation, so "CAFÉ", "cafe" and "café" have the same folded key, as
+/// do "dog-and-bone" and "dog and bone".
+///
+/// Characters are decomposed (NFKD), diacritics removed and the case
+/// folded, for the Latin, Greek and Cyrillic scripts and fullwidth forms.
+/// Runs of punctuation, symbols and spaces become one space, and there are
+/// none at the start or end. Other characters are kept as they are.
+void fold_key(const std::string &name, std::string &out);
+
+#endif
@@ -0,0 +1,1029 @@
+#include "FullText.h"
+#include "Fold.h"
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
+
+using namespace fulltext_file;
+using index_file::Header;
+using index_file::SectionHeader;
+using index_file::Section;
+
+static const unsigned char g_fulltext_version = 2;
+
+/// Longer words are skipped, they're not words anyone searches for
+static const size_t g_max_word_size = 64;
+
+/// BM25 parameters
+static const double g_bm25_k1 = 1.2;
+static const double g_bm25_b = 0.75;
+
+// tokenizing
+
+static void append_utf8(const uint32_t cp, std::string &out) {
+	if (cp < 0x80) {
+		out += char(cp);
+	} else if (cp < 0x800) {
+		out += char(0xc0 | (cp >> 6));
+		out += char(0x80 | (cp & 0x3f));
+	} else if (cp < 0x10000) {
+		out += char(0xe0 | (cp >> 12));
+		out += char(0x80 | ((cp >> 6) & 0x3f));
+		out += char(0x80 | (cp & 0x3f));
+	} else if (cp < 0x110000) {
+		out += char(0xf0 | (cp >> 18));
+		out += char(0x80 | ((cp >> 12) & 0x3f));
+		out += char(0x80 | ((cp >> 6) & 0x3f));
+		out += char(0x80 | (cp & 0x3f));
+	}
+}
+
+/// Bytes in the UTF-8 sequence that starts with 'c'
+static inline size_t utf8_length(const unsigned char c) {
+	if (c < 0xc0) {
+		return 1;
+	} else if (c < 0xe0) {
+		return 2;
+	} else if (c < 0xf0) {
+		return 3;
+	} else if (c < 0xf8) {
+		return 4;
+	}
+	return 1;
+}
+
+/// Non-ASCII characters which separate words: no-break space, guillemets,
+/// middle dot, and the general punctuation block, e.g. dashes and curly
+/// quotes
+static inline bool is_utf8_separator(const unsigned char *p, const size_t n) {
+	if (n == 2 && p[0] == 0xc2) {
+		return p[1] == 0xa0 || p[1] == 0xab || p[1] == 0xbb || p[1] == 0xb7;
+	}
+	if (n == 3 && p[0] == 0xe2) {
+		return p[1] == 0x80 || p[1] == 0x81;
+	}
+	return false;
+}
+
+/// Add 'word' to 'words' unless it's too long. If it isn't all ASCII it's
+/// folded as the keys of lookups are, so "Été", "été" and "ete" are the
+/// same term, which can split it, e.g. "½" into "1" and "2".
+static void add_word(
+	const std::string &word,
+	const bool ascii,
+	std::string &folded,
+	std::vector<std::string> &words
+) {
+	if (ascii) {
+		if (word.size() <= g_max_word_size) {
+			words.push_back(word);
+		}
+		return;
+	}
+
+	fold_key(word, folded);
+	size_t begin = 0;
+	while (begin < folded.size()) {
+		size_t end = folded.find(' ', begin);
+		if (end == std::string::npos) {
+			end = folded.size();
+		}
+		if (end - begin <= g_max_word_size) {
+			words.push_back(folded.substr(begin, end - begin));
+		}
+		begin = end + 1;
+	}
+}
+
+/// Split plain text into downcased and folded words
+static void tokenize_text(const std::string &text, std::vector<std::string> &words) {
+	std::string word, folded;
+	bool ascii = true;
+	const unsigned char * const s = (const unsigned char*)text.data();
+	const size_t size = text.size();
+
+	for (size_t i=0; i<=size; ) {
+		bool in_word = false;
+		size_t n = 1;
+		if (i < size) {
+			const unsigned char c = s[i];
+			if (c >= 0x80) {
+				n = std::min(utf8_length(c), size-i);
+				in_word = !is_utf8_separator(s+i, n);
+				if (in_word) {
+					ascii = false;
+				}
+			} else {
+				in_word = (c >= 'a' && c <= 'z') ||
+					  (c >= 'A' && c <= 'Z') ||
+					  (c >= '0' && c <= '9');
+			}
+		}
+
+		if (in_word) {
+			for (size_t k=0; k<n; ++k) {
+				const char c = s[i+k];
+				word += (c >= 'A' && c <= 'Z') ? c-'A'+'a' : c;
+			}
+		} else if (!word.empty()) {
+			add_word(word, ascii, folded, words);
+			word.clear();
+			ascii = true;
+		}
+		i += n;
+	}
+}
+
+struct NamedEntity {
+	const char *name;
+	uint32_t cp;
+};
+
+/// The named entities of HTML 4 other than those of XML, sorted by name
+static const NamedEntity g_named_entities[] = {
+	{ "AElig", 0x00c6 },
+	{ "Aacute", 0x00c1 },
+	{ "Acirc", 0x00c2 },
+	{ "Agrave", 0x00c0 },
+	{ "Alpha", 0x0391 },
+	{ "Aring", 0x00c5 },
+	{ "Atilde", 0x00c3 },
+	{ "Auml", 0x00c4 },
+	{ "Beta", 0x0392 },
+	{ "Ccedil", 0x00c7 },
+	{ "Chi", 0x03a7 },
+	{ "Dagger", 0x2021 },
+	{ "Delta", 0x0394 },
+	{ "ETH", 0x00d0 },
+	{ "Eacute", 0x00c9 },
+	{ "Ecirc", 0x00ca },
+	{ "Egrave", 0x00c8 },
+	{ "Epsilon", 0x0395 },
+	{ "Eta", 0x0397 },
+	{ "Euml", 0x00cb },
+	{ "Gamma", 0x0393 },
+	{ "Iacute", 0x00cd },
+	{ "Icirc", 0x00ce },
+	{ "Igrave", 0x00cc },
+	{ "Iota", 0x0399 },
+	{ "Iuml", 0x00cf },
+	{ "Kappa", 0x039a },
+	{ "Lambda", 0x039b },
+	{ "Mu", 0x039c },
+	{ "Ntilde", 0x00d1 },
+	{ "Nu", 0x039d },
+	{ "OElig", 0x0152 },
+	{ "Oacute", 0x00d3 },
+	{ "Ocirc", 0x00d4 },
+	{ "Ograve", 0x00d2 },
+	{ "Omega", 0x03a9 },
+	{ "Omicron", 0x039f },
+	{ "Oslash", 0x00d8 },
+	{ "Otilde", 0x00d5 },
+	{ "Ouml", 0x00d6 },
+	{ "Phi", 0x03a6 },
+	{ "Pi", 0x03a0 },
+	{ "Prime", 0x2033 },
+	{ "Psi", 0x03a8 },
+	{ "Rho", 0x03a1 },
+	{ "Scaron", 0x0160 },
+	{ "Sigma", 0x03a3 },
+	{ "THORN", 0x00de },
+	{ "Tau", 0x03a4 },
+	{ "Theta", 0x0398 },
+	{ "Uacute", 0x00da },
+	{ "Ucirc", 0x00db },
+	{ "Ugrave", 0x00d9 },
+	{ "Upsilon", 0x03a5 },
+	{ "Uuml", 0x00dc },
+	{ "Xi", 0x039e },
+	{ "Yacute", 0x00dd },
+	{ "Yuml", 0x0178 },
+	{ "Zeta", 0x0396 },
+	{ "aacute", 0x00e1 },
+	{ "acirc", 0x00e2 },
+	{ "acute", 0x00b4 },
+	{ "aelig", 0x00e6 },
+	{ "agrave", 0x00e0 },
+	{ "alefsym", 0x2135 },
+	{ "alpha", 0x03b1 },
+	{ "and", 0x2227 },
+	{ "ang", 0x2220 },
+	{ "aring", 0x00e5 },
+	{ "asymp", 0x2248 },
+	{ "atilde", 0x00e3 },
+	{ "auml", 0x00e4 },
+	{ "bdquo", 0x201e },
+	{ "beta", 0x03b2 },
+	{ "brvbar", 0x00a6 },
+	{ "bull", 0x2022 },
+	{ "cap", 0x2229 },
+	{ "ccedil", 0x00e7 },
+	{ "cedil", 0x00b8 },
+	{ "cent", 0x00a2 },
+	{ "chi", 0x03c7 },
+	{ "circ", 0x02c6 },
+	{ "clubs", 0x2663 },
+	{ "cong", 0x2245 },
+	{ "copy", 0x00a9 },
+	{ "crarr", 0x21b5 },
+	{ "cup", 0x222a },
+	{ "curren", 0x00a4 },
+	{ "dArr", 0x21d3 },
+	{ "dagger", 0x2020 },
+	{ "darr", 0x2193 },
+	{ "deg", 0x00b0 },
+	{ "delta", 0x03b4 },
+	{ "diams", 0x2666 },
+	{ "divide", 0x00f7 },
+	{ "eacute", 0x00e9 },
+	{ "ecirc", 0x00ea },
+	{ "egrave", 0x00e8 },
+	{ "empty", 0x2205 },
+	{ "emsp", 0x2003 },
+	{ "ensp", 0x2002 },
+	{ "epsilon", 0x03b5 },
+	{ "equiv", 0x2261 },
+	{ "eta", 0x03b7 },
+	{ "eth", 0x00f0 },
+	{ "euml", 0x00eb },
+	{ "euro", 0x20ac },
+	{ "exist", 0x2203 },
+	{ "fnof", 0x0192 },
+	{ "forall", 0x2200 },
+	{ "frac12", 0x00bd },
+	{ "frac14", 0x00bc },
+	{ "frac34", 0x00be },
+	{ "frasl", 0x2044 },
+	{ "gamma", 0x03b3 },
+	{ "ge", 0x2265 },
+	{ "hArr", 0x21d4 },
+	{ "harr", 0x2194 },
+	{ "hearts", 0x2665 },
+	{ "hellip", 0x2026 },
+	{ "iacute", 0x00ed },
+	{ "icirc", 0x00ee },
+	{ "iexcl", 0x00a1 },
+	{ "igrave", 0x00ec },
+	{ "image", 0x2111 },
+	{ "infin", 0x221e },
+	{ "int", 0x222b },
+	{ "iota", 0x03b9 },
+	{ "iquest", 0x00bf },
+	{ "isin", 0x2208 },
+	{ "iuml", 0x00ef },
+	{ "kappa", 0x03ba },
+	{ "lArr", 0x21d0 },
+	{ "lambda", 0x03bb },
+	{ "lang", 0x2329 },
+	{ "laquo", 0x00ab },
+	{ "larr", 0x2190 },
+	{ "lceil", 0x2308 },
+	{ "ldquo", 0x201c },
+	{ "le", 0x2264 },
+	{ "lfloor", 0x230a },
+	{ "lowast", 0x2217 },
+	{ "loz", 0x25ca },
+	{ "lrm", 0x200e },
+	{ "lsaquo", 0x2039 },
+	{ "lsquo", 0x2018 },
+	{ "macr", 0x00af },
+	{ "mdash", 0x2014 },
+	{ "micro", 0x00b5 },
+	{ "middot", 0x00b7 },
+	{ "minus", 0x2212 },
+	{ "mu", 0x03bc },
+	{ "nabla", 0x2207 },
+	{ "nbsp", 0x00a0 },
+	{ "ndash", 0x2013 },
+	{ "ne", 0x2260 },
+	{ "ni", 0x220b },
+	{ "not", 0x00ac },
+	{ "notin", 0x2209 },
+	{ "nsub", 0x2284 },
+	{ "ntilde", 0x00f1 },
+	{ "nu", 0x03bd },
+	{ "oacute", 0x00f3 },
+	{ "ocirc", 0x00f4 },
+	{ "oelig", 0x0153 },
+	{ "ograve", 0x00f2 },
+	{ "oline", 0x203e },
+	{ "omega", 0x03c9 },
+	{ "omicron", 0x03bf },
+	{ "oplus", 0x2295 },
+	{ "or", 0x2228 },
+	{ "ordf", 0x00aa },
+	{ "ordm", 0x00ba },
+	{ "oslash", 0x00f8 },
+	{ "otilde", 0x00f5 },
+	{ "otimes", 0x2297 },
+	{ "ouml", 0x00f6 },
+	{ "para", 0x00b6 },
+	{ "part", 0x2202 },
+	{ "permil", 0x2030 },
+	{ "perp", 0x22a5 },
+	{ "phi", 0x03c6 },
+	{ "pi", 0x03c0 },
+	{ "piv", 0x03d6 },
+	{ "plusmn", 0x00b1 },
+	{ "pound", 0x00a3 },
+	{ "prime", 0x2032 },
+	{ "prod", 0x220f },
+	{ "prop", 0x221d },
+	{ "psi", 0x03c8 },
+	{ "rArr", 0x21d2 },
+	{ "radic", 0x221a },
+	{ "rang", 0x232a },
+	{ "raquo", 0x00bb },
+	{ "rarr", 0x2192 },
+	{ "rceil", 0x2309 },
+	{ "rdquo", 0x201d },
+	{ "real", 0x211c },
+	{ "reg", 0x00ae },
+	{ "rfloor", 0x230b },
+	{ "rho", 0x03c1 },
+	{ "rlm", 0x200f },
+	{ "rsaquo", 0x203a },
+	{ "rsquo", 0x2019 },
+	{ "sbquo", 0x201a },
+	{ "scaron", 0x0161 },
+	{ "sdot", 0x22c5 },
+	{ "sect", 0x00a7 },
+	{ "shy", 0x00ad },
+	{ "sigma", 0x03c3 },
+	{ "sigmaf", 0x03c2 },
+	{ "sim", 0x223c },
+	{ "spades", 0x2660 },
+	{ "sub", 0x2282 },
+	{ "sube", 0x2286 },
+	{ "sum", 0x2211 },
+	{ "sup", 0x2283 },
+	{ "sup1", 0x00b9 },
+	{ "sup2", 0x00b2 },
+	{ "sup3", 0x00b3 },
+	{ "supe", 0x2287 },
+	{ "szlig", 0x00df },
+	{ "tau", 0x03c4 },
+	{ "there4", 0x2234 },
+	{ "theta", 0x03b8 },
+	{ "thetasym", 0x03d1 },
+	{ "thinsp", 0x2009 },
+	{ "thorn", 0x00fe },
+	{ "tilde", 0x02dc },
+	{ "times", 0x00d7 },
+	{ "trade", 0x2122 },
+	{ "uArr", 0x21d1 },
+	{ "uacute", 0x00fa },
+	{ "uarr", 0x2191 },
+	{ "ucirc", 0x00fb },
+	{ "ugrave", 0x00f9 },
+	{ "uml", 0x00a8 },
+	{ "upsih", 0x03d2 },
+	{ "upsilon", 0x03c5 },
+	{ "uuml", 0x00fc },
+	{ "weierp", 0x2118 },
+	{ "xi", 0x03be },
+	{ "yacute", 0x00fd },
+	{ "yen", 0x00a5 },
+	{ "yuml", 0x00ff },
+	{ "zeta", 0x03b6 },
+	{ "zwj", 0x200d },
+	{ "zwnj", 0x200c },
+};
+static const size_t g_num_named_entities = sizeof(g_named_entities) / sizeof(g_named_entities[0]);
+
+/// Append the character of the entity at 'p', which starts after the &.
+/// Returns the bytes read, 0 if it isn't an entity.
+static size_t decode_entity(const char *p, const char * const end, std::string &out) {
+	const char * const semi = (const char*)memchr(p, ';', std::min<size_t>(end-p, 10));
+	if (!semi) {
+		return 0;
+	}
+	const std::string name(p, semi);
+
+	if (name == "amp") {
+		out += '&';
+	} else if (name == "lt") {
+		out += '<';
+	} else if (name == "gt") {
+		out += '>';
+	} else if (name == "quot") {
+		out += '"';
+	} else if (name == "apos") {
+		out += '\'';
+	} else if (name.size() > 1 && name[0] == '#') {
+		char *num_end = NULL;
+		const unsigned long cp = (name[1] == 'x' || name[1] == 'X') ?
+			strtoul(name.c_str()+2, &num_end, 16) :
+			strtoul(name.c_str()+1, &num_end, 10);
+		if (!num_end || *num_end) {
+			return 0;
+		}
+		append_utf8(cp, out);
+	} else {
+		const NamedEntity * const e = std::lower_bound(
+			g_named_entities, g_named_entities + g_num_named_entities, name,
+			[](const NamedEntity &e, const std::string &name) {
+				return strcmp(e.name, name.c_str()) < 0;
+			});
+		if (e != g_named_entities + g_num_named_entities && name == e->name) {
+			append_utf8(e->cp, out);
+		} else {
+			// unknown, a separator
+			out += ' ';
+		}
+	}
+	return semi - p + 1;
+}
+
+void tokenize_entry(const StringRef &entry, std::vector<std::string> &words) {
+	// the text without the tags and with entities decoded
+	std::string text;
+	text.reserve(entry.size);
+
+	const char *p = entry.data;
+	const char * const end = p + entry.size;
+	while (p < end) {
+		if (*p == '<') {
+			const char * const close = (const char*)memchr(p, '>', end-p);
+			if (!close) {
+				break;
+			}
+			// tags separate words, e.g. in lists
+			text += ' ';
+			p = close + 1;
+		} else if (*p == '&') {
+			const size_t n = decode_entity(p+1, end, text);
+			if (n) {
+				p += n + 1;
+			} else {
+				text += *p++;
+			}
+		} else {
+			text += *p++;
+		}
+	}
+
+	tokenize_text(text, words);
+}
+
+// varints
+
+static inline void append_varint(uint32_t n, std::string &out) {
+	while (n >= 0x80) {
+		out += char(0x80 | (n & 0x7f));
+		n >>= 7;
+	}
+	out += char(n);
+}
+
+/// Returns false at the end of the data
+static inline bool read_varint(const unsigned char *&p, const unsigned char * const end, uint32_t &n) {
+	n = 0;
+	for (int shift=0; shift<35; shift+=7) {
+		if (p >= end) {
+			return false;
+		}
+		const unsigned char c = *p++;
+		n |= uint32_t(c & 0x7f) << shift;
+		if (!(c & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// FullTextBuilder
+
+void FullTextBuilder::add_document(const std::vector<std::string> &words) {
+	const uint32_t doc = _lengths.size();
+	_lengths.push_back(words.size());
+
+	std::unordered_map<std::string, std::vector<uint32_t> > positions;
+	for (size_t i=0; i<words.size(); ++i) {
+		positions[words[i]].push_back(i);
+	}
+
+	for (	std::unordered_map<std::string, std::vector<uint32_t> >::const_iterator
+		it=positions.begin(); it!=positions.end(); ++it
+	) {
+		std::vector<uint32_t> &postings = _postings[it->first];
+		postings.push_back(doc);
+		postings.push_back(it->second.size());
+		postings.insert(postings.end(), it->second.begin(), it->second.end());
+	}
+}
+
+void FullTextBuilder::append(FullTextBuilder &later) {
+	const uint32_t offset = _lengths.size();
+
+	for (	std::unordered_map<std::string, std::vector<uint32_t> >::const_iterator
+		it=later._postings.begin(); it!=later._postings.end(); ++it
+	) {
+		const std::vector<uint32_t> &in = it->second;
+		std::vector<uint32_t> &out = _postings[it->first];
+		for (size_t i=0; i+1<in.size(); ) {
+			const uint32_t n = in[i+1];
+			out.push_back(in[i] + offset);
+			out.insert(out.end(), in.begin()+i+1, in.begin()+i+2+n);
+			i += 2 + n;
+		}
+	}
+	_lengths.insert(_lengths.end(), later._lengths.begin(), later._lengths.end());
+
+	later._postings.clear();
+	later._lengths.clear();
+}
+
+void FullTextBuilder::write(const uint64_t body_size, std::string &out) const {
+	typedef std::unordered_map<std::string, std::vector<uint32_t> >::const_iterator PostingIterT;
+
+	std::vector<PostingIterT> terms;
+	terms.reserve(_postings.size());
+	for (PostingIterT it=_postings.begin(); it!=_postings.end(); ++it) {
+		terms.push_back(it);
+	}
+	std::sort(terms.begin(), terms.end(), [](const PostingIterT &a, const PostingIterT &b) {
+			return a->first < b->first;
+		});
+
+	Meta meta;
+	memset(&meta, 0, sizeof(meta));
+	meta.num_documents = _lengths.size();
+	meta.body_size = body_size;
+	for (size_t i=0; i<_lengths.size(); ++i) {
+		meta.total_words += _lengths[i];
+	}
+
+	std::string strings, postings;
+	std::vector<TermRow> rows(terms.size());
+	for (size_t t=0; t<terms.size(); ++t) {
+		const std::string &term = terms[t]->first;
+		const std::vector<uint32_t> &in = terms[t]->second;
+
+		TermRow &row = rows[t];
+		memset(&row, 0, sizeof(row));
+		row.term.offset = strings.size();
+		row.term.size = term.size();
+		strings += term;
+		row.offset = postings.size();
+
+		uint32_t last_doc = 0;
+		for (size_t i=0; i+1<in.size(); ) {
+			const uint32_t doc = in[i];
+			const uint32_t n = in[i+1];
+			append_varint(doc - last_doc, postings);
+			append_varint(n, postings);
+			uint32_t last_pos = 0;
+			for (size_t k=0; k<n; ++k) {
+				append_varint(in[i+2+k] - last_pos, postings);
+				last_pos = in[i+2+k];
+			}
+			last_doc = doc;
+			++row.num_documents;
+			i += 2 + n;
+		}
+		row.size = postings.size() - row.offset;
+	}
+
+	const Section sections[] = {
+		{ "META", &meta,            sizeof(meta) },
+		{ "STRS", strings.data(),   strings.size() },
+		{ "TERM", rows.data(),      rows.size()*sizeof(TermRow) },
+		{ "POST", postings.data(),  postings.size() },
+		{ "DLEN", _lengths.data(),  _lengths.size()*sizeof(uint32_t) },
+	};
+	index_file::write_sections("FTXT", g_fulltext_version,
+				   sections, sizeof(sections)/sizeof(sections[0]), out);
+}
+
+// FullTextIndex
+
+/// Documents, in order, with how often a term or phrase occurs in each
+struct FullTextIndex::Matches {
+	std::vector<uint32_t> docs;
+	std::vector<uint32_t> freqs;
+};
+
+FullTextIndex::FullTextIndex()
+	: _meta(NULL),
+	  _strings(NULL),
+	  _strings_size(0),
+	  _terms(NULL),
+	  _num_terms(0),
+	  _postings(NULL),
+	  _postings_size(0),
+	  _lengths(NULL)
+{}
+
+void FullTextIndex::close() {
+	_file.close();
+	_data.clear();
+	_meta = NULL;
+	_strings = NULL;
+	_terms = NULL;
+	_postings = NULL;
+	_lengths = NULL;
+	_strings_size = _num_terms = _postings_size = 0;
+}
+
+int FullTextIndex::open(const std::string &fn, std::ostream &err) {
+	close();
+
+	if (_file.open(fn, err)) {
+		return 1;
+	}
+	_file.advise(MappedFile::RANDOM);
+
+	const int ret = parse((const char*)_file.data(), _file.size(), err);
+	if (ret) {
+		close();
+	}
+	return ret;
+}
+
+int FullTextIndex::assign(std::string &data, std::ostream &err) {
+	close();
+	_data.swap(data);
+	const int ret = parse(_data.data(), _data.size(), err);
+	if (ret) {
+		close();
+	}
+	return ret;
+}
+
+int FullTextIndex::parse(const char *data, const size_t size, std::ostream &err) {
+	if (size < sizeof(Header)) {
+		err << "Full-text index is too small\n";
+		return 1;
+	}
+	const Header &header = *(const Header*)data;
+	if (memcmp(header.magic, "FTXT", 4)) {
+		err << "Expecting file magic to be FTXT\n";
+		return 1;
+	}
+	if (header.version != g_fulltext_version) {
+		err << "Full-text index version " << (int)header.version <<
+			" isn't supported\n";
+		return 1;
+	}
+	if (header.nsections > (size - sizeof(Header)) / sizeof(SectionHeader)) {
+		err << "Full-text index section table is truncated\n";
+		return 1;
+	}
+
+	const SectionHeader * const sections =
+		(const SectionHeader*)(data + sizeof(Header));
+	const Meta *meta = NULL;
+	size_t lengths_size = 0;
+
+	for (uint32_t i=0; i<header.nsections; ++i) {
+		const SectionHeader &h = sections[i];
+		if (h.offset > size || h.size > size - h.offset || h.offset % 8) {
+			err << "Full-text index section " << std::string(h.tag, 4) <<
+				" is out of range\n";
+			return 1;
+		}
+		const char * const p = data + h.offset;
+
+		if (!memcmp(h.tag, "META", 4) && h.size >= sizeof(Meta)) {
+			meta = (const Meta*)p;
+		} else if (!memcmp(h.tag, "STRS", 4)) {
+			_strings = p;
+			_strings_size = h.size;
+		} else if (!memcmp(h.tag, "TERM", 4)) {
+			_terms = (const TermRow*)p;
+			_num_terms = h.size / sizeof(TermRow);
+		} else if (!memcmp(h.tag, "POST", 4)) {
+			_postings = (const unsigned char*)p;
+			_postings_size = h.size;
+		} else if (!memcmp(h.tag, "DLEN", 4)) {
+			_lengths = (const uint32_t*)p;
+			lengths_size = h.size;
+		}
+	}
+
+	if (!meta || !_strings || !_terms || !_postings || !_lengths) {
+		err << "Full-text index is missing a section\n";
+		return 1;
+	}
+	if (lengths_size / sizeof(uint32_t) != meta->num_documents) {
+		err << "Full-text index has the wrong number of documents\n";
+		return 1;
+	}
+
+	_meta = meta;
+	return 0;
+}
+
+bool FullTextIndex::matches(const size_t num_entries, const size_t body_size) const {
+	return _meta &&
+		_meta->num_documents == num_entries &&
+		_meta->body_size == body_size;
+}
+
+void FullTextIndex::read_postings(
+	const std::string &term,
+	std::vector<uint32_t> &docs,
+	std::vector<std::vector<uint32_t> > &positions
+) const {
+	docs.clear();
+	positions.clear();
+
+	const TermRow * const end = _terms + _num_terms;
+	const TermRow * const row = std::lower_bound(_terms, end, term,
+		[this](const TermRow &r, const std::string &t) {
+			if (r.term.offset > _strings_size || r.term.size > _strings_size - r.term.offset) {
+				return false;
+			}
+			return t.compare(0, t.size(), _strings + r.term.offset, r.term.size) > 0;
+		});
+	if (	row == end ||
+		row->term.offset > _strings_size ||
+		row->term.size > _strings_size - row->term.offset ||
+		term.compare(0, term.size(), _strings + row->term.offset, row->term.size) ||
+		row->offset > _postings_size ||
+		row->size > _postings_size - row->offset
+	) {
+		return;
+	}
+
+	const unsigned char *p = _postings + row->offset;
+	const unsigned char * const pend = p + row->size;
+	uint32_t doc = 0;
+	for (uint32_t i=0; i<row->num_documents; ++i) {
+		uint32_t delta, n;
+		if (!read_varint(p, pend, delta) || !read_varint(p, pend, n)) {
+			break;
+		}
+		doc += delta;
+		docs.push_back(doc);
+		positions.push_back(std::vector<uint32_t>());
+		std::vector<uint32_t> &pos = positions.back();
+		pos.reserve(std::min<size_t>(n, pend - p));
+
+		uint32_t at = 0;
+		for (uint32_t k=0; k<n; ++k) {
+			if (!read_varint(p, pend, delta)) {
+				break;
+			}
+			at += delta;
+			pos.push_back(at);
+		}
+	}
+}
+
+void FullTextIndex::find_phrase(const std::vector<std::string> &phrase, Matches &out) const {
+	out.docs.clear();
+	out.freqs.clear();
+
+	// where the phrase starts, in each document which has it so far
+	std::vector<uint32_t> docs;
+	std::vector<std::vector<uint32_t> > starts;
+	read_postings(phrase[0], docs, starts);
+
+	std::vector<uint32_t> next_docs;
+	std::vector<std::vector<uint32_t> > next_positions;
+	for (size_t w=1; w<phrase.size() && !docs.empty(); ++w) {
+		read_postings(phrase[w], next_docs, next_positions);
+
+		// keep the starts followed by word 'w' at the offset 'w'
+		size_t kept = 0;
+		for (size_t i=0, j=0; i<docs.size() && j<next_docs.size(); ) {
+			if (docs[i] < next_docs[j]) {
+				++i;
+			} else if (docs[i] > next_docs[j]) {
+				++j;
+			} else {
+				const std::vector<uint32_t> &s = starts[i];
+				const std::vector<uint32_t> &p = next_positions[j];
+				std::vector<uint32_t> found;
+				for (size_t a=0, b=0; a<s.size() && b<p.size(); ) {
+					const uint64_t want = uint64_t(s[a]) + w;
+					if (want < p[b]) {
+						++a;
+					} else if (want > p[b]) {
+						++b;
+					} else {
+						found.push_back(s[a]);
+						++a;
+						++b;
+					}
+				}
+				if (!found.empty()) {
+					docs[kept] = docs[i];
+					starts[kept].swap(found);
+					++kept;
+				}
+				++i;
+				++j;
+			}
+		}
+		docs.resize(kept);
+		starts.resize(kept);
+	}
+
+	out.docs.swap(docs);
+	out.freqs.resize(starts.size());
+	for (size_t i=0; i<starts.size(); ++i) {
+		out.freqs[i] = starts[i].size();
+	}
+}
+
+/// A word or quoted phrase of a query
+struct QueryItem {
+	/// Single words are phrases of one word
+	std::vector<std::string> phrase;
+	/// Preceded by -
+	bool negated;
+};
+typedef std::vector<QueryItem> QueryClauseT;
+
+/// Split 'query' into lists of phrases, which are split by OR. Returns
+/// non-zero if the query is invalid.
+static int parse_query(
+	const std::string &query,
+	std::vector<QueryClauseT> &clauses,
+	std::ostream &err
+) {
+	clauses.assign(1, QueryClauseT());
+
+	size_t i = 0;
+	while (i < query.size()) {
+		if (isspace((unsigned char)query[i])) {
+			++i;
+			continue;
+		}
+
+		QueryItem item;
+		item.negated = false;
+		if (query[i] == '-' && i+1 < query.size() && !isspace((unsigned char)query[i+1])) {
+			item.negated = true;
+			++i;
+		}
+
+		std::string text;
+		bool quoted = false;
+		if (query[i] == '"') {
+			quoted = true;
+			const size_t close = query.find('"', i+1);
+			const size_t end = close == std::string::npos ? query.size() : close;
+			text = query.substr(i+1, end-i-1);
+			i = end + 1;
+		} else {
+			size_t end = i;
+			while (end < query.size() && !isspace((unsigned char)query[end])) {
+				++end;
+			}
+			text = query.substr(i, end-i);
+			i = end;
+		}
+
+		if (!quoted && !item.negated && text == "OR") {
+			clauses.push_back(QueryClauseT());
+			continue;
+		}
+
+		tokenize_text(text, item.phrase);
+		if (!item.phrase.empty()) {
+			clauses.back().push_back(item);
+		}
+	}
+
+	for (size_t c=0; c<clauses.size(); ++c) {
+		bool positive = false;
+		for (size_t k=0; k<clauses[c].size(); ++k) {
+			positive = positive || !clauses[c][k].negated;
+		}
+		if (!positive) {
+			err << "Expecting words to search for";
+			if (clauses.size() > 1) {
+				err << " on each side of OR";
+			}
+			err << "\n";
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int FullTextIndex::search(
+	const std::string &query,
+	const size_t max_hits,
+	std::vector<FullTextHit> &hits,
+	std::ostream &err
+) const {
+	hits.clear();
+	if (!_meta) {
+		err << "No full-text index\n";
+		return 1;
+	}
+
+	std::vector<QueryClauseT> clauses;
+	if (parse_query(query, clauses, err)) {
+		return 1;
+	}
+
+	const double num_docs = std::max<double>(_meta->num_documents, 1);
+	const double avg_length = std::max(_meta->total_words / num_docs, 1.0);
+
+	std::unordered_map<uint32_t, double> scores;
+	Matches m;
+	for (size_t c=0; c<clauses.size(); ++c) {
+		const QueryClauseT &clause = clauses[c];
+
+		// documents with all the phrases so far, and their scores
+		std::vector<uint32_t> docs;
+		std::vector<double> doc_scores;
+		bool first = true;
+
+		for (size_t k=0; k<clause.size(); ++k) {
+			if (clause[k].negated) {
+				continue;
+			}
+			find_phrase(clause[k].phrase, m);
+
+			const double df = m.docs.size();
+			const double idf = log(1 + (num_docs - df + 0.5) / (df + 0.5));
+
+			std::vector<uint32_t> kept_docs;
+			std::vector<double> kept_scores;
+			for (size_t i=0, j=0; i<m.docs.size() && (first || j<docs.size()); ) {
+				if (!first && docs[j] < m.docs[i]) {
+					++j;
+					continue;
+				}
+				if (!first && docs[j] > m.docs[i]) {
+					++i;
+					continue;
+				}
+
+				const uint32_t doc = m.docs[i];
+				const double length = doc < _meta->num_documents ? _lengths[doc] : avg_length;
+				const double f = m.freqs[i];
+				const double score = idf * f * (g_bm25_k1 + 1) /
+					(f + g_bm25_k1 * (1 - g_bm25_b + g_bm25_b * length / avg_length));
+
+				kept_docs.push_back(doc);
+				kept_scores.push_back(score + (first ? 0 : doc_scores[j]));
+				++i;
+				if (!first) {
+					++j;
+				}
+			}
+			docs.swap(kept_docs);
+			doc_scores.swap(kept_scores);
+			first = false;
+		}
+
+		for (size_t k=0; k<clause.size() && !docs.empty(); ++k) {
+			if (!clause[k].negated) {
+				continue;
+			}
+			find_phrase(clause[k].phrase, m);
+
+			size_t kept = 0;
+			for (size_t i=0, j=0; i<docs.size(); ++i) {
+				while (j < m.docs.size() && m.docs[j] < docs[i]) {
+					++j;
+				}
+				if (j < m.docs.size() && m.docs[j] == docs[i]) {
+					continue;
+				}
+				docs[kept] = docs[i];
+				doc_scores[kept] = doc_scores[i];
+				++kept;
+			}
+			docs.resize(kept);
+			doc_scores.resize(kept);
+		}
+
+		for (size_t i=0; i<docs.size(); ++i) {
+			scores[docs[i]] += doc_scores[i];
+		}
+	}
+
+	hits.reserve(scores.size());
+	for (	std::unordered_map<uint32_t, double>::const_iterator
+		it=scores.begin(); it!=scores.end(); ++it
+	) {
+		FullTextHit hit;
+		hit.row = it->first;
+		hit.score = it->second;
+		hits.push_back(hit);
+	}
+	std::sort(hits.begin(), hits.end(), [](const FullTextHit &a, const FullTextHit &b) {
+			if (a.score != b.score) {
+				return a.score > b.score;
+			}
+			return a.row < b.row;
+		});
+	if (hits.size() > max_hits) {
+		hits.resize(max_hits);
+	}
+	return 0;
+}
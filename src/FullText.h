@@ -0,0 +1,143 @@
+#ifndef INCLUDED_FULLTEXT_H
+#define INCLUDED_FULLTEXT_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iosfwd>
+#include <cstddef>
+#include <stdint.h>
+#include "Index.h"
+
+/// Words of the text of an entry, without the markup, downcased, and
+/// folded as by fold_key() if they aren't ASCII. Letters, digits and any
+/// non-ASCII characters make up words.
+void tokenize_entry(const StringRef &entry, std::vector<std::string> &words);
+
+/// On-disk layout of the full-text index, which is stored next to the
+/// index cache. It uses the Header and SectionHeader of the index cache
+/// with the magic FTXT.
+namespace fulltext_file {
+
+	/// The "META" section
+	struct Meta {
+		/// Same as the rows of the "ENTR" section of the index cache
+		uint64_t num_documents;
+		/// Of the Body.data it was built from
+		uint64_t body_size;
+		/// Sum of the words of all the documents
+		uint64_t total_words;
+	};
+
+	/// Row of the "TERM" section, sorted by term. The terms are in the
+	/// "STRS" section.
+	///
+	/// The postings of a term are 'size' bytes at 'offset' in the "POST"
+	/// section. For each document with the term, in order, there is the
+	/// difference from the previous document, the number of times the
+	/// term occurs, and the differences between its positions, all as
+	/// LEB128 varints.
+	struct TermRow {
+		index_file::String term;
+		uint32_t num_documents;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// the "DLEN" section is the number of words in each document as a
+	// uint32_t
+}
+
+/// Collects the words of the entries, and writes them as a full-text
+/// index
+class FullTextBuilder {
+public:
+	FullTextBuilder() {}
+
+	/// Documents are numbered in the order they are added, from 0
+	void add_document(const std::vector<std::string> &words);
+	/// Add the documents of 'later' after those of this builder. 'later'
+	/// is left empty.
+	void append(FullTextBuilder &later);
+
+	size_t num_documents() const { return _lengths.size(); }
+
+	void write(const uint64_t body_size, std::string &out) const;
+
+private:
+	/// For each term, the document, the number of positions and the
+	/// positions, for each document it is in
+	std::unordered_map<std::string, std::vector<uint32_t> > _postings;
+	std::vector<uint32_t> _lengths;
+
+	// non-copyable
+	FullTextBuilder(const FullTextBuilder &);
+	FullTextBuilder &operator=(const FullTextBuilder &);
+};
+
+struct FullTextHit {
+	/// Row of the entry in the index
+	size_t row;
+	double score;
+};
+
+/// The full-text index, queried in place.
+///
+/// A query is a list of words, all of which must be in an entry. A "quoted
+/// phrase" must be in the entry with its words in that order. A word or
+/// phrase after - must not be in the entry. OR between two such lists
+/// matches the entries that match either of them. Entries are ranked with
+/// BM25.
+class FullTextIndex {
+public:
+	FullTextIndex();
+
+	/// Returns non-zero on error
+	int open(const std::string &fn, std::ostream &err);
+	/// Take the contents of 'data' as the index, instead of a file
+	int assign(std::string &data, std::ostream &err);
+	void close();
+
+	bool is_open() const { return _meta != NULL; }
+	/// True if it was built from a Body.data of 'body_size' bytes, and
+	/// for an index with 'num_entries' entries
+	bool matches(const size_t num_entries, const size_t body_size) const;
+
+	/// The best 'max_hits' entries for 'query', best first. Returns
+	/// non-zero and writes a message to 'err' if the query is invalid.
+	int search(const std::string &query,
+		   const size_t max_hits,
+		   std::vector<FullTextHit> &hits,
+		   std::ostream &err) const;
+
+private:
+	/// Set if the index was read from a file
+	MappedFile _file;
+	/// Set if the index was assigned from memory
+	std::string _data;
+
+	const fulltext_file::Meta *_meta;
+	const char *_strings;
+	size_t _strings_size;
+	const fulltext_file::TermRow *_terms;
+	size_t _num_terms;
+	const unsigned char *_postings;
+	size_t _postings_size;
+	const uint32_t *_lengths;
+
+	struct Matches;
+
+	int parse(const char *data, const size_t size, std::ostream &err);
+	/// Documents with 'phrase', and how often it occurs in each
+	void find_phrase(const std::vector<std::string> &phrase, Matches &out) const;
+	void read_postings(const std::string &term,
+			   std::vector<uint32_t> &docs,
+			   std::vector<std::vector<uint32_t> > &positions) const;
+
+	// non-copyable
+	FullTextIndex(const FullTextIndex &);
+	FullTextIndex &operator=(const FullTextIndex &);
+};
+
+#endif
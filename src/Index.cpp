@@ -0,0 +1,1034 @@
+#include "Index.h"
+#include "Fold.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+using namespace index_file;
+
+static const unsigned char g_index_version = 2;
+
+/// Round up to the start of the next section
+static inline size_t align8(const size_t n) {
+	return (n + 7) & ~size_t(7);
+}
+
+/// Like std::string::compare
+static inline int compare(const StringRef &a, const std::string &b) {
+	const int r = memcmp(a.data, b.data(), std::min(a.size, b.size()));
+	if (r) {
+		return r;
+	}
+	return a.size < b.size() ? -1 : (a.size > b.size() ? 1 : 0);
+}
+
+static inline bool startswith(const StringRef &a, const std::string &prefix) {
+	return a.size >= prefix.size() && !memcmp(a.data, prefix.data(), prefix.size());
+}
+
+void index_file::write_sections(
+	const char * const magic,
+	const uint8_t version,
+	const Section * const sections,
+	const size_t nsections,
+	std::string &out
+) {
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, 4);
+	header.version = version;
+	header.nsections = nsections;
+
+	std::vector<SectionHeader> headers(nsections);
+	size_t offset = align8(sizeof(Header) + nsections*sizeof(SectionHeader));
+	for (size_t i=0; i<nsections; ++i) {
+		memset(&headers[i], 0, sizeof(SectionHeader));
+		memcpy(headers[i].tag, sections[i].tag, 4);
+		headers[i].offset = offset;
+		headers[i].size = sections[i].size;
+		offset = align8(offset + sections[i].size);
+	}
+
+	out.clear();
+	out.reserve(offset);
+	out.append((const char*)&header, sizeof(header));
+	out.append((const char*)&headers[0], nsections*sizeof(SectionHeader));
+	for (size_t i=0; i<nsections; ++i) {
+		out.resize(headers[i].offset, '\0');
+		out.append((const char*)sections[i].data, sections[i].size);
+	}
+	out.resize(offset, '\0');
+}
+
+static inline unsigned char downcase(const unsigned char c) {
+	return c >= 'A' && c <= 'Z' ? c-'A'+'a' : c;
+}
+
+/// Like compare(), with A-Z downcased in both
+static inline int compare_downcased(const StringRef &a, const StringRef &b) {
+	const size_t n = std::min(a.size, b.size);
+	for (size_t i=0; i<n; ++i) {
+		const unsigned char x = downcase(a.data[i]), y = downcase(b.data[i]);
+		if (x != y) {
+			return x < y ? -1 : 1;
+		}
+	}
+	return a.size < b.size ? -1 : (a.size > b.size ? 1 : 0);
+}
+
+/// Add 's' to the end of 'strings'
+static inline String append_string(std::string &strings, const char *s, const size_t n) {
+	String r;
+	r.offset = strings.size();
+	r.size = n;
+	strings.append(s, n);
+	return r;
+}
+
+// EntryTable
+
+const std::string &EntryTable::add_block(const ByteRangeT &file_range, std::string &text) {
+	_block_ranges.push_back(file_range);
+	_block_texts.push_back(std::string());
+	_block_texts.back().swap(text);
+	return _block_texts.back();
+}
+
+void EntryTable::add(const std::string &name, const ByteRangeT &range) {
+	_names.push_back(append_string(_strings, name.data(), name.size()));
+	_blocks.push_back(_block_ranges.size() - 1);
+	_ranges.push_back(std::make_pair(range.first, range.second));
+}
+
+void EntryTable::add(const std::string &name, const EntryPosition &pos) {
+	if (_block_ranges.empty() || _block_ranges.back() != pos.file_range) {
+		std::string none;
+		add_block(pos.file_range, none);
+	}
+	add(name, pos.uncompressed_range);
+}
+
+void EntryTable::append(EntryTable &later) {
+	const uint32_t strings_offset = _strings.size();
+	const uint32_t blocks_offset = _block_ranges.size();
+
+	_strings += later._strings;
+	for (size_t i=0; i<later._names.size(); ++i) {
+		String s = later._names[i];
+		s.offset += strings_offset;
+		_names.push_back(s);
+		_blocks.push_back(later._blocks[i] + blocks_offset);
+	}
+	_ranges.insert(_ranges.end(), later._ranges.begin(), later._ranges.end());
+
+	_block_ranges.insert(_block_ranges.end(),
+			     later._block_ranges.begin(), later._block_ranges.end());
+	for (size_t i=0; i<later._block_texts.size(); ++i) {
+		_block_texts.push_back(std::string());
+		_block_texts.back().swap(later._block_texts[i]);
+	}
+
+	later._strings.clear();
+	later._names.clear();
+	later._blocks.clear();
+	later._ranges.clear();
+	later._block_ranges.clear();
+	later._block_texts.clear();
+	later._sorted.clear();
+	later._num_sorted = 0;
+}
+
+StringRef EntryTable::name(const size_t i) const {
+	return StringRef(_strings.data() + _names[i].offset, _names[i].size);
+}
+
+void EntryTable::key(const size_t i, std::string &out) const {
+	const StringRef n = name(i);
+	out.resize(n.size);
+	for (size_t k=0; k<n.size; ++k) {
+		out[k] = downcase(n.data[k]);
+	}
+}
+
+EntryPosition EntryTable::position(const size_t i) const {
+	return EntryPosition(_block_ranges[_blocks[i]],
+			     ByteRangeT(_ranges[i].first, _ranges[i].second));
+}
+
+StringRef EntryTable::text(const size_t i) const {
+	const std::string &block = _block_texts[_blocks[i]];
+	if (_ranges[i].second > block.size()) {
+		return StringRef();
+	}
+	return StringRef(block.data() + _ranges[i].first,
+			 _ranges[i].second - _ranges[i].first);
+}
+
+void EntryTable::sort() {
+	if (_num_sorted == _names.size()) {
+		return;
+	}
+	const auto less = [this](const uint32_t a, const uint32_t b) {
+		return compare_downcased(name(a), name(b)) < 0;
+	};
+
+	const size_t middle = _sorted.size();
+	for (size_t i=_num_sorted; i<_names.size(); ++i) {
+		_sorted.push_back(i);
+	}
+	_num_sorted = _names.size();
+
+	// the new rows come after the others with the same key
+	std::stable_sort(_sorted.begin() + middle, _sorted.end(), less);
+	std::inplace_merge(_sorted.begin(), _sorted.begin() + middle, _sorted.end(), less);
+}
+
+bool EntryTable::same_key(const size_t a, const size_t b) const {
+	return compare_downcased(name(a), name(b)) == 0;
+}
+
+bool EntryTable::contains(const std::string &key) const {
+	const StringRef k(key.data(), key.size());
+	std::vector<uint32_t>::const_iterator it = std::lower_bound(
+		_sorted.begin(), _sorted.end(), k,
+		[this](const uint32_t row, const StringRef &k) {
+			return compare_downcased(name(row), k) < 0;
+		});
+	return it != _sorted.end() && compare_downcased(name(*it), k) == 0;
+}
+
+// PairTable
+
+void PairTable::add(const std::string &key, const std::string &value) {
+	_keys.push_back(append_string(_strings, key.data(), key.size()));
+	_values.push_back(append_string(_strings, value.data(), value.size()));
+}
+
+void PairTable::append(const PairTable &later) {
+	for (size_t i=0; i<later.size(); ++i) {
+		const StringRef k = later.key(i), v = later.value(i);
+		_keys.push_back(append_string(_strings, k.data, k.size));
+		_values.push_back(append_string(_strings, v.data, v.size));
+	}
+}
+
+void PairTable::clear() {
+	std::string().swap(_strings);
+	std::vector<String>().swap(_keys);
+	std::vector<String>().swap(_values);
+}
+
+StringRef PairTable::key(const size_t i) const {
+	return StringRef(_strings.data() + _keys[i].offset, _keys[i].size);
+}
+
+StringRef PairTable::value(const size_t i) const {
+	return StringRef(_strings.data() + _values[i].offset, _values[i].size);
+}
+
+void PairTable::sort(const Ties ties) {
+	const std::string &strings = _strings;
+	const auto compare_keys = [&strings](const String &a, const String &b) {
+		return strings.compare(a.offset, a.size, strings, b.offset, b.size);
+	};
+
+	std::vector<uint32_t> order(_keys.size());
+	for (size_t i=0; i<order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(),
+		  [this, &compare_keys, ties](const uint32_t a, const uint32_t b) {
+			  const int c = compare_keys(_keys[a], _keys[b]);
+			  if (c != 0) {
+				  return c < 0;
+			  }
+			  return ties == TIES_FIRST ? a < b : a > b;
+		  });
+
+	// copy the strings in the new order, so that they are together
+	std::string strings_out;
+	std::vector<String> keys, values;
+	for (size_t i=0; i<order.size(); ++i) {
+		const String &k = _keys[order[i]], &v = _values[order[i]];
+		if (ties == TIES_FIRST && !keys.empty() && compare_keys(_keys[order[i-1]], k) == 0) {
+			continue;
+		}
+		keys.push_back(append_string(strings_out, _strings.data() + k.offset, k.size));
+		values.push_back(append_string(strings_out, _strings.data() + v.offset, v.size));
+	}
+	_strings.swap(strings_out);
+	_keys.swap(keys);
+	_values.swap(values);
+}
+
+// IndexBuilder
+
+String IndexBuilder::add_string(const std::string &s) {
+	std::unordered_map<std::string, String>::const_iterator it =
+		_string_offsets.find(s);
+	if (it != _string_offsets.end()) {
+		return it->second;
+	}
+	String r;
+	// the offsets are 32 bits, so the strings can't be past 4 GiB
+	if (_strings.size() + s.size() > uint32_t(-1)) {
+		_strings_overflow = true;
+		r.offset = r.size = 0;
+		return r;
+	}
+	r.offset = _strings.size();
+	r.size = s.size();
+	_strings += s;
+	_string_offsets.insert(std::make_pair(s, r));
+	return r;
+}
+
+void IndexBuilder::add_entry(
+	const std::string &key,
+	const std::string &name,
+	const EntryPosition &pos
+) {
+	EntryRow row;
+	row.key  = add_string(key);
+	row.name = add_string(name);
+	row.file_first	       = pos.file_range.first;
+	row.file_second	       = pos.file_range.second;
+	row.uncompressed_first  = pos.uncompressed_range.first;
+	row.uncompressed_second = pos.uncompressed_range.second;
+	_entries.push_back(row);
+}
+
+void IndexBuilder::add_link(const std::string &key, const std::string &target) {
+	PairRow row;
+	row.key	  = add_string(key);
+	row.value = add_string(target);
+	_links.push_back(row);
+}
+
+void IndexBuilder::add_backlink(const std::string &key, const std::string &target) {
+	PairRow row;
+	row.key	  = add_string(key);
+	row.value = add_string(target);
+	_backlinks.push_back(row);
+}
+
+void IndexBuilder::add_block(const BlockInfo &block) {
+	BlockRow row;
+	row.file_first        = block.file_range.first;
+	row.file_second       = block.file_range.second;
+	row.uncompressed_size = block.uncompressed_size;
+	_blocks.push_back(row);
+}
+
+void IndexBuilder::build_trie() {
+	const std::string &strings = _strings;
+	const auto compare_keys = [&strings](const String &a, const String &b) {
+		return strings.compare(a.offset, a.size, strings, b.offset, b.size);
+	};
+
+	// the distinct keys of the entries and links, in order, with their rows
+	struct Key {
+		String s;
+		uint32_t entry_first, entry_second;
+		uint32_t link_first, link_second;
+	};
+	std::vector<Key> keys;
+	for (size_t i=0, j=0; i < _entries.size() || j < _links.size(); ) {
+		Key k;
+		if (j == _links.size() ||
+		    (i < _entries.size() && compare_keys(_entries[i].key, _links[j].key) <= 0)) {
+			k.s = _entries[i].key;
+		} else {
+			k.s = _links[j].key;
+		}
+		k.entry_first = i;
+		while (i < _entries.size() && compare_keys(_entries[i].key, k.s) == 0) {
+			++i;
+		}
+		k.entry_second = i;
+		k.link_first = j;
+		while (j < _links.size() && compare_keys(_links[j].key, k.s) == 0) {
+			++j;
+		}
+		k.link_second = j;
+		keys.push_back(k);
+	}
+
+	_trie.clear();
+	_trie.push_back(TrieNode());
+	if (keys.empty()) {
+		return;
+	}
+
+	// keys [lo, hi) are below node n, and have the first 'depth' bytes
+	// in common with the key of its parent
+	struct Pending {
+		size_t lo, hi;
+		size_t depth;
+	};
+	std::vector<Pending> pending(1);
+	pending[0].lo = 0;
+	pending[0].hi = keys.size();
+	pending[0].depth = 0;
+
+	// breadth first, so the children of a node are consecutive
+	for (size_t n=0; n<_trie.size(); ++n) {
+		const Pending p = pending[n];
+		const Key &first = keys[p.lo];
+		const Key &last = keys[p.hi-1];
+		const char * const a = strings.data() + first.s.offset;
+		const char * const b = strings.data() + last.s.offset;
+
+		// the keys are sorted, so what the first and last have in
+		// common is common to all of them
+		size_t depth = p.depth;
+		const size_t max = std::min(first.s.size, last.s.size);
+		while (depth < max && a[depth] == b[depth]) {
+			++depth;
+		}
+
+		_trie[n].label.offset = first.s.offset + p.depth;
+		_trie[n].label.size = depth - p.depth;
+		_trie[n].entry_first = first.entry_first;
+		_trie[n].entry_second = last.entry_second;
+		_trie[n].link_first = first.link_first;
+		_trie[n].link_second = last.link_second;
+		_trie[n].first_child = _trie.size();
+		_trie[n].num_children = 0;
+
+		size_t k = p.lo;
+		if (keys[k].s.size == depth) {
+			// the key of this node sorts before those of its children
+			++k;
+		}
+		while (k < p.hi) {
+			const char c = strings[keys[k].s.offset + depth];
+			size_t end = k+1;
+			while (end < p.hi && strings[keys[end].s.offset + depth] == c) {
+				++end;
+			}
+
+			Pending child;
+			child.lo = k;
+			child.hi = end;
+			child.depth = depth;
+			pending.push_back(child);
+			_trie.push_back(TrieNode());
+			++_trie[n].num_children;
+
+			k = end;
+		}
+	}
+}
+
+void IndexBuilder::build_folds() {
+	_folds.clear();
+
+	std::string folded;
+	for (size_t i=0; i<_entries.size(); ++i) {
+		const String &key = _entries[i].key;
+		if (	i > 0 &&
+			0 == _strings.compare(key.offset, key.size, _strings,
+					      _entries[i-1].key.offset, _entries[i-1].key.size)
+		) {
+			continue;
+		}
+		fold_key(_strings.substr(key.offset, key.size), folded);
+		if (!folded.empty()) {
+			FoldRow row;
+			row.key = add_string(folded);
+			row.row = i;
+			row.is_link = 0;
+			_folds.push_back(row);
+		}
+	}
+	for (size_t i=0; i<_links.size(); ++i) {
+		const String &key = _links[i].key;
+		fold_key(_strings.substr(key.offset, key.size), folded);
+		if (!folded.empty()) {
+			FoldRow row;
+			row.key = add_string(folded);
+			row.row = i;
+			row.is_link = 1;
+			_folds.push_back(row);
+		}
+	}
+
+	// entries then links, each in row order, so a stable sort keeps that
+	const std::string &strings = _strings;
+	std::stable_sort(_folds.begin(), _folds.end(),
+			 [&strings](const FoldRow &a, const FoldRow &b) {
+				 return strings.compare(a.key.offset, a.key.size,
+							strings, b.key.offset, b.key.size) < 0;
+			 });
+}
+
+int IndexBuilder::write(std::string &out, std::ostream &err) {
+	build_trie();
+	build_folds();
+	if (_strings_overflow) {
+		err << "The strings of the index are over 4 GiB\n";
+		return 1;
+	}
+
+	{
+		const std::string &strings = _strings;
+		std::stable_sort(_backlinks.begin(), _backlinks.end(),
+				 [&strings](const PairRow &a, const PairRow &b) {
+					 return strings.compare(a.key.offset, a.key.size,
+								strings, b.key.offset, b.key.size) < 0;
+				 });
+	}
+
+	const Section sections[] = {
+		{ "STRS", _strings.data(),   _strings.size() },
+		{ "ENTR", _entries.data(),   _entries.size()*sizeof(EntryRow) },
+		{ "LINK", _links.data(),     _links.size()*sizeof(PairRow) },
+		{ "BLNK", _backlinks.data(), _backlinks.size()*sizeof(PairRow) },
+		{ "BLKS", _blocks.data(),    _blocks.size()*sizeof(BlockRow) },
+		{ "TRIE", _trie.data(),      _trie.size()*sizeof(TrieNode) },
+		{ "FOLD", _folds.data(),     _folds.size()*sizeof(FoldRow) },
+	};
+	write_sections("DICT", g_index_version,
+		       sections, sizeof(sections)/sizeof(sections[0]), out);
+	return 0;
+}
+
+// MappedIndex
+
+MappedIndex::MappedIndex()
+	: _strings(NULL),
+	  _strings_size(0),
+	  _entries(NULL),
+	  _num_entries(0),
+	  _links(NULL),
+	  _num_links(0),
+	  _backlinks(NULL),
+	  _num_backlinks(0),
+	  _blocks(NULL),
+	  _num_blocks(0),
+	  _trie(NULL),
+	  _num_trie_nodes(0),
+	  _folds(NULL),
+	  _num_folds(0)
+{}
+
+MappedIndex::~MappedIndex() {
+	close();
+}
+
+void MappedIndex::close() {
+	_file.close();
+	_data.clear();
+	_strings = NULL;
+	_strings_size = 0;
+	_entries = NULL;
+	_links = _backlinks = NULL;
+	_blocks = NULL;
+	_trie = NULL;
+	_folds = NULL;
+	_num_entries = _num_links = _num_backlinks = _num_blocks = 0;
+	_num_trie_nodes = _num_folds = 0;
+}
+
+int MappedIndex::open(const std::string &fn, std::ostream &err) {
+	close();
+
+	if (_file.open(fn, err)) {
+		return 1;
+	}
+	_file.advise(MappedFile::RANDOM);
+
+	const int ret = parse((const char*)_file.data(), _file.size(), err);
+	if (ret) {
+		close();
+	}
+	return ret;
+}
+
+int MappedIndex::assign(std::string &data, std::ostream &err) {
+	close();
+	_data.swap(data);
+	const int ret = parse(_data.data(), _data.size(), err);
+	if (ret) {
+		close();
+	}
+	return ret;
+}
+
+int MappedIndex::parse(const char *data, const size_t size, std::ostream &err) {
+	if (size < sizeof(Header)) {
+		err << "Index cache is too small\n";
+		return 1;
+	}
+	const Header &header = *(const Header*)data;
+	if (memcmp(header.magic, "DICT", 4)) {
+		err << "Expecting file magic to be DICT\n";
+		return 1;
+	}
+	if (header.version < g_index_version) {
+		return 2;
+	}
+	if (header.version > g_index_version) {
+		err << "Index cache version " << (int)header.version <<
+			" is newer than this program\n";
+		return 1;
+	}
+	if (header.nsections > (size - sizeof(Header)) / sizeof(SectionHeader)) {
+		err << "Index cache section table is truncated\n";
+		return 1;
+	}
+
+	const SectionHeader * const sections =
+		(const SectionHeader*)(data + sizeof(Header));
+	bool found[4] = { false, false, false, false };
+
+	for (uint32_t i=0; i<header.nsections; ++i) {
+		const SectionHeader &h = sections[i];
+		if (h.offset > size || h.size > size - h.offset || h.offset % 8) {
+			err << "Index cache section " << std::string(h.tag, 4) <<
+				" is out of range\n";
+			return 1;
+		}
+		const char * const p = data + h.offset;
+
+		if (!memcmp(h.tag, "STRS", 4)) {
+			_strings = p;
+			_strings_size = h.size;
+			found[0] = true;
+		} else if (!memcmp(h.tag, "ENTR", 4)) {
+			_entries = (const EntryRow*)p;
+			_num_entries = h.size / sizeof(EntryRow);
+			found[1] = true;
+		} else if (!memcmp(h.tag, "LINK", 4)) {
+			_links = (const PairRow*)p;
+			_num_links = h.size / sizeof(PairRow);
+			found[2] = true;
+		} else if (!memcmp(h.tag, "BLNK", 4)) {
+			_backlinks = (const PairRow*)p;
+			_num_backlinks = h.size / sizeof(PairRow);
+			found[3] = true;
+		} else if (!memcmp(h.tag, "BLKS", 4)) {
+			_blocks = (const BlockRow*)p;
+			_num_blocks = h.size / sizeof(BlockRow);
+		} else if (!memcmp(h.tag, "TRIE", 4) && h.size >= sizeof(TrieNode)) {
+			_trie = (const TrieNode*)p;
+			_num_trie_nodes = h.size / sizeof(TrieNode);
+		} else if (!memcmp(h.tag, "FOLD", 4)) {
+			_folds = (const FoldRow*)p;
+			_num_folds = h.size / sizeof(FoldRow);
+		}
+	}
+
+	if (!found[0] || !found[1] || !found[2] || !found[3]) {
+		err << "Index cache is missing a section\n";
+		return 1;
+	}
+
+	return 0;
+}
+
+StringRef MappedIndex::string(const String &s) const {
+	if (s.offset > _strings_size || s.size > _strings_size - s.offset) {
+		// corrupt file, don't read outside the section
+		return StringRef("", 0);
+	}
+	return StringRef(_strings + s.offset, s.size);
+}
+
+StringRef MappedIndex::entry_key(const size_t i) const {
+	return string(_entries[i].key);
+}
+
+StringRef MappedIndex::entry_name(const size_t i) const {
+	return string(_entries[i].name);
+}
+
+EntryPosition MappedIndex::entry_position(const size_t i) const {
+	const EntryRow &row = _entries[i];
+	return EntryPosition(
+		ByteRangeT(row.file_first, row.file_second),
+		ByteRangeT(row.uncompressed_first, row.uncompressed_second));
+}
+
+StringRef MappedIndex::link_key(const size_t i) const {
+	return string(_links[i].key);
+}
+
+StringRef MappedIndex::link_target(const size_t i) const {
+	return string(_links[i].value);
+}
+
+StringRef MappedIndex::backlink_target(const size_t i) const {
+	return string(_backlinks[i].value);
+}
+
+BlockInfo MappedIndex::block(const size_t i) const {
+	const BlockRow &row = _blocks[i];
+	return BlockInfo(ByteRangeT(row.file_first, row.file_second),
+			 row.uncompressed_size);
+}
+
+StringRef MappedIndex::folded_key(const size_t i) const {
+	return string(_folds[i].key);
+}
+
+size_t MappedIndex::fold_row(const size_t i) const {
+	return _folds[i].row;
+}
+
+bool MappedIndex::fold_is_link(const size_t i) const {
+	return _folds[i].is_link != 0;
+}
+
+/// First row in [lo, hi) for which 'pred' is false. 'pred' must be true for
+/// all rows before those for which it is false.
+template <typename Pred>
+static size_t partition_point(size_t lo, size_t hi, Pred pred) {
+	while (lo < hi) {
+		const size_t mid = lo + (hi-lo)/2;
+		if (pred(mid)) {
+			lo = mid+1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+RowRangeT MappedIndex::entries(const std::string &key) const {
+	const size_t lo = partition_point(0, _num_entries, [&](size_t i) {
+			return compare(entry_key(i), key) < 0;
+		});
+	const size_t hi = partition_point(lo, _num_entries, [&](size_t i) {
+			return compare(entry_key(i), key) == 0;
+		});
+	return RowRangeT(lo, hi);
+}
+
+RowRangeT MappedIndex::entries_with_prefix(const std::string &prefix) const {
+	const size_t lo = partition_point(0, _num_entries, [&](size_t i) {
+			return compare(entry_key(i), prefix) < 0;
+		});
+	const size_t hi = partition_point(lo, _num_entries, [&](size_t i) {
+			return startswith(entry_key(i), prefix);
+		});
+	return RowRangeT(lo, hi);
+}
+
+void MappedIndex::words_with_prefix(
+	const std::string &prefix,
+	RowRangeT &entries,
+	RowRangeT &links
+) const {
+	if (!_trie) {
+		entries = entries_with_prefix(prefix);
+		links = links_with_prefix(prefix);
+		return;
+	}
+
+	entries = links = RowRangeT(0, 0);
+
+	size_t n = 0;
+	size_t pos = 0;
+	while (true) {
+		const TrieNode &node = _trie[n];
+		const StringRef label = string(node.label);
+		const size_t m = std::min(label.size, prefix.size() - pos);
+		if (memcmp(label.data, prefix.data() + pos, m)) {
+			return;
+		}
+		pos += m;
+
+		if (pos == prefix.size()) {
+			// every key below this node starts with 'prefix'
+			entries = RowRangeT(std::min<size_t>(node.entry_first, _num_entries),
+					    std::min<size_t>(node.entry_second, _num_entries));
+			links = RowRangeT(std::min<size_t>(node.link_first, _num_links),
+					  std::min<size_t>(node.link_second, _num_links));
+			return;
+		}
+		// children always come after their parent, so a corrupt file
+		// can't make this loop
+		const size_t lo = node.first_child;
+		const size_t hi = lo + node.num_children;
+		if (lo <= n || hi > _num_trie_nodes) {
+			return;
+		}
+
+		const unsigned char c = prefix[pos];
+		const size_t i = partition_point(lo, hi, [&](size_t i) {
+				const StringRef l = string(_trie[i].label);
+				return l.size && (unsigned char)l.data[0] < c;
+			});
+		if (i == hi) {
+			return;
+		}
+		const StringRef l = string(_trie[i].label);
+		if (!l.size || (unsigned char)l.data[0] != c) {
+			return;
+		}
+		n = i;
+	}
+}
+
+RowRangeT MappedIndex::links_with_prefix(const std::string &prefix) const {
+	const size_t lo = partition_point(0, _num_links, [&](size_t i) {
+			return compare(link_key(i), prefix) < 0;
+		});
+	const size_t hi = partition_point(lo, _num_links, [&](size_t i) {
+			return startswith(link_key(i), prefix);
+		});
+	return RowRangeT(lo, hi);
+}
+
+bool MappedIndex::link(const std::string &key, StringRef &target) const {
+	const size_t i = partition_point(0, _num_links, [&](size_t i) {
+			return compare(link_key(i), key) < 0;
+		});
+	if (i < _num_links && compare(link_key(i), key) == 0) {
+		target = link_target(i);
+		return true;
+	}
+	return false;
+}
+
+RowRangeT MappedIndex::backlinks(const std::string &key) const {
+	const size_t lo = partition_point(0, _num_backlinks, [&](size_t i) {
+			return compare(string(_backlinks[i].key), key) < 0;
+		});
+	const size_t hi = partition_point(lo, _num_backlinks, [&](size_t i) {
+			return compare(string(_backlinks[i].key), key) == 0;
+		});
+	return RowRangeT(lo, hi);
+}
+
+RowRangeT MappedIndex::folds(const std::string &folded) const {
+	const size_t lo = partition_point(0, _num_folds, [&](size_t i) {
+			return compare(folded_key(i), folded) < 0;
+		});
+	const size_t hi = partition_point(lo, _num_folds, [&](size_t i) {
+			return compare(folded_key(i), folded) == 0;
+		});
+	return RowRangeT(lo, hi);
+}
+
+RowRangeT MappedIndex::folds_with_prefix(const std::string &prefix) const {
+	const size_t lo = partition_point(0, _num_folds, [&](size_t i) {
+			return compare(folded_key(i), prefix) < 0;
+		});
+	const size_t hi = partition_point(lo, _num_folds, [&](size_t i) {
+			return startswith(folded_key(i), prefix);
+		});
+	return RowRangeT(lo, hi);
+}
+
+size_t MappedIndex::uncompressed_size(const ByteRangeT &r) const {
+	const size_t i = partition_point(0, _num_blocks, [&](size_t i) {
+			return _blocks[i].file_first < r.first;
+		});
+	if (	i < _num_blocks &&
+		_blocks[i].file_first == r.first &&
+		_blocks[i].file_second == r.second
+	) {
+		return _blocks[i].uncompressed_size;
+	}
+	return 0;
+}
+
+/// Bytes in the UTF-8 sequence that starts with 'c', 1 if it isn't the
+/// start of one
+static inline size_t utf8_length(const unsigned char c) {
+	if (c < 0xc0) {
+		return 1;
+	} else if (c < 0xe0) {
+		return 2;
+	} else if (c < 0xf0) {
+		return 3;
+	} else if (c < 0xf8) {
+		return 4;
+	}
+	return 1;
+}
+
+/// The bytes of a character as one value, so characters compare as ints
+static inline uint32_t pack_char(const char *s, const size_t n) {
+	uint32_t c = 0;
+	for (size_t i=0; i<n; ++i) {
+		c = (c << 8) | (unsigned char)s[i];
+	}
+	return c;
+}
+
+static void split_chars(const char *s, const size_t size, std::vector<uint32_t> &chars) {
+	chars.clear();
+	for (size_t i=0; i<size; ) {
+		const size_t n = std::min(utf8_length(s[i]), size-i);
+		chars.push_back(pack_char(s+i, n));
+		i += n;
+	}
+}
+
+/// One row of the Levenshtein table: 'row' is the distance from each prefix
+/// of 'query' to a word, given 'prev' for the word without its last
+/// character 'c'. Returns false if no word that starts like this one can
+/// be within 'max_distance' of 'query'.
+static bool next_row(
+	const std::vector<uint32_t> &query,
+	const std::vector<unsigned int> &prev,
+	const uint32_t c,
+	const unsigned int max_distance,
+	std::vector<unsigned int> &row
+) {
+	row[0] = prev[0] + 1;
+	unsigned int best = row[0];
+	for (size_t j=1; j<row.size(); ++j) {
+		row[j] = std::min(std::min(prev[j], row[j-1]) + 1,
+				  prev[j-1] + (query[j-1] != c ? 1 : 0));
+		best = std::min(best, row[j]);
+	}
+	return best <= max_distance;
+}
+
+struct MappedIndex::SuggestState {
+	std::vector<uint32_t> query;
+	unsigned int max_distance;
+	std::vector<Suggestion> found;
+};
+
+/// Walk the trie below node 'n' with the Levenshtein table, giving up on
+/// a branch as soon as every word in it is too far from the query.
+/// 'depth' is the bytes of the key matched by the parents, 'row' the last
+/// row of the table, and 'pending' the bytes of a character split between
+/// nodes.
+void MappedIndex::suggest_below(
+	const size_t n,
+	size_t depth,
+	const std::vector<unsigned int> &row,
+	std::string pending,
+	SuggestState &state
+) const {
+	const TrieNode &node = _trie[n];
+	const StringRef label = string(node.label);
+
+	std::vector<unsigned int> cur(row), next(row.size());
+	for (size_t i=0; i<label.size; ++i) {
+		pending += label.data[i];
+		if (pending.size() < utf8_length(pending[0])) {
+			continue;
+		}
+		const uint32_t c = pack_char(pending.data(), pending.size());
+		pending.clear();
+		if (!next_row(state.query, cur, c, state.max_distance, next)) {
+			return;
+		}
+		cur.swap(next);
+	}
+	depth += label.size;
+
+	if (pending.empty() && cur.back() <= state.max_distance) {
+		// the key of the node, if there is one, sorts first
+		Suggestion s;
+		s.distance = cur.back();
+		if (	node.entry_first < node.entry_second &&
+			node.entry_first < _num_entries &&
+			entry_key(node.entry_first).size == depth
+		) {
+			s.row = node.entry_first;
+			s.is_link = false;
+			state.found.push_back(s);
+		} else if (
+			node.link_first < node.link_second &&
+			node.link_first < _num_links &&
+			link_key(node.link_first).size == depth
+		) {
+			s.row = node.link_first;
+			s.is_link = true;
+			state.found.push_back(s);
+		}
+	}
+
+	const size_t lo = node.first_child;
+	const size_t hi = lo + node.num_children;
+	if (lo <= n || hi > _num_trie_nodes) {
+		return;
+	}
+	for (size_t i=lo; i<hi; ++i) {
+		suggest_below(i, depth, cur, pending, state);
+	}
+}
+
+void MappedIndex::suggestions(
+	const std::string &key,
+	const unsigned int max_distance,
+	const size_t max_count,
+	std::vector<Suggestion> &found
+) const {
+	SuggestState state;
+	split_chars(key.data(), key.size(), state.query);
+	state.max_distance = max_distance;
+
+	std::vector<unsigned int> first(state.query.size()+1);
+	for (size_t j=0; j<first.size(); ++j) {
+		first[j] = j;
+	}
+
+	if (_trie) {
+		suggest_below(0, 0, first, std::string(), state);
+	} else {
+		// older files, compare with every key
+		std::vector<uint32_t> chars;
+		std::vector<unsigned int> cur, next(first.size());
+		for (int table=0; table<2; ++table) {
+			const size_t nrows = table ? _num_links : _num_entries;
+			for (size_t i=0; i<nrows; ++i) {
+				const StringRef k = table ? link_key(i) : entry_key(i);
+				if (!table && i > 0) {
+					const StringRef prev = entry_key(i-1);
+					if (prev.size == k.size && !memcmp(prev.data, k.data, k.size)) {
+						continue;
+					}
+				}
+
+				split_chars(k.data, k.size, chars);
+				cur = first;
+				bool close = true;
+				for (size_t c=0; c<chars.size() && close; ++c) {
+					close = next_row(state.query, cur, chars[c], max_distance, next);
+					cur.swap(next);
+				}
+				if (!close || cur.back() > max_distance) {
+					continue;
+				}
+				if (table) {
+					const RowRangeT r = entries(k.str());
+					if (r.first != r.second) {
+						continue;
+					}
+				}
+
+				Suggestion s;
+				s.distance = cur.back();
+				s.row = i;
+				s.is_link = table;
+				state.found.push_back(s);
+			}
+		}
+	}
+
+	const MappedIndex &index = *this;
+	std::sort(state.found.begin(), state.found.end(),
+		  [&index](const Suggestion &a, const Suggestion &b) {
+			  if (a.distance != b.distance) {
+				  return a.distance < b.distance;
+			  }
+			  const StringRef ka = a.is_link ? index.link_key(a.row) : index.entry_key(a.row);
+			  const StringRef kb = b.is_link ? index.link_key(b.row) : index.entry_key(b.row);
+			  const int r = memcmp(ka.data, kb.data, std::min(ka.size, kb.size));
+			  return r ? r < 0 : ka.size < kb.size;
+		  });
+	if (state.found.size() > max_count) {
+		state.found.resize(max_count);
+	}
+	found.swap(state.found);
+}
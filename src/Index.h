@@ -0,0 +1,410 @@
+#ifndef INCLUDED_INDEX_H
+#define INCLUDED_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iosfwd>
+#include <utility>
+#include <cstddef>
+#include <stdint.h>
+#include "MappedFile.h"
+
+typedef std::pair<size_t, size_t> ByteRangeT;
+
+struct EntryPosition {
+	EntryPosition() : file_range(0, 0),
+			  uncompressed_range(0, 0) {}
+	EntryPosition(const ByteRangeT &fr,
+		      const ByteRangeT &ur
+	) : file_range(fr), uncompressed_range(ur) {}
+
+	/// Range of bytes in the compressed file
+	ByteRangeT file_range;
+	/// Range of bytes in the uncompressed block
+	ByteRangeT uncompressed_range;
+};
+
+/// A compressed block of Body.data
+struct BlockInfo {
+	BlockInfo() : file_range(0, 0), uncompressed_size(0) {}
+	BlockInfo(const ByteRangeT &r,
+		  const size_t n
+	) : file_range(r), uncompressed_size(n) {}
+
+	/// Range of bytes of the zlib stream in the compressed file
+	ByteRangeT file_range;
+	/// Size of the inflated block, 0 if not known
+	size_t uncompressed_size;
+};
+
+/// All the blocks of Body.data, in file order
+typedef std::vector<BlockInfo> BlockDirectoryT;
+
+/// Range of rows [first, second) in one of the tables of the index
+typedef std::pair<size_t, size_t> RowRangeT;
+
+/// A key of the index within some edit distance of another
+struct Suggestion {
+	/// Levenshtein distance, counting characters and not bytes
+	unsigned int distance;
+	/// First row of the entries with the key, or the row of the link if
+	/// there are none
+	size_t row;
+	bool is_link;
+};
+
+/// A string in the string pool of the index. Not NUL terminated.
+struct StringRef {
+	StringRef() : data(NULL), size(0) {}
+	StringRef(const char *d, const size_t n) : data(d), size(n) {}
+
+	std::string str() const { return std::string(data, size); }
+
+	const char *data;
+	size_t size;
+};
+
+/// On-disk layout of the version 2 index cache. All values are in the
+/// byte order of the machine that wrote the file.
+///
+/// The file starts with a Header, followed by 'nsections' SectionHeader,
+/// followed by the sections. Each section starts on an 8 byte boundary.
+/// Unknown sections are ignored when reading.
+namespace index_file {
+
+	struct Header {
+		char magic[4];
+		uint8_t version;
+		uint8_t pad[3];
+		uint32_t nsections;
+		uint32_t reserved;
+	};
+
+	struct SectionHeader {
+		char tag[4];
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	/// Offset and length of a string in the "STRS" section
+	struct String {
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	/// Row of the "ENTR" section, sorted by key
+	struct EntryRow {
+		/// Downcased
+		String key;
+		/// Case sensitive
+		String name;
+		uint64_t file_first, file_second;
+		uint64_t uncompressed_first, uncompressed_second;
+	};
+
+	/// Row of the "LINK" section, sorted by key, and the "BLNK"
+	/// section, sorted by key and then the last found first
+	struct PairRow {
+		String key;
+		String value;
+	};
+
+	/// Row of the "BLKS" section, sorted by file_first. Older files
+	/// don't have this section.
+	struct BlockRow {
+		uint64_t file_first, file_second;
+		uint64_t uncompressed_size;
+	};
+
+	/// Node of the "TRIE" section, a radix trie of the keys of the
+	/// entries and the links. The root is the first node, and the
+	/// children of a node are consecutive and sorted by the first byte
+	/// of their label. Older files don't have this section.
+	struct TrieNode {
+		/// Bytes of the key after those of the parent. Only the root
+		/// may have an empty label.
+		String label;
+		uint32_t first_child;
+		uint32_t num_children;
+		/// Rows of the entries and links with a key that starts with
+		/// the labels from the root to this node
+		uint32_t entry_first, entry_second;
+		uint32_t link_first, link_second;
+	};
+
+	/// Row of the "FOLD" section, sorted by key, then the entries before
+	/// the links, then by row. There is one for each distinct key of the
+	/// entries and for each link, with the key folded by fold_key().
+	/// Older files don't have this section.
+	struct FoldRow {
+		String key;
+		/// Of the first entry with the key, or of the link
+		uint32_t row;
+		uint32_t is_link;
+	};
+
+	/// A section to write
+	struct Section {
+		const char *tag;
+		const void *data;
+		size_t size;
+	};
+
+	/// Write a Header with 'magic' and 'version', the section table and
+	/// the sections
+	void write_sections(const char *magic,
+			    const uint8_t version,
+			    const Section *sections,
+			    const size_t nsections,
+			    std::string &out);
+}
+
+/// The entries found while the index is built, stored as columns. The
+/// names are in one buffer, and the text of an entry is left in the
+/// inflated block it was found in, so adding an entry doesn't allocate for
+/// it. The key of an entry is its name downcased, so it isn't stored but
+/// compared as needed. Rows are numbered in the order they were added.
+class EntryTable {
+public:
+	EntryTable() : _num_sorted(0) {}
+
+	/// Start a block. The entries added next are in the block at
+	/// 'file_range', and 'text' is taken as its inflated text. Returns
+	/// the text.
+	const std::string &add_block(const ByteRangeT &file_range, std::string &text);
+	/// Add an entry at 'range' of the last block
+	void add(const std::string &name, const ByteRangeT &range);
+	/// Add an entry without its text, starting a block if it isn't in the
+	/// last one
+	void add(const std::string &name, const EntryPosition &pos);
+	/// Add the entries of 'later' after those of this table. 'later' is
+	/// left empty.
+	void append(EntryTable &later);
+
+	size_t size() const { return _names.size(); }
+	/// Case sensitive
+	StringRef name(const size_t i) const;
+	/// Downcased
+	void key(const size_t i, std::string &out) const;
+	EntryPosition position(const size_t i) const;
+	/// Empty if the text wasn't kept
+	StringRef text(const size_t i) const;
+
+	/// Add the rows added since the last sort() to sorted()
+	void sort();
+	/// Rows sorted by key, and in the order they were added for the same
+	/// key, as of the last sort()
+	const std::vector<uint32_t> &sorted() const { return _sorted; }
+	bool same_key(const size_t a, const size_t b) const;
+	/// True if one of the sorted rows has the key 'key', which is
+	/// downcased
+	bool contains(const std::string &key) const;
+
+private:
+	std::string _strings;
+	std::vector<index_file::String> _names;
+	/// Block of each row, and its range in the inflated block
+	std::vector<uint32_t> _blocks;
+	std::vector<std::pair<uint32_t, uint32_t> > _ranges;
+
+	std::vector<ByteRangeT> _block_ranges;
+	std::vector<std::string> _block_texts;
+
+	std::vector<uint32_t> _sorted;
+	size_t _num_sorted;
+
+	// non-copyable
+	EntryTable(const EntryTable &);
+	EntryTable &operator=(const EntryTable &);
+};
+
+/// Pairs of strings found while the index is built, such as the links,
+/// stored as columns with the strings in one buffer
+class PairTable {
+public:
+	PairTable() {}
+
+	void add(const std::string &key, const std::string &value);
+	/// Add the pairs of 'later' after those of this table
+	void append(const PairTable &later);
+	void clear();
+
+	size_t size() const { return _keys.size(); }
+	StringRef key(const size_t i) const;
+	StringRef value(const size_t i) const;
+
+	/// Which pairs with the same key sort() keeps, in which order
+	enum Ties {
+		/// Only the first added, as map::insert kept
+		TIES_FIRST,
+		/// All, the last added first, as unordered_multimap iterated them
+		TIES_LAST_FIRST
+	};
+
+	/// Sort by key
+	void sort(const Ties ties);
+
+private:
+	std::string _strings;
+	std::vector<index_file::String> _keys;
+	std::vector<index_file::String> _values;
+
+	// non-copyable
+	PairTable(const PairTable &);
+	PairTable &operator=(const PairTable &);
+};
+
+/// Collects the tables of the index, and writes them as a version 2
+/// index cache.
+class IndexBuilder {
+public:
+	IndexBuilder() : _strings_overflow(false) {}
+
+	/// Entries must be added sorted by key
+	void add_entry(const std::string &key,
+		       const std::string &name,
+		       const EntryPosition &pos);
+	/// Links must be added sorted by key
+	void add_link(const std::string &key, const std::string &target);
+	/// Backlinks may be added in any order. Those with the same key
+	/// keep the order they were added in.
+	void add_backlink(const std::string &key, const std::string &target);
+	/// Blocks must be added in file order
+	void add_block(const BlockInfo &block);
+
+	/// Returns non-zero, and writes a message to 'err', if the index
+	/// can't be written
+	int write(std::string &out, std::ostream &err);
+
+private:
+	std::string _strings;
+	/// Set if a string didn't fit in the 4 GiB that the 32 bit offsets
+	/// of the strings can address
+	bool _strings_overflow;
+	std::unordered_map<std::string, index_file::String> _string_offsets;
+	std::vector<index_file::EntryRow> _entries;
+	std::vector<index_file::PairRow> _links;
+	std::vector<index_file::PairRow> _backlinks;
+	std::vector<index_file::BlockRow> _blocks;
+
+	std::vector<index_file::TrieNode> _trie;
+	std::vector<index_file::FoldRow> _folds;
+
+	index_file::String add_string(const std::string &s);
+	void build_trie();
+	void build_folds();
+
+	// non-copyable
+	IndexBuilder(const IndexBuilder &);
+	IndexBuilder &operator=(const IndexBuilder &);
+};
+
+/// The version 2 index cache, queried in place. The file is mapped with
+/// mmap, so opening it doesn't depend on its size and the pages are shared
+/// between processes.
+class MappedIndex {
+public:
+	MappedIndex();
+	~MappedIndex();
+
+	/// Returns 0 on success, 2 if the file is an older version of the
+	/// index cache which should be upgraded, and 1 for other errors.
+	int open(const std::string &fn, std::ostream &err);
+	/// Take the contents of 'data' as the index, instead of a file
+	int assign(std::string &data, std::ostream &err);
+
+	size_t num_entries() const { return _num_entries; }
+	size_t num_links() const { return _num_links; }
+	size_t num_backlinks() const { return _num_backlinks; }
+	/// 0 if the index was written before the block directory was stored
+	size_t num_blocks() const { return _num_blocks; }
+	/// 0 if the index was written before the folded keys were stored
+	size_t num_folds() const { return _num_folds; }
+
+	/// Downcased
+	StringRef entry_key(const size_t i) const;
+	/// Case sensitive
+	StringRef entry_name(const size_t i) const;
+	EntryPosition entry_position(const size_t i) const;
+
+	StringRef link_key(const size_t i) const;
+	StringRef link_target(const size_t i) const;
+	StringRef backlink_target(const size_t i) const;
+	BlockInfo block(const size_t i) const;
+	StringRef folded_key(const size_t i) const;
+	/// Row of the entry or link of the folded key
+	size_t fold_row(const size_t i) const;
+	bool fold_is_link(const size_t i) const;
+
+	/// Entries for which the key is 'key'
+	RowRangeT entries(const std::string &key) const;
+	/// Entries and links for which 'prefix' is a prefix of the key, in
+	/// time that depends on the length of 'prefix' and not the size of
+	/// the index
+	void words_with_prefix(const std::string &prefix,
+			       RowRangeT &entries,
+			       RowRangeT &links) const;
+	/// Entries for which 'prefix' is a prefix of the key
+	RowRangeT entries_with_prefix(const std::string &prefix) const;
+	/// Links for which 'prefix' is a prefix of the key
+	RowRangeT links_with_prefix(const std::string &prefix) const;
+	/// Returns true if 'key' is a link, and sets 'target' to the key of the
+	/// entries it links to
+	bool link(const std::string &key, StringRef &target) const;
+	/// Backlinks for which the key is 'key'
+	RowRangeT backlinks(const std::string &key) const;
+	/// Folded keys which are 'folded'
+	RowRangeT folds(const std::string &folded) const;
+	/// Folded keys for which 'prefix' is a prefix
+	RowRangeT folds_with_prefix(const std::string &prefix) const;
+	/// The keys of entries and links within 'max_distance' edits of
+	/// 'key', closest first, and in key order for the same distance. At
+	/// most 'max_count' are returned.
+	void suggestions(const std::string &key,
+			 const unsigned int max_distance,
+			 const size_t max_count,
+			 std::vector<Suggestion> &found) const;
+	/// Inflated size of the block at 'r', 0 if not known
+	size_t uncompressed_size(const ByteRangeT &r) const;
+
+private:
+	/// Set if the index was read from a file
+	MappedFile _file;
+	/// Set if the index was assigned from memory
+	std::string _data;
+
+	const char *_strings;
+	size_t _strings_size;
+	const index_file::EntryRow *_entries;
+	size_t _num_entries;
+	const index_file::PairRow *_links;
+	size_t _num_links;
+	const index_file::PairRow *_backlinks;
+	size_t _num_backlinks;
+	const index_file::BlockRow *_blocks;
+	size_t _num_blocks;
+	const index_file::TrieNode *_trie;
+	size_t _num_trie_nodes;
+	const index_file::FoldRow *_folds;
+	size_t _num_folds;
+
+	int parse(const char *data, const size_t size, std::ostream &err);
+	void close();
+
+	StringRef string(const index_file::String &s) const;
+
+	struct SuggestState;
+	void suggest_below(const size_t n,
+			   size_t depth,
+			   const std::vector<unsigned int> &row,
+			   std::string pending,
+			   SuggestState &state) const;
+
+	// non-copyable
+	MappedIndex(const MappedIndex &);
+	MappedIndex &operator=(const MappedIndex &);
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "Inflate.h"
+#include <zlib.h>
+#include "InflateStream.h"
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#ifdef HAVE_ZLIB_NG
+// in InflateNg.cpp, since zlib-ng.h can't be included with zlib.h
+int inflate_stream_zlib_ng(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *sink,
+	unsigned char *fixed,
+	const size_t fixed_size,
+	size_t *produced);
+#endif
+
+static InflateBackend g_inflate_backend = INFLATE_ZLIB;
+
+static const InflateBackend g_backends[] = {
+	INFLATE_ZLIB,
+	INFLATE_ZLIB_NG,
+	INFLATE_LIBDEFLATE,
+};
+
+const char *inflate_backend_name(const InflateBackend b) {
+	switch (b) {
+	case INFLATE_ZLIB:
+		return "zlib";
+	case INFLATE_ZLIB_NG:
+		return "zlib-ng";
+	case INFLATE_LIBDEFLATE:
+		return "libdeflate";
+	}
+	return "unknown";
+}
+
+bool inflate_backend_available(const InflateBackend b) {
+	switch (b) {
+	case INFLATE_ZLIB:
+		return true;
+	case INFLATE_ZLIB_NG:
+#ifdef HAVE_ZLIB_NG
+		return true;
+#else
+		return false;
+#endif
+	case INFLATE_LIBDEFLATE:
+#ifdef HAVE_LIBDEFLATE
+		return true;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+int inflate_backend_from_name(const std::string &name, InflateBackend &b) {
+	for (size_t i=0; i<sizeof(g_backends)/sizeof(g_backends[0]); ++i) {
+		if (name == inflate_backend_name(g_backends[i]) &&
+		    inflate_backend_available(g_backends[i])
+		) {
+			b = g_backends[i];
+			return 0;
+		}
+	}
+	return 1;
+}
+
+std::string inflate_backends_available() {
+	std::string r;
+	for (size_t i=0; i<sizeof(g_backends)/sizeof(g_backends[0]); ++i) {
+		if (inflate_backend_available(g_backends[i])) {
+			if (!r.empty()) {
+				r += ", ";
+			}
+			r += inflate_backend_name(g_backends[i]);
+		}
+	}
+	return r;
+}
+
+void set_inflate_backend(const InflateBackend b) {
+	g_inflate_backend = b;
+}
+
+InflateBackend inflate_backend() {
+	return g_inflate_backend;
+}
+
+struct ZlibApi {
+	typedef z_stream stream;
+	static int init(stream *s) { return inflateInit(s); }
+	static int inflate(stream *s) { return ::inflate(s, Z_NO_FLUSH); }
+	static void end(stream *s) { inflateEnd(s); }
+};
+
+#ifdef HAVE_LIBDEFLATE
+
+/// One decompressor per thread, they aren't thread safe
+struct LibdeflateDecompressor {
+	LibdeflateDecompressor() : d(libdeflate_alloc_decompressor()) {}
+	~LibdeflateDecompressor() {
+		if (d) {
+			libdeflate_free_decompressor(d);
+		}
+	}
+	libdeflate_decompressor *d;
+};
+
+/// libdeflate needs room for all of the output, so grow 'buf' until the
+/// stream fits
+static int inflate_libdeflate_grow(
+	libdeflate_decompressor *d,
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string &buf
+) {
+	buf.resize(std::max(buf.capacity(), inflated_size_guess(nbytes)));
+	while (true) {
+		size_t in_size = 0, out_size = 0;
+		const libdeflate_result r = libdeflate_zlib_decompress_ex(
+			d, in, nbytes, &buf[0], buf.size(), &in_size, &out_size);
+		if (r == LIBDEFLATE_SUCCESS) {
+			buf.resize(out_size);
+			if (consumed) {
+				*consumed = in_size;
+			}
+			return 0;
+		}
+		if (r != LIBDEFLATE_INSUFFICIENT_SPACE || buf.size() > ((size_t)1 << 32)) {
+			buf.clear();
+			return 1;
+		}
+		buf.resize(buf.size()*2);
+	}
+}
+
+static int inflate_libdeflate(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *sink,
+	unsigned char *fixed,
+	const size_t fixed_size,
+	size_t *produced
+) {
+	static thread_local LibdeflateDecompressor decompressor;
+	if (!decompressor.d) {
+		return 1;
+	}
+
+	if (fixed) {
+		size_t in_size = 0, out_size = 0;
+		if (libdeflate_zlib_decompress_ex(
+			    decompressor.d, in, nbytes, fixed, fixed_size,
+			    &in_size, &out_size) != LIBDEFLATE_SUCCESS
+		) {
+			return 1;
+		}
+		if (consumed) {
+			*consumed = in_size;
+		}
+		if (produced) {
+			*produced = out_size;
+		}
+		return 0;
+	}
+
+	if (sink) {
+		return inflate_libdeflate_grow(decompressor.d, in, nbytes, consumed, *sink);
+	}
+
+	// discarding, but libdeflate still needs somewhere to put it
+	static thread_local std::string scratch;
+	return inflate_libdeflate_grow(decompressor.d, in, nbytes, consumed, scratch);
+}
+
+#endif
+
+static int inflate_any(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *sink,
+	unsigned char *fixed,
+	const size_t fixed_size,
+	size_t *produced
+) {
+	switch (g_inflate_backend) {
+#ifdef HAVE_ZLIB_NG
+	case INFLATE_ZLIB_NG:
+		return inflate_stream_zlib_ng(in, nbytes, consumed, sink, fixed, fixed_size, produced);
+#endif
+#ifdef HAVE_LIBDEFLATE
+	case INFLATE_LIBDEFLATE:
+		return inflate_libdeflate(in, nbytes, consumed, sink, fixed, fixed_size, produced);
+#endif
+	default:
+		return inflate_stream<ZlibApi>(in, nbytes, consumed, sink, fixed, fixed_size, produced);
+	}
+}
+
+int inflate_block(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *out
+) {
+	return inflate_any(in, nbytes, consumed, out, NULL, 0, NULL);
+}
+
+int inflate_block(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	unsigned char *out,
+	const size_t out_size,
+	size_t &produced
+) {
+	return inflate_any(in, nbytes, consumed, NULL, out, out_size, &produced);
+}
@@ -0,0 +1,54 @@
+#ifndef INCLUDED_INFLATE_H
+#define INCLUDED_INFLATE_H
+
+#include <string>
+#include <cstddef>
+
+/// Libraries which can inflate the zlib streams in Body.data. Which ones
+/// are available is decided at build time, and one of those is chosen at
+/// runtime with set_inflate_backend.
+enum InflateBackend {
+	INFLATE_ZLIB,
+	/// Native API of zlib-ng, if built with HAVE_ZLIB_NG
+	INFLATE_ZLIB_NG,
+	/// Whole buffer decoder of libdeflate, if built with HAVE_LIBDEFLATE
+	INFLATE_LIBDEFLATE
+};
+
+const char *inflate_backend_name(const InflateBackend b);
+bool inflate_backend_available(const InflateBackend b);
+/// Returns non-zero if 'name' isn't a backend that was built in
+int inflate_backend_from_name(const std::string &name, InflateBackend &b);
+/// Comma separated names of the backends that were built in
+std::string inflate_backends_available();
+
+/// Used by all threads. Should be set before any inflating starts.
+void set_inflate_backend(const InflateBackend b);
+InflateBackend inflate_backend();
+
+/// Inflate one zlib stream from the 'nbytes' at 'in', which may be followed
+/// by other data. If 'consumed' is set it gets the size of the compressed
+/// stream. 'out' is replaced with the inflated data; its capacity, if any,
+/// is used as the first guess for the size. If 'out' is NULL the data is
+/// discarded, which is enough to find where the stream ends.
+///
+/// Returns non-zero if there isn't a valid stream at 'in'.
+int inflate_block(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *out);
+
+/// Inflate one zlib stream into 'out', which has room for 'out_size'
+/// bytes, e.g. when the inflated size is known. Sets 'produced' to the
+/// size of the inflated data. Returns non-zero on error, or if the data
+/// doesn't fit.
+int inflate_block(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	unsigned char *out,
+	const size_t out_size,
+	size_t &produced);
+
+#endif
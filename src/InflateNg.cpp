@@ -0,0 +1,27 @@
+// zlib-ng backend of Inflate.h, see Inflate.cpp
+
+#ifdef HAVE_ZLIB_NG
+
+#include <zlib-ng.h>
+#include "InflateStream.h"
+
+struct ZlibNgApi {
+	typedef zng_stream stream;
+	static int init(stream *s) { return zng_inflateInit(s); }
+	static int inflate(stream *s) { return zng_inflate(s, Z_NO_FLUSH); }
+	static void end(stream *s) { zng_inflateEnd(s); }
+};
+
+int inflate_stream_zlib_ng(
+	const unsigned char *in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *sink,
+	unsigned char *fixed,
+	const size_t fixed_size,
+	size_t *produced
+) {
+	return inflate_stream<ZlibNgApi>(in, nbytes, consumed, sink, fixed, fixed_size, produced);
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef INCLUDED_INFLATESTREAM_H
+#define INCLUDED_INFLATESTREAM_H
+
+// Streaming inflate shared by the zlib and zlib-ng backends. Include after
+// zlib.h or zlib-ng.h, which define the same Z_ constants but can't both be
+// included in one file. 'Api' wraps the stream type and functions.
+
+#include <string>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+/// First guess at the inflated size of 'nbytes' of compressed data
+static inline size_t inflated_size_guess(const size_t nbytes) {
+	return std::max((size_t)4096, std::min(nbytes, (size_t)1 << 20) * 4);
+}
+
+/// See inflate_block. Exactly one of 'sink' and 'fixed' may be set, or
+/// neither to discard the output.
+template <typename Api>
+static int inflate_stream(
+	const unsigned char * const in,
+	const size_t nbytes,
+	size_t *consumed,
+	std::string *sink,
+	unsigned char *fixed,
+	const size_t fixed_size,
+	size_t *produced
+) {
+	typename Api::stream zst;
+	memset(&zst, 0, sizeof(zst));
+	if (Api::init(&zst) != Z_OK) {
+		return 1;
+	}
+
+	unsigned char scratch[16384];
+	unsigned char *out;
+	size_t out_size;
+	if (sink) {
+		out_size = std::max(sink->capacity(), inflated_size_guess(nbytes));
+		sink->resize(out_size);
+		out = (unsigned char*)&(*sink)[0];
+	} else if (fixed) {
+		out = fixed;
+		out_size = fixed_size;
+	} else {
+		out = scratch;
+		out_size = sizeof(scratch);
+	}
+
+	// avail_in and avail_out are 32 bits
+	size_t in_left = nbytes, out_left = out_size;
+	zst.next_in = const_cast<unsigned char*>(in);
+	zst.avail_in = 0;
+	zst.next_out = out;
+	zst.avail_out = 0;
+
+	int ret;
+	while (true) {
+		if (zst.avail_in == 0 && in_left) {
+			zst.avail_in = std::min(in_left, (size_t)UINT_MAX);
+			in_left -= zst.avail_in;
+		}
+		if (zst.avail_out == 0) {
+			if (!out_left && sink) {
+				// grow, the stream position is the end of the string
+				const size_t have = sink->size();
+				sink->resize(have*2);
+				out = (unsigned char*)&(*sink)[0];
+				zst.next_out = out + have;
+				out_left = have;
+			} else if (!out_left && !fixed) {
+				zst.next_out = scratch;
+				out_left = sizeof(scratch);
+			}
+			zst.avail_out = std::min(out_left, (size_t)UINT_MAX);
+			out_left -= zst.avail_out;
+		}
+
+		ret = Api::inflate(&zst);
+		if (ret == Z_STREAM_END) {
+			break;
+		}
+		if (ret == Z_OK) {
+			continue;
+		}
+		if (	ret == Z_BUF_ERROR &&
+			((zst.avail_in == 0 && in_left) ||
+			 (zst.avail_out == 0 && (out_left || sink || !fixed)))
+		) {
+			// more input or output space is on the way
+			continue;
+		}
+		// corrupt, truncated, or doesn't fit in 'fixed'
+		Api::end(&zst);
+		if (sink) {
+			sink->clear();
+		}
+		return 1;
+	}
+
+	if (consumed) {
+		*consumed = zst.next_in - in;
+	}
+	const size_t total_out = (size_t)zst.total_out;
+	if (produced) {
+		*produced = total_out;
+	}
+	if (sink) {
+		sink->resize(total_out);
+	}
+
+	Api::end(&zst);
+	return 0;
+}
+
+#endif
@@ -17,6 +17,10 @@ void LineEdit::keyPressEvent(QKeyEvent *event) {
 	} else if (event->key() == Qt::Key_W && alt) {
 		event->ignore();
 
+	} else if ((event->key() == Qt::Key_Left || event->key() == Qt::Key_Right) && alt) {
+		// back and forward in the window
+		event->ignore();
+
 	} else if (event->key() == Qt::Key_F && ctrl) {
 		cursorForward(false);
 
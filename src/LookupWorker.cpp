@@ -0,0 +1,188 @@
+#include "LookupWorker.h"
+#include "Dictionary.h"
+#include <sstream>
+
+LookupWorker::LookupWorker(
+	const DictionaryRef &dict,
+	QObject *parent
+) : QObject(parent),
+    _dict(dict),
+    _last_id(0),
+    _busy(false),
+    _list_busy(false),
+    _prefetch_dark(false),
+    _stop(false)
+{
+	_thread = std::thread(&LookupWorker::run, this);
+	_list_thread = std::thread(&LookupWorker::run_list, this);
+	_prefetch_thread = std::thread(&LookupWorker::run_prefetch, this);
+}
+
+LookupWorker::~LookupWorker() {
+	stop();
+}
+
+/// Called with the lock held
+unsigned int LookupWorker::next_id() {
+	if (++_last_id == 0) {
+		++_last_id;
+	}
+	return _last_id;
+}
+
+unsigned int LookupWorker::request(const std::string &word, const bool dark) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending.id = next_id();
+	_pending.word = word;
+	_pending.dark = dark;
+	_cond.notify_all();
+	return _pending.id;
+}
+
+void LookupWorker::cancel() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending = Request();
+}
+
+unsigned int LookupWorker::request_list(const ListKind kind, const std::string &text) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_list_pending.id = next_id();
+	_list_pending.word = text;
+	_list_pending.kind = kind;
+	_cond.notify_all();
+	return _list_pending.id;
+}
+
+void LookupWorker::cancel_list() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_list_pending = Request();
+}
+
+void LookupWorker::prefetch(const std::vector<std::string> &words, const bool dark) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_prefetch.assign(words.begin(), words.end());
+	_prefetch_dark = dark;
+	_cond.notify_all();
+}
+
+void LookupWorker::stop() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+		_cond.notify_all();
+	}
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	if (_list_thread.joinable()) {
+		_list_thread.join();
+	}
+	if (_prefetch_thread.joinable()) {
+		_prefetch_thread.join();
+	}
+}
+
+bool LookupWorker::pending_is_prefetching() const {
+	return !_prefetching.word.empty() &&
+		_prefetching.word == _pending.word &&
+		_prefetching.dark == _pending.dark;
+}
+
+void LookupWorker::run() {
+	init_lookup_thread();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		// the page of a word being prefetched will be in the cache
+		_cond.wait(lock, [this]() {
+			return _stop || (_pending.id && !pending_is_prefetching());
+		});
+		if (_stop) {
+			return;
+		}
+
+		Request r;
+		std::swap(r, _pending);
+		_busy = true;
+		lock.unlock();
+
+		std::ostringstream out, err;
+		const bool ok = 0 == output_definition(_dict, r.word, true, r.dark, out, err);
+		const std::string text = ok ? out.str() : err.str();
+		emit rendered(r.id, ok, QString::fromUtf8(text.c_str()));
+
+		lock.lock();
+		_busy = false;
+		_cond.notify_all();
+	}
+}
+
+static void add_word(const std::string &word, void *data) {
+	QStringList &words = *(QStringList*)data;
+	words.append(QString::fromUtf8(word.c_str()));
+}
+
+void LookupWorker::run_list() {
+	init_lookup_thread();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_cond.wait(lock, [this]() { return _stop || _list_pending.id; });
+		if (_stop) {
+			return;
+		}
+
+		Request r;
+		std::swap(r, _list_pending);
+		_list_busy = true;
+		lock.unlock();
+
+		QStringList words;
+		std::ostringstream err;
+		bool ok = true;
+		if (r.kind == LIST_SEARCH) {
+			ok = 0 == search_words(_dict, r.word, add_word, &words, err);
+		} else {
+			suggest_words(_dict, r.word, add_word, &words);
+		}
+		std::string error = err.str();
+		strip(error);
+		emit listed(r.id, ok, words, QString::fromUtf8(error.c_str()));
+
+		lock.lock();
+		_list_busy = false;
+		_cond.notify_all();
+	}
+}
+
+void LookupWorker::run_prefetch() {
+	init_lookup_thread();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_cond.wait(lock, [this]() {
+			return _stop || (
+				!_pending.id && !_busy &&
+				!_list_pending.id && !_list_busy &&
+				!_prefetch.empty());
+		});
+		if (_stop) {
+			return;
+		}
+
+		const std::string word = _prefetch.front();
+		const bool dark = _prefetch_dark;
+		_prefetch.pop_front();
+		_prefetching.word = word;
+		_prefetching.dark = dark;
+		lock.unlock();
+
+		// only for the cache
+		std::ostringstream out, err;
+		output_definition(_dict, word, true, dark, out, err);
+
+		lock.lock();
+		_prefetching = Request();
+		_cond.notify_all();
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef INCLUDED_LOOKUPWORKER_H
+#define INCLUDED_LOOKUPWORKER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct DictionaryRef;
+
+/// Renders definitions on a thread of its own, so the window never waits
+/// for them. Only the latest request matters: one made while another is
+/// waiting replaces it, and rendered() tells which request a page is for,
+/// so pages of requests which were superseded while they were rendered
+/// can be dropped.
+///
+/// The words of a full-text search, or those spelt like a word which
+/// isn't in the dictionary, are found on another thread the same way,
+/// and listed() tells which request they are for.
+///
+/// A third thread renders the definitions likely to be asked for next,
+/// only while nothing is asked for. Their pages are kept by the cache of
+/// rendered definitions, so asking for them later is quick. A request for
+/// the word being prefetched waits for it, and takes its page from the
+/// cache, rather than rendering it a second time.
+class LookupWorker : public QObject {
+Q_OBJECT
+public:
+	/// Words request_list() finds
+	enum ListKind {
+		/// Matching a full-text query
+		LIST_SEARCH,
+		/// Spelt like a word, closest first
+		LIST_SUGGEST
+	};
+
+	LookupWorker(const DictionaryRef &dict, QObject *parent = NULL);
+	virtual ~LookupWorker();
+
+	/// Render the definition of 'word'. Returns the id rendered() will be
+	/// emitted with, which is never 0.
+	unsigned int request(const std::string &word, const bool dark);
+	/// Drop the request waiting to be rendered, if any
+	void cancel();
+	/// Find the words of 'kind' for 'text'. Returns the id listed() will
+	/// be emitted with, which is never 0.
+	unsigned int request_list(const ListKind kind, const std::string &text);
+	/// Drop the list request waiting, if any
+	void cancel_list();
+	/// Render 'words' in order when idle, instead of those of the last
+	/// call
+	void prefetch(const std::vector<std::string> &words, const bool dark);
+	/// Finish the thread. Nothing is rendered after this.
+	void stop();
+
+signals:
+	/// Emitted on the thread of the worker, so it should be connected
+	/// with a queued connection. 'text' is the page if 'ok' is set,
+	/// otherwise the error.
+	void rendered(unsigned int id, bool ok, const QString &text);
+	/// Like rendered(). 'error' is set if 'ok' isn't.
+	void listed(unsigned int id, bool ok, const QStringList &words, const QString &error);
+
+private:
+	struct Request {
+		Request() : id(0), dark(false), kind(LIST_SEARCH) {}
+
+		unsigned int id;
+		std::string word;
+		bool dark;
+		/// Of a list request
+		ListKind kind;
+	};
+
+	const DictionaryRef &_dict;
+	std::thread _thread;
+	std::thread _list_thread;
+	std::thread _prefetch_thread;
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	/// Waiting to be rendered if its id isn't 0
+	Request _pending;
+	unsigned int _last_id;
+	/// A request is being rendered
+	bool _busy;
+	/// List request waiting if its id isn't 0
+	Request _list_pending;
+	/// A list request is being worked on
+	bool _list_busy;
+	std::deque<std::string> _prefetch;
+	bool _prefetch_dark;
+	/// Being prefetched, if it isn't empty
+	Request _prefetching;
+	bool _stop;
+
+	/// The pending request is for the word being prefetched. Called
+	/// with the lock held.
+	bool pending_is_prefetching() const;
+
+	unsigned int next_id();
+	void run();
+	void run_list();
+	void run_prefetch();
+
+	// non-copyable
+	LookupWorker(const LookupWorker &);
+	LookupWorker &operator=(const LookupWorker &);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef INCLUDED_LRUCACHE_H
+#define INCLUDED_LRUCACHE_H
+
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+
+/// Least recently used cache of shared items, limited by the total of
+/// their size() in bytes. 'KeyT' must have operator<. Thread safe.
+template <typename KeyT, typename ItemT>
+class LruCache {
+public:
+	typedef std::shared_ptr<const ItemT> PtrT;
+
+	struct Stats {
+		Stats() : hits(0), misses(0), evictions(0), bytes(0), items(0) {}
+
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		/// Current size of the cached items
+		size_t bytes;
+		size_t items;
+	};
+
+	/// 'capacity' is the maximum total size of the items in bytes. Zero
+	/// disables the cache.
+	explicit LruCache(const size_t capacity)
+		: _capacity(capacity)
+	{}
+
+	/// Returns the cached item, or NULL on a miss
+	PtrT get(const KeyT &key) {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		const typename MapT::iterator it = _map.find(key);
+		if (it == _map.end()) {
+			++_stats.misses;
+			return PtrT();
+		}
+		++_stats.hits;
+		_lru.splice(_lru.begin(), _lru, it->second);
+		return it->second->second;
+	}
+
+	/// Add an item, evicting the least recently used ones if over
+	/// capacity
+	void put(const KeyT &key, const PtrT &item) {
+		if (!item || item->size() > _capacity) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (_map.find(key) != _map.end()) {
+			// another thread made the same item
+			return;
+		}
+
+		_lru.push_front(typename ListT::value_type(key, item));
+		_map.insert(typename MapT::value_type(key, _lru.begin()));
+		_stats.bytes += item->size();
+		++_stats.items;
+
+		while (_stats.bytes > _capacity) {
+			const typename ListT::iterator last = --_lru.end();
+			_stats.bytes -= last->second->size();
+			--_stats.items;
+			++_stats.evictions;
+			_map.erase(last->first);
+			_lru.erase(last);
+		}
+	}
+
+	/// Evict all the items
+	void clear() {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_stats.evictions += _stats.items;
+		_stats.bytes = 0;
+		_stats.items = 0;
+		_map.clear();
+		_lru.clear();
+	}
+
+	/// Count a miss for a lookup that was answered without the cache
+	void count_miss() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_stats.misses;
+	}
+
+	size_t capacity() const { return _capacity; }
+
+	Stats stats() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _stats;
+	}
+
+private:
+	typedef std::list<std::pair<KeyT, PtrT> > ListT;
+	typedef std::map<KeyT, typename ListT::iterator> MapT;
+
+	const size_t _capacity;
+	mutable std::mutex _mutex;
+	/// Most recently used at the front
+	ListT _lru;
+	MapT _map;
+	Stats _stats;
+
+	// non-copyable
+	LruCache(const LruCache &);
+	LruCache &operator=(const LruCache &);
+};
+
+#endif
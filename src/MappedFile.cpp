@@ -0,0 +1,75 @@
+#include "MappedFile.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile()
+	: _data(NULL),
+	  _size(0),
+	  _open(false)
+{}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+int MappedFile::open(const std::string &fn, std::ostream &err) {
+	close();
+
+	const int fd = ::open(fn.c_str(), O_RDONLY);
+	if (fd < 0) {
+		err << "Failed to open \"" << fn << "\"\n";
+		return 1;
+	}
+	struct stat s;
+	if (fstat(fd, &s)) {
+		err << "Failed to stat \"" << fn << "\"\n";
+		::close(fd);
+		return 1;
+	}
+
+	// mmap fails for an empty file
+	if (s.st_size > 0) {
+		void * const map = mmap(NULL, s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED) {
+			err << "Failed to mmap \"" << fn << "\"\n";
+			::close(fd);
+			return 1;
+		}
+		_data = (const unsigned char*)map;
+		_size = s.st_size;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+	_open = true;
+	return 0;
+}
+
+void MappedFile::close() {
+	if (_data) {
+		munmap(const_cast<unsigned char*>(_data), _size);
+	}
+	_data = NULL;
+	_size = 0;
+	_open = false;
+}
+
+void MappedFile::advise(const Advice advice) const {
+	if (!_data) {
+		return;
+	}
+	int a = MADV_NORMAL;
+	switch (advice) {
+	case SEQUENTIAL:
+		a = MADV_SEQUENTIAL;
+		break;
+	case RANDOM:
+		a = MADV_RANDOM;
+		break;
+	}
+	// only a hint, failure doesn't matter
+	madvise(const_cast<unsigned char*>(_data), _size, a);
+}
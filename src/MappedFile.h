@@ -0,0 +1,42 @@
+#ifndef INCLUDED_MAPPEDFILE_H
+#define INCLUDED_MAPPEDFILE_H
+
+#include <string>
+#include <iosfwd>
+#include <cstddef>
+
+/// A whole file mapped read-only with mmap
+class MappedFile {
+public:
+	enum Advice {
+		/// Read once from start to end, e.g. building the index
+		SEQUENTIAL,
+		/// Read small ranges in no particular order, e.g. lookups
+		RANDOM
+	};
+
+	MappedFile();
+	~MappedFile();
+
+	/// Returns non-zero on failure
+	int open(const std::string &fn, std::ostream &err);
+	void close();
+
+	/// Tell the kernel how the pages will be read
+	void advise(const Advice advice) const;
+
+	const unsigned char *data() const { return _data; }
+	size_t size() const { return _size; }
+	bool is_open() const { return _open; }
+
+private:
+	const unsigned char *_data;
+	size_t _size;
+	bool _open;
+
+	// non-copyable
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "PageCache.h"
+
+PageCache::PageCache(const size_t capacity)
+	: _generation(0),
+	  _pages(capacity)
+{}
+
+bool PageCache::use_generation(const unsigned int generation) {
+	if (generation < _generation) {
+		return false;
+	}
+	if (generation > _generation) {
+		_pages.clear();
+		_generation = generation;
+	}
+	return true;
+}
+
+PageCache::PageT PageCache::get(const Key &key, const unsigned int generation) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (!use_generation(generation)) {
+		_pages.count_miss();
+		return PageT();
+	}
+	return _pages.get(key);
+}
+
+void PageCache::put(const Key &key, const unsigned int generation, const PageT &page) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (!use_generation(generation)) {
+		// rendered from an older index
+		return;
+	}
+	_pages.put(key, page);
+}
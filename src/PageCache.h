@@ -0,0 +1,70 @@
+#ifndef INCLUDED_PAGECACHE_H
+#define INCLUDED_PAGECACHE_H
+
+#include "LruCache.h"
+#include <string>
+#include <mutex>
+
+/// Least recently used cache of rendered definitions, keyed by the word
+/// as it was looked up and how the page was rendered. The pages are from
+/// one generation of the index, and are dropped when a newer one is used.
+/// Thread safe.
+class PageCache {
+public:
+	struct Key {
+		Key(const std::string &w,
+		    const bool d,
+		    const bool e
+		) : word(w), dark(d), embed_css(e) {}
+
+		std::string word;
+		bool dark;
+		/// The stylesheet is embedded rather than linked
+		bool embed_css;
+
+		bool operator<(const Key &o) const {
+			if (word != o.word) {
+				return word < o.word;
+			}
+			if (dark != o.dark) {
+				return dark < o.dark;
+			}
+			return embed_css < o.embed_css;
+		}
+	};
+
+	typedef LruCache<Key, std::string> PagesT;
+	typedef PagesT::PtrT PageT;
+	typedef PagesT::Stats Stats;
+
+	/// 'capacity' is the maximum total size of the pages in bytes. Zero
+	/// disables the cache.
+	explicit PageCache(const size_t capacity);
+
+	/// Returns the cached page, or NULL on a miss. 'generation' is that
+	/// of the index the page would be rendered from.
+	PageT get(const Key &key, const unsigned int generation);
+	/// Add a page rendered from the index of 'generation', evicting the
+	/// least recently used ones if over capacity
+	void put(const Key &key, const unsigned int generation, const PageT &page);
+
+	size_t capacity() const { return _pages.capacity(); }
+	Stats stats() const { return _pages.stats(); }
+
+private:
+	/// Guards '_generation', so that pages of an older index are not
+	/// added after a newer one was seen
+	std::mutex _mutex;
+	unsigned int _generation;
+	PagesT _pages;
+
+	/// Drop the pages if 'generation' is newer than theirs. Returns false
+	/// if it is older.
+	bool use_generation(const unsigned int generation);
+
+	// non-copyable
+	PageCache(const PageCache &);
+	PageCache &operator=(const PageCache &);
+};
+
+#endif
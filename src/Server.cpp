@@ -0,0 +1,794 @@
+#include "Server.h"
+#include "Dictionary.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/// Connections without any traffic for this long are closed, in seconds
+static const double g_idle_timeout = 60;
+/// Requests with headers bigger than this are refused
+static const size_t g_max_request_size = 64 << 10;
+/// Number of recent latencies kept for the percentiles
+static const size_t g_recent_latencies = 4096;
+/// Window for the QPS stats, in seconds
+static const int g_qps_window = 60;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void stop_handler(int) {
+	g_stop = 1;
+}
+
+static double now_seconds() {
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int set_nonblocking(const int fd) {
+	const int flags = fcntl(fd, F_GETFL, 0);
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		return 1;
+	}
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	return 0;
+}
+
+static inline void downcase_ascii(std::string &s) {
+	for (size_t i=0; i<s.size(); ++i) {
+		if (s[i] >= 'A' && s[i] <= 'Z') {
+			s[i] = s[i]-'A'+'a';
+		}
+	}
+}
+
+static inline int hex_value(const char c) {
+	if (c >= '0' && c <= '9') {
+		return c-'0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c-'a'+10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c-'A'+10;
+	}
+	return -1;
+}
+
+/// Decode %XX and '+' in a query string component
+static std::string url_decode(const std::string &s) {
+	std::string r;
+	r.reserve(s.size());
+	for (size_t i=0; i<s.size(); ++i) {
+		if (s[i] == '+') {
+			r += ' ';
+		} else if (s[i] == '%' && i+2 < s.size() &&
+			   hex_value(s[i+1]) >= 0 && hex_value(s[i+2]) >= 0
+		) {
+			r += (char)(hex_value(s[i+1])*16 + hex_value(s[i+2]));
+			i += 2;
+		} else {
+			r += s[i];
+		}
+	}
+	return r;
+}
+
+static void parse_query(
+	const std::string &query,
+	std::map<std::string, std::string> &out
+) {
+	size_t pos = 0;
+	while (pos <= query.size()) {
+		size_t amp = query.find('&', pos);
+		if (amp == std::string::npos) {
+			amp = query.size();
+		}
+		const std::string pair = query.substr(pos, amp-pos);
+		if (!pair.empty()) {
+			const size_t eq = pair.find('=');
+			if (eq == std::string::npos) {
+				out[url_decode(pair)] = "";
+			} else {
+				out[url_decode(pair.substr(0, eq))] = url_decode(pair.substr(eq+1));
+			}
+		}
+		pos = amp+1;
+	}
+}
+
+/// Strong ETag from the FNV-1a hash of the body
+static std::string make_etag(const std::string &body) {
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i=0; i<body.size(); ++i) {
+		h ^= (unsigned char)body[i];
+		h *= 1099511628211ULL;
+	}
+	char buf[24];
+	snprintf(buf, sizeof(buf), "\"%016llx\"", (unsigned long long)h);
+	return buf;
+}
+
+/// True if the If-None-Match header 'inm' lists 'etag'
+static bool etag_matches(const std::string &inm, const std::string &etag) {
+	// a list, or a weak validator W/"..." match too
+	return inm == "*" || inm.find(etag) != std::string::npos;
+}
+
+static const char *reason_phrase(const int status) {
+	switch (status) {
+	case 200: return "OK";
+	case 304: return "Not Modified";
+	case 400: return "Bad Request";
+	case 404: return "Not Found";
+	case 405: return "Method Not Allowed";
+	case 431: return "Request Header Fields Too Large";
+	case 500: return "Internal Server Error";
+	}
+	return "Unknown";
+}
+
+// Server::Stats
+
+Server::Stats::Stats()
+	: requests(0),
+	  not_modified(0),
+	  errors(0),
+	  connections(0),
+	  start(now_seconds()),
+	  total_latency(0),
+	  max_latency(0),
+	  recent_next(0),
+	  per_second(g_qps_window+1, 0),
+	  per_second_time(g_qps_window+1, -1)
+{}
+
+void Server::Stats::add(const double now, const double latency, const int status) {
+	++requests;
+	if (status == 304) {
+		++not_modified;
+	} else if (status >= 400) {
+		++errors;
+	}
+	total_latency += latency;
+	max_latency = std::max(max_latency, latency);
+
+	if (recent.size() < g_recent_latencies) {
+		recent.push_back(latency);
+	} else {
+		recent[recent_next] = latency;
+		recent_next = (recent_next+1) % recent.size();
+	}
+
+	const int64_t second = (int64_t)now;
+	const size_t i = second % per_second.size();
+	if (per_second_time[i] != second) {
+		per_second_time[i] = second;
+		per_second[i] = 0;
+	}
+	++per_second[i];
+}
+
+double Server::Stats::qps(const double now, const int seconds) const {
+	// the current second isn't over, so count the ones before it
+	const int64_t second = (int64_t)now;
+	uint64_t n = 0;
+	for (int k=1; k<=seconds && k<=g_qps_window; ++k) {
+		const size_t i = (second-k) % per_second.size();
+		if (per_second_time[i] == second-k) {
+			n += per_second[i];
+		}
+	}
+	return double(n)/seconds;
+}
+
+double Server::Stats::percentile(const double p) const {
+	if (recent.empty()) {
+		return 0;
+	}
+	std::vector<double> v(recent);
+	const size_t k = std::min(v.size()-1, (size_t)(p*v.size()));
+	std::nth_element(v.begin(), v.begin()+k, v.end());
+	return v[k];
+}
+
+// Server
+
+Server::Server(const DictionaryRef &dict, const bool dark)
+	: _dict(dict),
+	  _dark(dark),
+	  _listen_fd(-1)
+{}
+
+Server::~Server() {
+	for (size_t i=0; i<_connections.size(); ++i) {
+		close_connection(_connections[i]);
+	}
+	if (_listen_fd >= 0) {
+		::close(_listen_fd);
+	}
+	if (!_unix_path.empty()) {
+		unlink(_unix_path.c_str());
+	}
+}
+
+int Server::listen(const std::string &address, std::ostream &err) {
+	if (address.find('/') != std::string::npos) {
+		struct sockaddr_un sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sun_family = AF_UNIX;
+		if (address.size() >= sizeof(sa.sun_path)) {
+			err << "Unix socket path \"" << address << "\" is too long\n";
+			return 1;
+		}
+		memcpy(sa.sun_path, address.c_str(), address.size());
+
+		// a stale socket from an earlier run, unless a server still
+		// listens on it
+		struct stat s;
+		if (0 == stat(address.c_str(), &s) && S_ISSOCK(s.st_mode)) {
+			const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0) {
+				err << "Failed to create socket: " << strerror(errno) << "\n";
+				return 1;
+			}
+			const bool listening = 0 == connect(fd, (struct sockaddr*)&sa, sizeof(sa));
+			const int connect_errno = errno;
+			::close(fd);
+			if (listening) {
+				err << "Failed to listen on \"" << address << "\": address in use\n";
+				return 1;
+			}
+			if (connect_errno == ECONNREFUSED) {
+				unlink(address.c_str());
+			}
+		}
+
+		_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (	_listen_fd < 0 ||
+			bind(_listen_fd, (struct sockaddr*)&sa, sizeof(sa)) ||
+			::listen(_listen_fd, SOMAXCONN)
+		) {
+			err << "Failed to listen on \"" << address << "\": " << strerror(errno) << "\n";
+			return 1;
+		}
+		_unix_path = address;
+
+	} else {
+		std::string host = "127.0.0.1";
+		std::string port = address;
+		const size_t colon = address.rfind(':');
+		if (colon != std::string::npos) {
+			host = address.substr(0, colon);
+			port = address.substr(colon+1);
+			// [::1]:8080
+			if (host.size() >= 2 && host[0] == '[' && host[host.size()-1] == ']') {
+				host = host.substr(1, host.size()-2);
+			}
+		}
+
+		struct addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_NUMERICSERV;
+		struct addrinfo *ai = NULL;
+		const int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &ai);
+		if (ret) {
+			err << "Failed to resolve \"" << address << "\": " << gai_strerror(ret) << "\n";
+			return 1;
+		}
+
+		for (struct addrinfo *p = ai; p; p = p->ai_next) {
+			const int fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+			if (fd < 0) {
+				continue;
+			}
+			const int one = 1;
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+			if (bind(fd, p->ai_addr, p->ai_addrlen) || ::listen(fd, SOMAXCONN)) {
+				::close(fd);
+				continue;
+			}
+			_listen_fd = fd;
+			break;
+		}
+		freeaddrinfo(ai);
+
+		if (_listen_fd < 0) {
+			err << "Failed to listen on \"" << address << "\": " << strerror(errno) << "\n";
+			return 1;
+		}
+	}
+
+	if (set_nonblocking(_listen_fd)) {
+		err << "Failed to make the listening socket non-blocking\n";
+		return 1;
+	}
+
+	err << "Listening on " << address << "\n";
+	return 0;
+}
+
+int Server::run(std::ostream &err) {
+	if (_listen_fd < 0) {
+		err << "Server isn't listening\n";
+		return 1;
+	}
+
+	{
+		struct sigaction sa;
+		memset(&sa, 0, sizeof(sa));
+		// no SA_RESTART, so poll returns
+		sa.sa_handler = stop_handler;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGINT, &sa, NULL);
+		sigaction(SIGTERM, &sa, NULL);
+		// writes to closed connections fail with EPIPE instead
+		signal(SIGPIPE, SIG_IGN);
+	}
+
+	std::vector<struct pollfd> fds;
+
+	while (!g_stop) {
+		fds.resize(_connections.size() + 1);
+		fds[0].fd = _listen_fd;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		for (size_t i=0; i<_connections.size(); ++i) {
+			const Connection &c = _connections[i];
+			fds[i+1].fd = c.fd;
+			fds[i+1].events = c.out.empty() ? POLLIN : POLLIN|POLLOUT;
+			fds[i+1].revents = 0;
+		}
+
+		// wake up now and then to close idle connections
+		if (poll(&fds[0], fds.size(), 1000) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			err << "poll failed: " << strerror(errno) << "\n";
+			return 1;
+		}
+
+		const double now = now_seconds();
+
+		for (size_t i=0; i<_connections.size(); ++i) {
+			Connection &c = _connections[i];
+			const short revents = fds[i+1].revents;
+
+			bool ok = !(revents & (POLLERR|POLLNVAL));
+			if (ok && (revents & (POLLIN|POLLHUP))) {
+				ok = read_connection(c, now);
+			}
+			if (ok && !c.out.empty()) {
+				ok = write_connection(c);
+			}
+			if (ok && c.out.empty() && c.close_after_write) {
+				ok = false;
+			}
+			if (ok && now - c.last_active > g_idle_timeout) {
+				ok = false;
+			}
+			if (!ok) {
+				close_connection(c);
+			}
+		}
+
+		_connections.erase(
+			std::remove_if(_connections.begin(), _connections.end(),
+				       [](const Connection &c) { return c.fd < 0; }),
+			_connections.end());
+
+		if (fds[0].revents & POLLIN) {
+			accept_connections(now);
+		}
+	}
+
+	const double now = now_seconds();
+	const std::ios_base::fmtflags flags = err.flags();
+	const std::streamsize prec = err.precision();
+	err << std::fixed << std::setprecision(2) <<
+		"Served " << _stats.requests << " requests in " <<
+		(now - _stats.start) << "s, " <<
+		(_stats.requests / std::max(now - _stats.start, 1e-9)) << " per second, " <<
+		"p50 " << _stats.percentile(0.5)*1e3 << "ms, " <<
+		"p99 " << _stats.percentile(0.99)*1e3 << "ms\n";
+	err.flags(flags);
+	err.precision(prec);
+
+	return 0;
+}
+
+void Server::accept_connections(const double now) {
+	while (true) {
+		const int fd = accept(_listen_fd, NULL, NULL);
+		if (fd < 0) {
+			// EAGAIN once there are no more, or the client gave up
+			return;
+		}
+		if (set_nonblocking(fd)) {
+			::close(fd);
+			continue;
+		}
+		Connection c;
+		c.fd = fd;
+		c.last_active = now;
+		_connections.push_back(c);
+		++_stats.connections;
+	}
+}
+
+bool Server::read_connection(Connection &c, const double now) {
+	char buf[65536];
+	bool eof = false;
+	while (true) {
+		const ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+		if (n > 0) {
+			c.in.append(buf, n);
+			c.last_active = now;
+			continue;
+		}
+		if (n == 0) {
+			eof = true;
+		} else if (errno == EINTR) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			return false;
+		}
+		break;
+	}
+
+	if (!c.close_after_write && !handle_requests(c, now)) {
+		return false;
+	}
+	// answer what was sent before the client closed its side
+	if (eof) {
+		c.close_after_write = true;
+	}
+	return true;
+}
+
+bool Server::write_connection(Connection &c) {
+	size_t written = 0;
+	while (written < c.out.size()) {
+		const ssize_t n = send(c.fd, c.out.data() + written, c.out.size() - written, 0);
+		if (n > 0) {
+			written += n;
+			continue;
+		}
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		return false;
+	}
+	c.out.erase(0, written);
+	return true;
+}
+
+void Server::close_connection(Connection &c) {
+	if (c.fd >= 0) {
+		::close(c.fd);
+		c.fd = -1;
+	}
+}
+
+long Server::parse_request(const std::string &in, Request &req) const {
+	const size_t header_end = in.find("\r\n\r\n");
+	if (header_end == std::string::npos) {
+		return in.size() > g_max_request_size ? -1 : 0;
+	}
+
+	std::istringstream lines(in.substr(0, header_end));
+	std::string line;
+
+	// request line
+	if (!std::getline(lines, line)) {
+		return -1;
+	}
+	if (!line.empty() && line[line.size()-1] == '\r') {
+		line.erase(line.size()-1);
+	}
+	std::string target, version;
+	{
+		std::istringstream ls(line);
+		if (!(ls >> req.method >> target >> version)) {
+			return -1;
+		}
+	}
+	if (version.compare(0, 5, "HTTP/")) {
+		return -1;
+	}
+
+	req.headers.clear();
+	while (std::getline(lines, line)) {
+		if (!line.empty() && line[line.size()-1] == '\r') {
+			line.erase(line.size()-1);
+		}
+		const size_t colon = line.find(':');
+		if (colon == std::string::npos) {
+			return -1;
+		}
+		std::string name = line.substr(0, colon);
+		downcase_ascii(name);
+		size_t v = colon+1;
+		while (v < line.size() && (line[v] == ' ' || line[v] == '\t')) {
+			++v;
+		}
+		req.headers[name] = line.substr(v);
+	}
+
+	if (req.headers.count("transfer-encoding")) {
+		// request bodies aren't used, and chunked ones aren't supported
+		return -1;
+	}
+	size_t content_length = 0;
+	{
+		std::map<std::string, std::string>::const_iterator it =
+			req.headers.find("content-length");
+		if (it != req.headers.end()) {
+			char *end = NULL;
+			const unsigned long n = strtoul(it->second.c_str(), &end, 10);
+			if (!end || *end || n > g_max_request_size) {
+				return -1;
+			}
+			content_length = n;
+		}
+	}
+	const size_t total = header_end + 4 + content_length;
+	if (in.size() < total) {
+		return 0;
+	}
+
+	std::string connection;
+	{
+		std::map<std::string, std::string>::const_iterator it =
+			req.headers.find("connection");
+		if (it != req.headers.end()) {
+			connection = it->second;
+			downcase_ascii(connection);
+		}
+	}
+	if (version == "HTTP/1.0") {
+		req.keep_alive = connection.find("keep-alive") != std::string::npos;
+	} else {
+		req.keep_alive = connection.find("close") == std::string::npos;
+	}
+
+	const size_t q = target.find('?');
+	req.path = url_decode(target.substr(0, q));
+	req.query.clear();
+	if (q != std::string::npos) {
+		parse_query(target.substr(q+1), req.query);
+	}
+	req.target = target;
+
+	return total;
+}
+
+bool Server::handle_requests(Connection &c, const double now) {
+	while (!c.close_after_write) {
+		Request req;
+		const long size = parse_request(c.in, req);
+		if (size == 0) {
+			break;
+		}
+
+		const double start = now_seconds();
+		Response res;
+		bool head = false;
+		if (size < 0) {
+			res.status = c.in.size() > g_max_request_size ? 431 : 400;
+			res.body = "Invalid request\n";
+			req.keep_alive = false;
+			req.method = "-";
+			req.target = "-";
+		} else {
+			head = req.method == "HEAD";
+			respond(req, res);
+		}
+
+		std::ostringstream out;
+		out << "HTTP/1.1 " << res.status << " " << reason_phrase(res.status) << "\r\n";
+		out << "Content-Type: " << res.content_type << "\r\n";
+		if (!res.etag.empty()) {
+			out << "ETag: " << res.etag << "\r\n";
+			out << "Cache-Control: no-cache\r\n";
+		}
+		if (res.status == 405) {
+			out << "Allow: GET, HEAD\r\n";
+		}
+		out << "Content-Length: " << res.body.size() << "\r\n";
+		out << "Connection: " << (req.keep_alive ? "keep-alive" : "close") << "\r\n";
+		out << "\r\n";
+		c.out += out.str();
+		if (!head && res.status != 304) {
+			c.out += res.body;
+		}
+
+		const double end = now_seconds();
+		_stats.add(end, end - start, res.status);
+
+		const std::ios_base::fmtflags flags = std::cerr.flags();
+		const std::streamsize prec = std::cerr.precision();
+		std::cerr << req.method << " " << req.target << " " << res.status << " " <<
+			std::fixed << std::setprecision(3) << (end - start)*1e3 << "ms\n";
+		std::cerr.flags(flags);
+		std::cerr.precision(prec);
+
+		if (size < 0) {
+			c.in.clear();
+		} else {
+			c.in.erase(0, size);
+		}
+		if (!req.keep_alive) {
+			c.close_after_write = true;
+		}
+		c.last_active = now;
+	}
+	return true;
+}
+
+void Server::respond(const Request &req, Response &res) {
+	if (req.method != "GET" && req.method != "HEAD") {
+		res.status = 405;
+		res.body = "Only GET and HEAD are supported\n";
+		return;
+	}
+
+	std::string word;
+	{
+		std::map<std::string, std::string>::const_iterator it = req.query.find("w");
+		if (it != req.query.end()) {
+			word = it->second;
+			strip(word);
+		}
+	}
+
+	if (req.path == "/define") {
+		if (word.empty()) {
+			res.status = 400;
+			res.body = "Expecting /define?w=word\n";
+			return;
+		}
+		bool dark = _dark;
+		{
+			std::map<std::string, std::string>::const_iterator it = req.query.find("dark");
+			if (it != req.query.end()) {
+				dark = it->second == "1";
+			}
+		}
+
+		std::ostringstream out, err;
+		// the stylesheet is embedded, a client can't read the file
+		const int ret = output_definition(_dict, word, true, dark, out, err);
+		if (ret) {
+			res.status = ret == 2 ? 404 : 500;
+			res.body = err.str();
+			return;
+		}
+		res.content_type = "text/html; charset=utf-8";
+		res.body = out.str();
+
+	} else if (req.path == "/list") {
+		// optional paging
+		size_t params[2] = { 0, size_t(-1) };
+		const char * const names[2] = { "start", "n" };
+		for (int i=0; i<2; ++i) {
+			std::map<std::string, std::string>::const_iterator it = req.query.find(names[i]);
+			if (it == req.query.end()) {
+				continue;
+			}
+			char *end = NULL;
+			params[i] = strtoul(it->second.c_str(), &end, 10);
+			if (it->second.empty() || !end || *end) {
+				res.status = 400;
+				res.body = "Expecting /list?w=prefix[&start=n][&n=n]\n";
+				return;
+			}
+		}
+		list_words(_dict, word, params[0], params[1],
+			   [](const std::string &w, void *data) {
+				   std::string &body = *(std::string*)data;
+				   body += w;
+				   body += '\n';
+			   }, &res.body);
+
+	} else if (req.path == "/count") {
+		std::ostringstream out;
+		out << count_words(_dict, word) << "\n";
+		res.body = out.str();
+
+	} else if (req.path == "/search") {
+		std::string query;
+		std::map<std::string, std::string>::const_iterator it = req.query.find("q");
+		if (it != req.query.end()) {
+			query = it->second;
+		}
+		std::ostringstream err;
+		if (search_words(_dict, query,
+				 [](const std::string &w, void *data) {
+					 std::string &body = *(std::string*)data;
+					 body += w;
+					 body += '\n';
+				 }, &res.body, err)) {
+			res.status = 400;
+			res.body = err.str();
+		}
+
+	} else if (req.path == "/exists") {
+		if (word.empty()) {
+			res.status = 400;
+			res.body = "Expecting /exists?w=word\n";
+			return;
+		}
+		if (word_exists(_dict, word)) {
+			res.body = "yes\n";
+		} else {
+			res.status = 404;
+			res.body = "no\n";
+		}
+		return;
+
+	} else if (req.path == "/stats") {
+		res.content_type = "application/json";
+		write_stats(res.body, now_seconds());
+		return;
+
+	} else {
+		res.status = 404;
+		res.body = "Expecting /define, /list, /count, /search, /exists or /stats\n";
+		return;
+	}
+
+	// definitions and lists change only when the index does
+	res.etag = make_etag(res.body);
+	std::map<std::string, std::string>::const_iterator it =
+		req.headers.find("if-none-match");
+	if (it != req.headers.end() && etag_matches(it->second, res.etag)) {
+		res.status = 304;
+	}
+}
+
+void Server::write_stats(std::string &out, const double now) const {
+	const double uptime = now - _stats.start;
+	std::ostringstream s;
+	s << std::fixed << std::setprecision(3);
+	s << "{\n"
+	  << "  \"uptime_s\": " << uptime << ",\n"
+	  << "  \"requests\": " << _stats.requests << ",\n"
+	  << "  \"not_modified\": " << _stats.not_modified << ",\n"
+	  << "  \"errors\": " << _stats.errors << ",\n"
+	  << "  \"connections_open\": " << _connections.size() << ",\n"
+	  << "  \"connections_total\": " << _stats.connections << ",\n"
+	  << "  \"qps\": {\n"
+	  << "    \"overall\": " << _stats.requests / std::max(uptime, 1e-9) << ",\n"
+	  << "    \"last_10s\": " << _stats.qps(now, 10) << ",\n"
+	  << "    \"last_60s\": " << _stats.qps(now, g_qps_window) << "\n"
+	  << "  },\n"
+	  << "  \"latency_ms\": {\n"
+	  << "    \"mean\": " << (_stats.requests ? _stats.total_latency / _stats.requests * 1e3 : 0) << ",\n"
+	  << "    \"p50\": " << _stats.percentile(0.5)*1e3 << ",\n"
+	  << "    \"p90\": " << _stats.percentile(0.9)*1e3 << ",\n"
+	  << "    \"p99\": " << _stats.percentile(0.99)*1e3 << ",\n"
+	  << "    \"max\": " << _stats.max_latency*1e3 << "\n"
+	  << "  }\n"
+	  << "}\n";
+	out = s.str();
+}
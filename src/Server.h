@@ -0,0 +1,122 @@
+#ifndef INCLUDED_SERVER_H
+#define INCLUDED_SERVER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iosfwd>
+#include <stdint.h>
+
+struct DictionaryRef;
+
+/// Answers lookups over HTTP/1.1 with a poll() event loop on one thread,
+/// so the index and the cache of inflated blocks stay warm between
+/// requests. All sockets are non-blocking and connections are kept alive.
+///
+///   GET /define?w=word[&dark=1]  definition as html, with an ETag
+///   GET /list?w=prefix[&start=n][&n=n]
+///                                words for which 'prefix' is a prefix, or
+///                                'n' of them after skipping 'start'
+///   GET /count?w=prefix          number of words /list would return
+///   GET /search?q=query          words of the entries which match the
+///                                full-text query, best first
+///   GET /exists?w=word           200 if 'word' has a definition, else 404
+///   GET /stats                   request counts, latency and QPS as JSON
+class Server {
+public:
+	Server(const DictionaryRef &dict, const bool dark);
+	~Server();
+
+	/// 'address' is a port on localhost, host:port, or the path of a
+	/// Unix socket if it contains a '/'
+	int listen(const std::string &address, std::ostream &err);
+
+	/// Serve until SIGINT or SIGTERM. Returns non-zero on error.
+	int run(std::ostream &err);
+
+private:
+	struct Connection {
+		Connection() : fd(-1), last_active(0), close_after_write(false) {}
+
+		int fd;
+		std::string in;
+		std::string out;
+		/// Seconds on a monotonic clock
+		double last_active;
+		bool close_after_write;
+	};
+
+	struct Request {
+		std::string method;
+		/// As sent, for the log
+		std::string target;
+		std::string path;
+		std::map<std::string, std::string> query;
+		/// Header names are downcased
+		std::map<std::string, std::string> headers;
+		bool keep_alive;
+	};
+
+	struct Response {
+		Response() : status(200), content_type("text/plain; charset=utf-8") {}
+
+		int status;
+		std::string content_type;
+		std::string etag;
+		std::string body;
+	};
+
+	/// Latencies and request times for the stats
+	struct Stats {
+		Stats();
+
+		uint64_t requests;
+		uint64_t not_modified;
+		/// Responses with a 4xx or 5xx status
+		uint64_t errors;
+		uint64_t connections;
+		double start;
+		double total_latency;
+		double max_latency;
+		/// The most recent latencies, in seconds, for percentiles
+		std::vector<double> recent;
+		size_t recent_next;
+		/// Requests in each of the last seconds, indexed by time
+		std::vector<uint64_t> per_second;
+		std::vector<int64_t> per_second_time;
+
+		void add(const double now, const double latency, const int status);
+		/// Requests per second over the last 'seconds'
+		double qps(const double now, const int seconds) const;
+		double percentile(const double p) const;
+	};
+
+	const DictionaryRef &_dict;
+	const bool _dark;
+	int _listen_fd;
+	/// Removed when the server stops
+	std::string _unix_path;
+	std::vector<Connection> _connections;
+	Stats _stats;
+
+	void accept_connections(const double now);
+	/// Returns false if the connection should be closed
+	bool read_connection(Connection &c, const double now);
+	bool write_connection(Connection &c);
+	void close_connection(Connection &c);
+
+	/// Handle all the complete requests in the input buffer. Returns
+	/// false if the connection should be closed.
+	bool handle_requests(Connection &c, const double now);
+	/// Returns the size of the request, 0 if it isn't complete yet, or
+	/// -1 if it is invalid
+	long parse_request(const std::string &in, Request &req) const;
+	void respond(const Request &req, Response &res);
+	void write_stats(std::string &out, const double now) const;
+
+	// non-copyable
+	Server(const Server &);
+	Server &operator=(const Server &);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "SharedIndex.h"
+
+SharedIndex::SharedIndex()
+	: _index(std::make_shared<MappedIndex>()),
+	  _progress(0),
+	  _complete(false),
+	  _generation(0),
+	  _cancelled(false)
+{}
+
+SharedIndex::IndexPtrT SharedIndex::get() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _index;
+}
+
+void SharedIndex::publish(
+	const IndexPtrT &index,
+	const double progress,
+	const bool complete
+) {
+	IndexPtrT old;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (index) {
+			// freed outside the lock
+			old = _index;
+			_index = index;
+			++_generation;
+		}
+		_progress = progress;
+		_complete = complete;
+	}
+	_cond.notify_all();
+}
+
+double SharedIndex::progress() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _progress;
+}
+
+bool SharedIndex::complete() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _complete;
+}
+
+unsigned int SharedIndex::generation() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _generation;
+}
+
+void SharedIndex::wait(const unsigned int generation) const {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_cond.wait(lock, [this, generation]() {
+		return _complete || _generation != generation;
+	});
+}
+
+void SharedIndex::wait_complete() const {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_cond.wait(lock, [this]() { return _complete; });
+}
@@ -0,0 +1,60 @@
+#ifndef INCLUDED_SHAREDINDEX_H
+#define INCLUDED_SHAREDINDEX_H
+
+#include "Index.h"
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/// The index used for lookups, which may be replaced by a bigger one while
+/// the index is built in the background. Each lookup should get() the
+/// index once and use it throughout, it stays valid while it is held.
+/// Thread safe.
+class SharedIndex {
+public:
+	typedef std::shared_ptr<const MappedIndex> IndexPtrT;
+
+	/// Starts with an empty index
+	SharedIndex();
+
+	IndexPtrT get() const;
+
+	/// Replace the index. 'progress' is the fraction of Body.data in it,
+	/// from 0 to 1. A NULL 'index' keeps the current one.
+	void publish(const IndexPtrT &index,
+		     const double progress,
+		     const bool complete);
+
+	/// Fraction of Body.data that has been indexed
+	double progress() const;
+	/// Set once the index has all the entries and links
+	bool complete() const;
+	/// Incremented each time a new index is published
+	unsigned int generation() const;
+
+	/// Wait until an index newer than 'generation' is published, or the
+	/// index is complete
+	void wait(const unsigned int generation) const;
+	void wait_complete() const;
+
+	/// Ask the builder to stop, e.g. when the program is exiting
+	void cancel() { _cancelled = true; }
+	bool cancelled() const { return _cancelled; }
+	const std::atomic<bool> &cancel_flag() const { return _cancelled; }
+
+private:
+	mutable std::mutex _mutex;
+	mutable std::condition_variable _cond;
+	IndexPtrT _index;
+	double _progress;
+	bool _complete;
+	unsigned int _generation;
+	std::atomic<bool> _cancelled;
+
+	// non-copyable
+	SharedIndex(const SharedIndex &);
+	SharedIndex &operator=(const SharedIndex &);
+};
+
+#endif
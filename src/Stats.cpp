@@ -0,0 +1,132 @@
+#include "Stats.h"
+#include <ostream>
+#include <iomanip>
+#include <ctime>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+static const char * const g_phase_names[Stats::NUM_PHASES] = {
+	"file_read",
+	"inflate",
+	"headwords",
+	"links",
+	"cache_write",
+	"cache_load",
+	"lookup",
+	"render"
+};
+
+static const char * const g_counter_names[Stats::NUM_COUNTERS] = {
+	"blocks_inflated",
+	"bytes_in",
+	"bytes_out",
+	"resync_failed",
+	"xml_parses",
+	"block_cache_hits",
+	"block_cache_misses",
+	"page_cache_hits",
+	"page_cache_misses"
+};
+
+/// CPU time of the calling thread in seconds
+static double thread_cpu_seconds() {
+	struct timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)) {
+		return 0;
+	}
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline double seconds(const struct timeval &tv) {
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+Stats::Stats()
+	: _enabled(false),
+	  _start(std::chrono::steady_clock::now())
+{
+	for (int i=0; i<NUM_PHASES; ++i) {
+		_wall_ns[i] = 0;
+		_cpu_ns[i] = 0;
+		_calls[i] = 0;
+	}
+	for (int i=0; i<NUM_COUNTERS; ++i) {
+		_counters[i] = 0;
+	}
+}
+
+void Stats::add_time(const Phase phase, const double wall, const double cpu) {
+	if (!_enabled) {
+		return;
+	}
+	_wall_ns[phase] += uint64_t(wall * 1e9);
+	_cpu_ns[phase] += uint64_t(cpu * 1e9);
+	++_calls[phase];
+}
+
+void Stats::write_json(std::ostream &out) const {
+	const double wall = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - _start).count();
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	// in bytes rather than KiB
+	const long peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+	const long peak_rss_kb = usage.ru_maxrss;
+#endif
+
+	const std::ios_base::fmtflags flags = out.flags();
+	const std::streamsize prec = out.precision();
+	out << std::fixed << std::setprecision(6);
+
+	out << "{\n"
+	    << "  \"wall_s\": " << wall << ",\n"
+	    << "  \"user_s\": " << seconds(usage.ru_utime) << ",\n"
+	    << "  \"system_s\": " << seconds(usage.ru_stime) << ",\n"
+	    << "  \"peak_rss_kb\": " << peak_rss_kb << ",\n"
+	    << "  \"phases\": {\n";
+	for (int i=0; i<NUM_PHASES; ++i) {
+		out << "    \"" << g_phase_names[i] << "\": { " <<
+			"\"wall_s\": " << _wall_ns[i] * 1e-9 << ", " <<
+			"\"cpu_s\": " << _cpu_ns[i] * 1e-9 << ", " <<
+			"\"calls\": " << _calls[i] << " }" <<
+			(i + 1 < NUM_PHASES ? ",\n" : "\n");
+	}
+	out << "  },\n"
+	    << "  \"counters\": {\n";
+	for (int i=0; i<NUM_COUNTERS; ++i) {
+		out << "    \"" << g_counter_names[i] << "\": " << _counters[i] <<
+			(i + 1 < NUM_COUNTERS ? ",\n" : "\n");
+	}
+	out << "  }\n"
+	    << "}\n";
+
+	out.flags(flags);
+	out.precision(prec);
+}
+
+Stats &process_stats() {
+	static Stats stats;
+	return stats;
+}
+
+PhaseTimer::PhaseTimer(const Stats::Phase phase)
+	: _phase(phase),
+	  _enabled(process_stats().enabled()),
+	  _cpu(0)
+{
+	if (_enabled) {
+		_wall = std::chrono::steady_clock::now();
+		_cpu = thread_cpu_seconds();
+	}
+}
+
+PhaseTimer::~PhaseTimer() {
+	if (_enabled) {
+		process_stats().add_time(_phase,
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - _wall).count(),
+			thread_cpu_seconds() - _cpu);
+	}
+}
@@ -0,0 +1,105 @@
+#ifndef INCLUDED_STATS_H
+#define INCLUDED_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <cstddef>
+#include <stdint.h>
+
+/// Time spent in each phase of the work of the process and counts of what
+/// was done, written as JSON for --stats. Phase times are summed over the
+/// threads which did the work, so with several threads they can add up to
+/// more than the time the process ran. Nothing is recorded until enable()
+/// is called, so otherwise the timers only cost a test. Thread safe.
+class Stats {
+public:
+	enum Phase {
+		/// Opening Body.data and following its block headers. The file
+		/// is mapped, so reading the blocks is part of inflating them.
+		PHASE_FILE_READ,
+		PHASE_INFLATE,
+		/// Reading the headwords of the inflated entries
+		PHASE_HEADWORDS,
+		PHASE_LINKS,
+		PHASE_CACHE_WRITE,
+		PHASE_CACHE_LOAD,
+		/// Finding words in the index
+		PHASE_LOOKUP,
+		/// Writing the html of definitions from their entries
+		PHASE_RENDER,
+		NUM_PHASES
+	};
+
+	enum Counter {
+		BLOCKS_INFLATED,
+		/// Compressed bytes of the blocks inflated
+		BYTES_IN,
+		/// Bytes the blocks inflated to
+		BYTES_OUT,
+		/// Bytes after a damaged block header which were tried as the
+		/// start of a block, and weren't
+		RESYNC_FAILED,
+		/// Entries parsed with libxml2
+		XML_PARSES,
+		BLOCK_CACHE_HITS,
+		BLOCK_CACHE_MISSES,
+		PAGE_CACHE_HITS,
+		PAGE_CACHE_MISSES,
+		NUM_COUNTERS
+	};
+
+	Stats();
+
+	void enable() { _enabled = true; }
+	bool enabled() const { return _enabled; }
+
+	/// 'wall' and 'cpu' in seconds
+	void add_time(const Phase phase, const double wall, const double cpu);
+	void add(const Counter counter, const size_t n = 1) {
+		if (_enabled) {
+			_counters[counter] += n;
+		}
+	}
+	void set(const Counter counter, const size_t n) {
+		_counters[counter] = n;
+	}
+
+	/// With the time the process ran and its peak resident set size
+	void write_json(std::ostream &out) const;
+
+private:
+	std::atomic<bool> _enabled;
+	const std::chrono::steady_clock::time_point _start;
+	std::atomic<uint64_t> _wall_ns[NUM_PHASES];
+	std::atomic<uint64_t> _cpu_ns[NUM_PHASES];
+	std::atomic<uint64_t> _calls[NUM_PHASES];
+	std::atomic<uint64_t> _counters[NUM_COUNTERS];
+
+	// non-copyable
+	Stats(const Stats &);
+	Stats &operator=(const Stats &);
+};
+
+/// The stats of the process
+Stats &process_stats();
+
+/// Adds the wall and CPU time of the calling thread from construction to
+/// destruction to 'phase' of the process stats
+class PhaseTimer {
+public:
+	explicit PhaseTimer(const Stats::Phase phase);
+	~PhaseTimer();
+
+private:
+	const Stats::Phase _phase;
+	const bool _enabled;
+	std::chrono::steady_clock::time_point _wall;
+	double _cpu;
+
+	// non-copyable
+	PhaseTimer(const PhaseTimer &);
+	PhaseTimer &operator=(const PhaseTimer &);
+};
+
+#endif
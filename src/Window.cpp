@@ -1,16 +1,28 @@
 #include "Window.h"
 #include "LineEdit.h"
+#include "WordListModel.h"
+#include "LookupWorker.h"
+#include "DefinitionPage.h"
 #include "Dictionary.h"
 #include <QtWebEngine/QtWebEngine>
 #include <QtWebEngineWidgets/QtWebEngineWidgets>
 #include <QtWidgets/QScrollArea>
 #include <QtWidgets/QSplitter>
-#include <QtWidgets/QListWidget>
+#include <QtWidgets/QListView>
 #include <QtWidgets/QVBoxLayout>
 #include <QtWidgets/QPushButton>
 #include <QtWidgets/QLabel>
+#include <QtWidgets/QProgressBar>
+#include <QtCore/QTimer>
 #include <QtCore/QSignalBlocker>
+#include <QtCore/QItemSelectionModel>
 #include <sstream>
+#include <algorithm>
+
+/// Milliseconds after the last key before the word is looked up
+static const int g_typing_delay = 40;
+/// Visits kept to go back to, with their pages
+static const size_t g_history_size = 100;
 
 static QPushButton *add_flat_btn(
 	const char * const text,
@@ -26,10 +38,22 @@ Window::Window(
 	const DictionaryRef &dict,
 	const bool dark,
 	const std::string &word,
+	const unsigned int prefetch,
 	QWidget *parent
 ) : QMainWindow(parent),
     _dict(dict),
-    _dark(dark)
+    _dark(dark),
+    _prefetch(prefetch),
+    _request(0),
+    _request_source(SOURCE_FIELD),
+    _list_request(0),
+    _list_suggestions(false),
+    _keep_row(-1),
+    _keep_reload(false),
+    _keep_source(SOURCE_FIELD),
+    _restore_scroll(false),
+    _generation(0),
+    _suggesting(false)
 {
 	setWindowTitle("Dictionary");
 
@@ -42,25 +66,54 @@ Window::Window(
 	_scroll	   = new QScrollArea(_right);
 
 	_view	= new QWebEngineView(_scroll);
+	DefinitionPage * const page = new DefinitionPage(_view);
+	_view->setPage(page);
 	_view->setZoomFactor(1.25);
+	connect(page, &DefinitionPage::link_clicked, this, &Window::slot_link_clicked);
+	connect(_view, &QWebEngineView::loadFinished, this, &Window::slot_load_finished);
 
 	QWebEngineProfile::defaultProfile()->setPersistentCookiesPolicy(QWebEngineProfile::NoPersistentCookies);
 
 
 	_theme  = new QPushButton("Theme", _top_left);
 	_found	= new QLabel("", _top_right);
-	// _back  = add_flat_btn("<", _top_right);
-	// _fwd   = add_flat_btn(">", _top_right);
+	_back  = add_flat_btn("<", _top_right);
+	_fwd   = add_flat_btn(">", _top_right);
 	_small = add_flat_btn("-", _top_right);
 	_big   = add_flat_btn("+", _top_right);
 
 	connect(_theme, &QPushButton::clicked, this, &Window::slot_toggle_theme);
+	connect(_back,  &QPushButton::clicked, this, &Window::slot_back);
+	connect(_fwd,   &QPushButton::clicked, this, &Window::slot_forward);
 	connect(_small, &QPushButton::clicked, this, &Window::slot_text_small);
 	connect(_big,   &QPushButton::clicked, this, &Window::slot_text_big);
 
-	_list = new QListWidget(_left);
+	_progress = new QProgressBar(_top_left);
+	_progress->setRange(0, 100);
+	_progress->setTextVisible(true);
+	_progress->hide();
+
+	_progress_timer = new QTimer(this);
+	connect(_progress_timer, &QTimer::timeout, this, &Window::slot_index_progress);
+
+	_words = new WordListModel(_dict, this);
+	_list = new QListView(_left);
 	_list->setFrameStyle(QFrame::NoFrame);
-	connect(_list, &QListWidget::currentItemChanged, this, &Window::slot_item_changed);
+	// only the rows which are shown are read from the index
+	_list->setUniformItemSizes(true);
+	_list->setModel(_words);
+	connect(_list->selectionModel(), &QItemSelectionModel::currentChanged,
+		this, &Window::slot_item_changed);
+
+	_typing_timer = new QTimer(this);
+	_typing_timer->setSingleShot(true);
+	connect(_typing_timer, &QTimer::timeout, this, &Window::slot_typing_done);
+
+	_worker = new LookupWorker(_dict, this);
+	connect(_worker, &LookupWorker::listed, this, &Window::slot_listed,
+		Qt::QueuedConnection);
+	connect(_worker, &LookupWorker::rendered, this, &Window::slot_rendered,
+		Qt::QueuedConnection);
 
 	connect(_line, &QLineEdit::textChanged, this, &Window::slot_text_changed);
 
@@ -72,6 +125,7 @@ Window::Window(
 	{
 		QHBoxLayout * const layout = new QHBoxLayout(_top_left);
 		layout->addWidget(_theme, 0, Qt::AlignCenter);
+		layout->addWidget(_progress, 1);
 	}
 
 	{
@@ -88,6 +142,8 @@ Window::Window(
 		layout->addSpacing(10);
 		layout->addWidget(_found, 0);
 		layout->addStretch(3);
+		layout->addWidget(_back, 0);
+		layout->addWidget(_fwd, 0);
 		layout->addWidget(_small, 0);
 		layout->addWidget(_big, 0);
 		layout->addSpacing(10);
@@ -117,12 +173,23 @@ Window::Window(
 
 	update_definition(true);
 	update_list_theme();
+	update_history_buttons();
+
+	if (!index_status(_dict).complete) {
+		_progress->show();
+		_progress_timer->start(200);
+		slot_index_progress();
+	}
 }
 
-Window::~Window() {}
+Window::~Window() {
+	_worker->stop();
+}
 
 
 void Window::closeEvent(QCloseEvent *event) {
+	// the dictionary may go away once the window is closed
+	_worker->stop();
 	deleteLater();
 	QMainWindow::closeEvent(event);
 }
@@ -142,6 +209,18 @@ void Window::keyPressEvent(QKeyEvent *event) {
 	} else if (event->key() == Qt::Key_Escape) {
 		close();
 
+	} else if (	event->key() == Qt::Key_Back ||
+			(event->key() == Qt::Key_Left &&
+			 (event->modifiers() & Qt::AltModifier))
+	) {
+		slot_back(false);
+
+	} else if (	event->key() == Qt::Key_Forward ||
+			(event->key() == Qt::Key_Right &&
+			 (event->modifiers() & Qt::AltModifier))
+	) {
+		slot_forward(false);
+
 	} else {
 		QMainWindow::keyPressEvent(event);
 	}
@@ -185,89 +264,405 @@ void Window::end_html(std::ostream &out) const {
 	out << "</body>\n";
 }
 
-void Window::definition_of_list_item(std::ostringstream &out) const {
+void Window::definition_of_list_item(std::ostringstream &out, std::string &word) const {
+
+	const QModelIndex item = _list->currentIndex();
 
-	if (!_list->count()) {
+	if (!_words->rowCount() || (_suggesting && !item.isValid())) {
 		begin_html(out);
-		out << "<p><br>No entries found</p>\n";
+		if (!index_status(_dict).complete) {
+			out << "<p><br>No entries found yet, still indexing</p>\n";
+		} else if (_suggesting) {
+			out << "<p><br>No entries found, did you mean one of these?</p>\n";
+		} else {
+			out << "<p><br>No entries found</p>\n";
+		}
 		end_html(out);
 		return;
 	}
 
-	QListWidgetItem * const item = _list->currentItem();
-	if (!item) {
+	if (!item.isValid()) {
 		begin_html(out);
 		out << "<p><br>No entry selected</p>\n";
 		end_html(out);
 		return;
 	}
 
-	QByteArray ba = item->text().toUtf8();
-	const std::string text = ba.data();
+	QByteArray ba = _words->word(item.row()).toUtf8();
+	word = ba.data();
+}
 
-	std::ostringstream msg;
+/// Fill list with words for which 'text' is a prefix. The words of a
+/// full-text search, or those spelt like 'text' if it isn't a prefix of
+/// any, are found by the worker, and _list_request is set until they are.
+void Window::fill_list(const std::string &text) {
+	_suggesting = false;
+	_generation = index_status(_dict).generation;
+
+	if (text[0] == '?') {
+		// full-text search, the list stays until it's done
+		_list_request = _worker->request_list(LookupWorker::LIST_SEARCH, text.substr(1));
+		_list_suggestions = false;
+		_found->setText("Searching");
+		return;
+	}
 
-	// display definition of selected entry
-	if (output_definition(_dict, text, true, _dark, out, msg)) {
+	_words->set_prefix(text);
+	_found->setText(QString("%1 found").arg(_words->rowCount()));
 
-		// display error instead of definition
-		out.clear();
-		out.str("");
+	if (_words->rowCount()) {
+		_list_request = 0;
+		_worker->cancel_list();
+	} else {
+		// perhaps a typo
+		_list_request = _worker->request_list(LookupWorker::LIST_SUGGEST, text);
+		_list_suggestions = true;
+	}
+}
 
-		begin_html(out);
-		out << "<p><br>" << msg.str() << "</p>\n";
-		end_html(out);
+/// Fill the list again from a bigger index, keeping the selected word.
+/// The definition is only updated if the selection changed or 'reload'
+/// is set.
+void Window::refresh_list(const bool reload) {
+	QByteArray ba = _line->text().toUtf8();
+	std::string text = ba.data();
+	strip(text);
+	if (text.empty()) {
+		return;
+	}
+
+	if (_list_request) {
+		// what the list is being filled for still holds
+		_keep_reload = _keep_reload || reload;
+	} else {
+		_keep_row = _list->currentIndex().row();
+		_keep_word = _words->word(_keep_row);
+		_keep_reload = reload;
+		_keep_source = SOURCE_LIST;
+	}
+
+	{
+		QSignalBlocker block(_list->selectionModel());
+		fill_list(text);
+	}
+	if (!_list_request) {
+		list_filled();
+	}
+}
+
+void Window::slot_listed(unsigned int id, bool ok, const QStringList &words, const QString &error) {
+	if (id != _list_request) {
+		// superseded
+		return;
+	}
+	_list_request = 0;
+
+	{
+		QSignalBlocker block(_list->selectionModel());
+		_words->set_words(words, _list_suggestions);
+	}
+	_suggesting = _list_suggestions && !words.isEmpty();
+	if (!_list_suggestions) {
+		_found->setText(ok ? QString("%1 found").arg(words.size()) : error);
+	}
+	list_filled();
+}
+
+void Window::list_filled() {
+	const int found = _words->find(_keep_word, _keep_row);
+
+	bool changed = false;
+	{
+		QSignalBlocker block(_list->selectionModel());
+		if (found >= 0) {
+			_list->setCurrentIndex(_words->index(found));
+		} else if (_words->rowCount() > 0 && !_suggesting) {
+			_list->setCurrentIndex(_words->index(0));
+			changed = true;
+		} else if (!_keep_word.isEmpty()) {
+			changed = true;
+		}
+	}
+
+	if (changed || _keep_reload) {
+		std::ostringstream out;
+		std::string word;
+		definition_of_list_item(out, word);
+		show_definition(out, word, _keep_source);
+	}
+}
+
+void Window::slot_index_progress() {
+	const IndexStatus status = index_status(_dict);
+
+	if (status.complete) {
+		_progress_timer->stop();
+		_progress->hide();
+	} else {
+		_progress->setValue(int(status.progress*100));
+		_progress->setFormat(status.progress < 1 ? "Indexing %p%" : "Finding links");
+	}
+
+	if (status.generation != _generation) {
+		// the complete index may have more entries and backlinks for
+		// the selected word
+		refresh_list(status.complete);
 	}
 }
 
 void Window::update_definition(const bool from_field) {
 
 	std::ostringstream out;
+	std::string word;
 
 	if (from_field) {
 
-		QSignalBlocker block(_list);
-
-		_list->clear();
-
 		QByteArray ba = _line->text().toUtf8();
 		std::string text = ba.data();
 		strip(text);
 
 		if (text.empty()) {
+			{
+				QSignalBlocker block(_list->selectionModel());
+				_words->clear();
+			}
+			_list_request = 0;
+			_worker->cancel_list();
+
 			begin_html(out);
 			out << "<p><br>Type a word to lookup</p>\n";
 			end_html(out);
 
 			_found->setText("0 found");
-		} else {
-			// fill list with words for which 'text' is a prefix
-			list_words(_dict, text,
-				   [](const std::string &word, void *data) {
-					   QListWidget * const list = (QListWidget*)data;
-					   new QListWidgetItem(QString::fromUtf8(word.c_str()), list);
-				   }, _list);
-
-			const int count = _list->count();
-			_found->setText(QString("%1 found").arg(count));
-
-			if (count > 0) {
-				_list->setCurrentItem(_list->item(0));
-			}
-			definition_of_list_item(out);
+			show_definition(out, word, SOURCE_FIELD);
+			return;
+		}
+
+		// the first word is shown, but suggestions wait to be picked
+		_keep_word = QString();
+		_keep_row = -1;
+		_keep_reload = true;
+		_keep_source = SOURCE_FIELD;
+		{
+			QSignalBlocker block(_list->selectionModel());
+			fill_list(text);
+		}
+		if (!_list_request) {
+			list_filled();
 		}
+		return;
+	}
+
+	definition_of_list_item(out, word);
+	show_definition(out, word, SOURCE_LIST);
+}
+
+void Window::show_definition(
+	const std::ostringstream &out,
+	const std::string &word,
+	const Source source
+) {
+	if (word.empty()) {
+		// a message, nothing being rendered is wanted now
+		_request = 0;
+		_worker->cancel();
+		leave_visit(source);
+		set_page(QString::fromUtf8(out.str().c_str()), false);
+		update_history_buttons();
+	} else {
+		// the page shown stays until the new one is rendered
+		_request = _worker->request(word, _dark);
+		_request_word = word;
+		_request_source = source;
+	}
+
+	const QModelIndex item = _list->currentIndex();
+	prefetch_near(item.isValid() ? item.row() : -1);
+}
+
+void Window::prefetch_near(const int row) {
+	std::vector<std::string> words;
+	const int count = _words->rowCount();
+
+	const auto add = [&](const int r) {
+		if (r < 0 || r >= count || r == row || words.size() >= _prefetch) {
+			return;
+		}
+		QByteArray ba = _words->word(r).toUtf8();
+		const std::string word = ba.data();
+		if (!word.empty() && std::find(words.begin(), words.end(), word) == words.end()) {
+			words.push_back(word);
+		}
+	};
+
+	// half for the words next to the selection, nearest first, then the
+	// first words of the list, then the rest for the neighbours again
+	const int budget = _prefetch;
+	int d = 1;
+	for (; words.size() < _prefetch - _prefetch/2 && d <= budget; ++d) {
+		add(row + d);
+		add(row - d);
+	}
+	for (int r=0; r<std::min(count, budget + 1); ++r) {
+		add(r);
+	}
+	for (; words.size() < _prefetch && d <= budget; ++d) {
+		add(row + d);
+		add(row - d);
+	}
+
+	_worker->prefetch(words, _dark);
+}
+
+void Window::slot_rendered(unsigned int id, bool ok, const QString &text) {
+	if (id != _request) {
+		// superseded
+		return;
+	}
+	_request = 0;
+
+	if (ok) {
+		show_visit(_request_word, text, _request_source);
+		return;
+	}
+
+	// display error instead of definition
+	std::ostringstream out;
+	QByteArray ba = text.toUtf8();
+	begin_html(out);
+	out << "<p><br>" << ba.data() << "</p>\n";
+	end_html(out);
+	leave_visit(_request_source);
+	set_page(QString::fromUtf8(out.str().c_str()), false);
+	update_history_buttons();
+}
+
+void Window::set_page(const QString &html, const bool restore_scroll) {
+	_restore_scroll = restore_scroll;
+	_view->setHtml(html);
+}
+
+void Window::show_visit(const std::string &word, const QString &html, const Source source) {
+	if (word == _visit.word) {
+		// e.g. in the other theme, so stay where it was read up to
+		if (source != SOURCE_HISTORY) {
+			_visit.scroll = _view->page()->scrollPosition();
+		}
+	} else {
+		leave_visit(source);
+		_visit.word = word;
+		_visit.source = source;
+	}
+	_visit.html = html;
+	_visit.dark = _dark;
+
+	set_page(html, !_visit.scroll.isNull());
+	update_history_buttons();
+}
+
+void Window::leave_visit(const Source next) {
+	_fwd_visits.clear();
+	if (_visit.word.empty()) {
+		return;
+	}
+
+	// the words looked up while typing are one visit
+	if (next != SOURCE_FIELD || _visit.source != SOURCE_FIELD) {
+		_visit.scroll = _view->page()->scrollPosition();
+		_back_visits.push_back(_visit);
+		if (_back_visits.size() > g_history_size) {
+			_back_visits.pop_front();
+		}
+	}
+	_visit = Visit();
+}
+
+void Window::go(VisitsT &from, VisitsT &to) {
+	if (from.empty()) {
+		return;
+	}
+
+	_request = 0;
+	_worker->cancel();
+
+	if (!_visit.word.empty()) {
+		_visit.scroll = _view->page()->scrollPosition();
+		to.push_back(_visit);
+	}
+	_visit = from.back();
+	from.pop_back();
+
+	if (_visit.dark == _dark) {
+		set_page(_visit.html, true);
 	} else {
-		definition_of_list_item(out);
+		// rendered again in the theme now used
+		_request = _worker->request(_visit.word, _dark);
+		_request_word = _visit.word;
+		_request_source = SOURCE_HISTORY;
+	}
+	update_history_buttons();
+}
+
+void Window::update_history_buttons() {
+	_back->setEnabled(!_back_visits.empty());
+	_fwd->setEnabled(!_fwd_visits.empty());
+}
+
+void Window::slot_back(bool) {
+	go(_back_visits, _fwd_visits);
+}
+
+void Window::slot_forward(bool) {
+	go(_fwd_visits, _back_visits);
+}
+
+void Window::slot_load_finished(bool ok) {
+	if (!ok || !_restore_scroll) {
+		return;
 	}
+	_restore_scroll = false;
+	_view->page()->runJavaScript(QString("window.scrollTo(%1, %2);")
+				     .arg(_visit.scroll.x())
+				     .arg(_visit.scroll.y()));
+}
+
+void Window::slot_link_clicked(const QUrl &url) {
+	QByteArray ba = url.toString(QUrl::FullyDecoded).toUtf8();
+	const std::string href = ba.data();
+
+	// the text of the link, which has the focus once it's clicked
+	_view->page()->runJavaScript(
+		"(function() {\n"
+		"  var a = document.activeElement;\n"
+		"  a = a && a.closest ? a.closest('a') : null;\n"
+		"  return a ? a.textContent : '';\n"
+		"})();",
+		[this, href](const QVariant &text) {
+			QByteArray ba = text.toString().toUtf8();
+			follow_link(href, ba.data());
+		});
+}
 
-	_view->setHtml(QString::fromUtf8(out.str().c_str()));
+void Window::follow_link(const std::string &href, const std::string &text) {
+	std::string word;
+	if (!resolve_link(_dict, href, text, word)) {
+		_found->setText("Link not found");
+		return;
+	}
+	_request = _worker->request(word, _dark);
+	_request_word = word;
+	_request_source = SOURCE_LINK;
 }
 
-void Window::slot_item_changed(QListWidgetItem *cur, QListWidgetItem *prev) {
+void Window::slot_item_changed(const QModelIndex &cur, const QModelIndex &prev) {
 	update_definition(false);
 }
 
 void Window::slot_text_changed(const QString &) {
+	_typing_timer->start(g_typing_delay);
+}
+
+void Window::slot_typing_done() {
 	update_definition(true);
 }
 
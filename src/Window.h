@@ -2,16 +2,26 @@
 #define INCLUDED_WINDOW_H
 
 #include <QtWidgets/QMainWindow>
+#include <QtCore/QModelIndex>
+#include <QtCore/QPointF>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QUrl>
+#include <string>
+#include <deque>
 
-QT_FORWARD_DECLARE_CLASS(QListWidget);
-QT_FORWARD_DECLARE_CLASS(QListWidgetItem);
+QT_FORWARD_DECLARE_CLASS(QListView);
 QT_FORWARD_DECLARE_CLASS(QSplitter);
 QT_FORWARD_DECLARE_CLASS(QScrollArea);
 QT_FORWARD_DECLARE_CLASS(QWebEngineView);
 QT_FORWARD_DECLARE_CLASS(QPushButton);
 QT_FORWARD_DECLARE_CLASS(QLabel);
+QT_FORWARD_DECLARE_CLASS(QProgressBar);
+QT_FORWARD_DECLARE_CLASS(QTimer);
 
 class LineEdit;
+class WordListModel;
+class LookupWorker;
 struct DictionaryRef;
 
 class Window : public QMainWindow {
@@ -20,6 +30,7 @@ public:
 	Window(const DictionaryRef &dict,
 	       const bool dark,
 	       const std::string &word,
+	       const unsigned int prefetch,
 	       QWidget *parent = NULL);
 	virtual ~Window();
 
@@ -30,16 +41,48 @@ protected:
 
 private slots:
 	void slot_text_changed(const QString &);
-	void slot_item_changed(QListWidgetItem *cur, QListWidgetItem *prev);
+	void slot_typing_done();
+	void slot_rendered(unsigned int id, bool ok, const QString &text);
+	void slot_listed(unsigned int id, bool ok, const QStringList &words, const QString &error);
+	void slot_item_changed(const QModelIndex &cur, const QModelIndex &prev);
 	void slot_toggle_theme(bool);
 	void slot_text_small(bool);
 	void slot_text_big(bool);
+	void slot_index_progress();
+	void slot_back(bool);
+	void slot_forward(bool);
+	void slot_link_clicked(const QUrl &url);
+	void slot_load_finished(bool ok);
 
 private:
+	/// How the definition being rendered was asked for
+	enum Source {
+		SOURCE_FIELD,
+		SOURCE_LIST,
+		SOURCE_LINK,
+		SOURCE_HISTORY
+	};
+
+	/// A definition shown, kept to go back or forward to
+	struct Visit {
+		Visit() : dark(false), source(SOURCE_FIELD) {}
+
+		std::string word;
+		/// The page as it was rendered, so it isn't rendered again
+		QString html;
+		bool dark;
+		QPointF scroll;
+		Source source;
+	};
+	typedef std::deque<Visit> VisitsT;
+
 	const DictionaryRef &_dict;
 	bool _dark;
+	/// Most definitions rendered ahead of the selection
+	unsigned int _prefetch;
 
-	QListWidget *_list;
+	QListView *_list;
+	WordListModel *_words;
 	QSplitter *_split;
 	QScrollArea *_scroll;
 	QWebEngineView *_view;
@@ -48,19 +91,76 @@ private:
 	QWidget *_top_left;
 	QWidget *_top_right;
 	LineEdit *_line;
-	// QPushButton *_back;
-	// QPushButton *_fwd;
+	QPushButton *_back;
+	QPushButton *_fwd;
 	QPushButton *_small;
 	QPushButton *_big;
 	QPushButton *_theme;
 	QLabel *_found;
+	/// Shown while the index is built
+	QProgressBar *_progress;
+	QTimer *_progress_timer;
+	/// Restarted by each key, so a burst of them is one lookup
+	QTimer *_typing_timer;
+	LookupWorker *_worker;
+	/// Of the definition to show when it's rendered, 0 if none
+	unsigned int _request;
+	std::string _request_word;
+	Source _request_source;
+	/// Of the words the list is being filled with, 0 if none
+	unsigned int _list_request;
+	/// The words being found are suggestions, not the results of a search
+	bool _list_suggestions;
+	/// Once the list is filled, the word to select again, near the row it
+	/// was in, or else the first, and whether to show the definition even
+	/// if the selection didn't change, as asked for from _keep_source
+	QString _keep_word;
+	int _keep_row;
+	bool _keep_reload;
+	Source _keep_source;
+	/// Shown now, with no word if it's a message
+	Visit _visit;
+	/// Latest last
+	VisitsT _back_visits;
+	VisitsT _fwd_visits;
+	/// Scroll to _visit.scroll once the page is loaded
+	bool _restore_scroll;
+	/// Of the index the list was filled from
+	unsigned int _generation;
+	/// The list has words spelt like the text, as nothing starts with it
+	bool _suggesting;
 
 	void set_zoom(double zoom);
 	void update_definition(const bool from_field);
-	void definition_of_list_item(std::ostringstream &out) const;
+	/// Show the page of 'out', or if 'word' is set, its definition once
+	/// it's rendered
+	void show_definition(const std::ostringstream &out,
+			     const std::string &word,
+			     const Source source);
+	/// Have the worker render, when idle, the words likely to be picked
+	/// after the one of 'row', which is -1 if none is selected
+	void prefetch_near(const int row);
+	void fill_list(const std::string &text);
+	void refresh_list(const bool reload);
+	/// Select the word to keep, and show its definition if needed
+	void list_filled();
+	/// Sets 'word' to the word whose definition should be shown, or writes
+	/// a page with a message to 'out'
+	void definition_of_list_item(std::ostringstream &out, std::string &word) const;
 	void begin_html(std::ostream &out) const;
 	void end_html(std::ostream &out) const;
 	void update_list_theme();
+	void set_page(const QString &html, const bool restore_scroll);
+	/// Show the rendered definition of 'word', a new visit unless it's
+	/// that of _visit
+	void show_visit(const std::string &word, const QString &html, const Source source);
+	/// Keep _visit to go back to, before a page asked for from 'next'
+	/// replaces it
+	void leave_visit(const Source next);
+	/// Move the latest visit of 'from' to _visit, and _visit to 'to'
+	void go(VisitsT &from, VisitsT &to);
+	void update_history_buttons();
+	void follow_link(const std::string &href, const std::string &text);
 };
 
 #endif
@@ -0,0 +1,113 @@
+#include "WordListModel.h"
+#include "Dictionary.h"
+#include <QtGui/QFont>
+#include <algorithm>
+#include <climits>
+
+/// Words read from the index at a time
+static const int g_page_size = 256;
+/// Rows searched from the top by find(), after those near the hint
+static const int g_find_limit = 4096;
+
+WordListModel::WordListModel(
+	const DictionaryRef &dict,
+	QObject *parent
+) : QAbstractListModel(parent),
+    _dict(dict),
+    _fixed(true),
+    _italic(false),
+    _count(0),
+    _page_first(0)
+{}
+
+WordListModel::~WordListModel() {}
+
+void WordListModel::set_prefix(const std::string &prefix) {
+	beginResetModel();
+	_prefix = prefix;
+	_fixed = false;
+	_italic = false;
+	_count = std::min(count_words(_dict, prefix), size_t(INT_MAX));
+	_page.clear();
+	_page_first = 0;
+	endResetModel();
+}
+
+void WordListModel::set_words(const QStringList &words, const bool italic) {
+	beginResetModel();
+	_prefix.clear();
+	_fixed = true;
+	_italic = italic;
+	_count = words.size();
+	_page.assign(words.begin(), words.end());
+	_page_first = 0;
+	endResetModel();
+}
+
+void WordListModel::clear() {
+	set_words(QStringList(), false);
+}
+
+void WordListModel::load_page(const int row) const {
+	if (	_fixed ||
+		(row >= _page_first && row - _page_first < int(_page.size()))
+	) {
+		return;
+	}
+
+	_page.clear();
+	_page_first = row - row % g_page_size;
+	list_words(_dict, _prefix, _page_first, g_page_size,
+		   [](const std::string &word, void *data) {
+			   std::vector<QString> &page = *(std::vector<QString>*)data;
+			   page.push_back(QString::fromUtf8(word.c_str()));
+		   }, &_page);
+}
+
+QString WordListModel::word(const int row) const {
+	if (row < 0 || row >= _count) {
+		return QString();
+	}
+	load_page(row);
+	const int i = row - _page_first;
+	// the index may have grown since the words were counted
+	return i >= 0 && i < int(_page.size()) ? _page[i] : QString();
+}
+
+int WordListModel::find(const QString &word, const int hint) const {
+	if (word.isEmpty()) {
+		return -1;
+	}
+
+	const int near = std::max(hint - g_page_size, 0);
+	for (int row=near; row<std::min(hint + g_page_size, _count); ++row) {
+		if (this->word(row) == word) {
+			return row;
+		}
+	}
+	for (int row=0; row<std::min(g_find_limit, _count); ++row) {
+		if (this->word(row) == word) {
+			return row;
+		}
+	}
+	return -1;
+}
+
+int WordListModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : _count;
+}
+
+QVariant WordListModel::data(const QModelIndex &index, int role) const {
+	if (!index.isValid()) {
+		return QVariant();
+	}
+	if (role == Qt::DisplayRole) {
+		return word(index.row());
+	}
+	if (role == Qt::FontRole && _italic) {
+		QFont font;
+		font.setItalic(true);
+		return font;
+	}
+	return QVariant();
+}
@@ -0,0 +1,58 @@
+#ifndef INCLUDED_WORDLISTMODEL_H
+#define INCLUDED_WORDLISTMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QStringList>
+#include <string>
+#include <vector>
+
+struct DictionaryRef;
+
+/// The words of the list next to the definition. For a prefix the words
+/// aren't copied out of the index, the number of them is counted and they
+/// are read a page at a time as the view shows their rows, so changing the
+/// prefix doesn't depend on how many words it has. Other lists, such as
+/// suggestions, are short and are kept.
+class WordListModel : public QAbstractListModel {
+Q_OBJECT
+public:
+	WordListModel(const DictionaryRef &dict, QObject *parent = NULL);
+	virtual ~WordListModel();
+
+	/// The words list_words lists for 'prefix'
+	void set_prefix(const std::string &prefix);
+	/// A list of words, shown in italics if 'italic' is set
+	void set_words(const QStringList &words, const bool italic);
+	void clear();
+
+	/// Empty if 'row' isn't a row of the list
+	QString word(const int row) const;
+	/// Row of 'word', looking near 'hint' first. Returns -1 if it isn't
+	/// found.
+	int find(const QString &word, const int hint) const;
+
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+private:
+	const DictionaryRef &_dict;
+	std::string _prefix;
+	/// Set if the words are the list in _page, rather than those of
+	/// _prefix
+	bool _fixed;
+	bool _italic;
+	int _count;
+
+	/// Rows from _page_first, all the words if _fixed is set
+	mutable std::vector<QString> _page;
+	mutable int _page_first;
+
+	/// Read the page of the words of _prefix with 'row'
+	void load_page(const int row) const;
+
+	// non-copyable
+	WordListModel(const WordListModel &);
+	WordListModel &operator=(const WordListModel &);
+};
+
+#endif
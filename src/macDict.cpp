@@ -19,20 +19,40 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <zlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <sys/stat.h>
 #include <libgen.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
-#include <map>
-#include <unordered_map>
+#include <libxml/SAX2.h>
 #include <vector>
+#include <deque>
 #include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <cctype>
 #include <cstring>
+#include <cstdlib>
 #include <cassert>
+#include <cerrno>
+#include <cstdarg>
+
+#include "Index.h"
+#include "MappedFile.h"
+#include "BlockCache.h"
+#include "PageCache.h"
+#include "Stats.h"
+#include "Inflate.h"
+#include "SharedIndex.h"
+#include "Server.h"
+#include "FullText.h"
+#include "Fold.h"
+#include "Dictionary.h"
 
 #ifdef WANT_GUI
 #include <QtWidgets/QApplication>
@@ -72,51 +92,8 @@ static const char g_xpath_other_words[] =
 	"//span[@class=\"fg\"]/span[@class=\"f\"]/text()";
 
 
-typedef std::pair<size_t, size_t> ByteRangeT;
-
-struct EntryPosition {
-	EntryPosition() : file_range(0, 0),
-			  uncompressed_range(0, 0) {}
-	EntryPosition(const ByteRangeT &fr,
-		      const ByteRangeT &ur
-	) : file_range(fr), uncompressed_range(ur) {}
-
-	/// Range of bytes in the compressed file
-	ByteRangeT file_range;
-	/// Range of bytes in the uncompressed block
-	ByteRangeT uncompressed_range;
-};
-
-class Entry {
-public:
-	Entry() {}
-	Entry(
-		const std::string &name,
-		const EntryPosition &pos
-	) : _name(name), _pos(pos) {}
-	Entry(
-		const std::string &name,
-		const std::string &content,
-		const EntryPosition &pos
-	) : _name(name), _content(content), _pos(pos) {}
-
-	/// Case sensitive
-	std::string _name;
-	/// This is only stored when the index is built. Will be empty after the
-	/// index is loaded back from disk.
-	std::string _content;
-	EntryPosition _pos;
-};
-
-/// Key is downcased
-typedef std::multimap<std::string, Entry> IndexT;
-/// Key and value are downcased
-typedef std::map<std::string, std::string> LinksT;
-typedef std::pair<IndexT::const_iterator,
-		  IndexT::const_iterator> EntryRangeT;
-typedef std::unordered_multimap<std::string, std::string> BackLinksT;
-typedef std::pair<BackLinksT::const_iterator,
-		  BackLinksT::const_iterator> BackLinksRangeT;
+/// Range [first, second) of EntryTable::sorted()
+typedef std::pair<size_t, size_t> EntryRangeT;
 
 
 /// Return true if 'x' starts with 's'
@@ -168,70 +145,6 @@ static inline void downcase(std::string &name) {
 }
 
 
-#define BUF_SIZE 16384
-static std::vector<unsigned char> g_decompress_buf;
-
-// http://zlib.net/zlib_how.html
-static int decompress_it(
-	const unsigned char *in,
-	size_t nbytes,
-	const unsigned char **next,
-	std::string &sink
-) {
-	if (g_decompress_buf.empty()) {
-		g_decompress_buf.resize(BUF_SIZE);
-	}
-	unsigned char * const out = &g_decompress_buf[0];
-
-	z_stream zst;
-	memset(&zst, 0, sizeof(zst));
-	int ret = inflateInit(&zst);
-	if (ret != Z_OK) {
-		return ret;
-	}
-
-	do {
-		const size_t next_nbytes = std::min((size_t)BUF_SIZE, nbytes);
-		if (next_nbytes == 0) {
-			break;
-		}
-		zst.avail_in = next_nbytes;
-		zst.next_in = const_cast<unsigned char*>(in);
-
-		in     += next_nbytes;
-		nbytes -= next_nbytes;
-
-		do {
-			zst.avail_out = BUF_SIZE;
-			zst.next_out = out;
-
-			ret = inflate(&zst, Z_NO_FLUSH);
-			assert(ret != Z_STREAM_ERROR);
-			switch (ret) {
-			case Z_NEED_DICT:
-			case Z_DATA_ERROR:
-			case Z_MEM_ERROR:
-				inflateEnd(&zst);
-				return ret;
-			}
-
-			const unsigned int have = BUF_SIZE - zst.avail_out;
-			for (unsigned int i=0; i<have; ++i) {
-				sink.push_back(out[i]);
-			}
-
-		} while (zst.avail_out == 0);
-
-	} while (ret != Z_STREAM_END);
-
-	if (next) {
-		*next = zst.next_in;
-	}
-
-	inflateEnd(&zst);
-	return ret == Z_STREAM_END ? Z_OK : Z_DATA_ERROR;
-}
-
 static int eval_xpath(
 	xmlDocPtr doc,
 	const char * const xpath,
@@ -269,6 +182,7 @@ static int name_from_entry(
 	std::string &name
 ) {
 	name.clear();
+	process_stats().add(Stats::XML_PARSES);
 	xmlDocPtr doc = xmlParseDoc((const xmlChar*)entry_text.c_str());
 	if (!doc) {
 		return 1;
@@ -294,641 +208,3093 @@ static int name_from_entry(
 	return 0;
 }
 
-/// Returns true if we've reached the end and parsing should stop
-static bool build_index(
-	const std::string &input,
-	IndexT &index,
-	const ByteRangeT &file_range
-) {
-	std::string::size_type pos = 4;
-	std::string entry_text, name, key;
-
-	while (true) {
+static inline bool is_xml_space(const char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
 
-		const std::string::size_type eol = input.find('\n', pos);
-		if (eol == std::string::npos) {
-			break;
+/// Returns true if the text is valid UTF-8 without characters which are
+/// not allowed in XML. libxml2 rejects the whole document otherwise.
+static bool valid_xml_text(const std::string &s) {
+	const unsigned char *p = (const unsigned char*)s.data();
+	const unsigned char * const end = p + s.size();
+	while (p < end) {
+		const unsigned char c = *p;
+		if (c < 0x80) {
+			if (c < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+				return false;
+			}
+			++p;
+			continue;
 		}
-		entry_text.assign(input, pos, eol-pos);
-
-		if (	!startswith(entry_text, "<d:entry") ||
-			!endswith(entry_text, "</d:entry>") ||
-			name_from_entry(entry_text, name) ||
-			name.empty()
+		size_t n;
+		uint32_t cp;
+		if ((c & 0xe0) == 0xc0) {
+			n = 1;
+			cp = c & 0x1f;
+		} else if ((c & 0xf0) == 0xe0) {
+			n = 2;
+			cp = c & 0x0f;
+		} else if ((c & 0xf8) == 0xf0) {
+			n = 3;
+			cp = c & 0x07;
+		} else {
+			return false;
+		}
+		if ((size_t)(end - p) <= n) {
+			return false;
+		}
+		for (size_t i=1; i<=n; ++i) {
+			if ((p[i] & 0xc0) != 0x80) {
+				return false;
+			}
+			cp = (cp << 6) | (p[i] & 0x3f);
+		}
+		// overlong, surrogates, out of range, and the non-characters
+		// excluded by XML
+		if (	(n == 1 && cp < 0x80) ||
+			(n == 2 && cp < 0x800) ||
+			(n == 3 && cp < 0x10000) ||
+			(cp >= 0xd800 && cp <= 0xdfff) ||
+			cp == 0xfffe || cp == 0xffff ||
+			cp > 0x10ffff
 		) {
-			return true;
+			return false;
 		}
-
-		key = name;
-		downcase(key);
-
-		index.insert(IndexT::value_type(
-				     key,
-				     Entry(name, entry_text,
-					   EntryPosition(file_range, ByteRangeT(pos, eol)))));
-
-		// skip bytes between entries
-		pos = eol + 5;
+		p += n+1;
 	}
-
-	return false;
+	return true;
 }
 
-static void read_all_entries(
-	size_t input,
-	const std::string &content,
-	IndexT &index
-) {
-	const std::ios_base::fmtflags flags = cerr.flags();
-	const std::streamsize prec = cerr.precision();
-
-	const size_t total_bytes = content.size();
-
-	std::string out;
-
-	for (size_t i=0; input<total_bytes; ++i) {
-
-		const unsigned char * const cur =
-			reinterpret_cast<const unsigned char*>(&content[input]);
-		const unsigned char *next = NULL;
-		const size_t remain = total_bytes - input;
+/// Append the UTF-8 encoding of 'cp'. Returns false if it isn't allowed in
+/// XML.
+static bool append_utf8(const uint32_t cp, std::string &out) {
+	if (!(	cp == 0x9 || cp == 0xa || cp == 0xd ||
+		(cp >= 0x20 && cp <= 0xd7ff) ||
+		(cp >= 0xe000 && cp <= 0xfffd) ||
+		(cp >= 0x10000 && cp <= 0x10ffff))
+	) {
+		return false;
+	}
+	if (cp < 0x80) {
+		out += char(cp);
+	} else if (cp < 0x800) {
+		out += char(0xc0 | (cp >> 6));
+		out += char(0x80 | (cp & 0x3f));
+	} else if (cp < 0x10000) {
+		out += char(0xe0 | (cp >> 12));
+		out += char(0x80 | ((cp >> 6) & 0x3f));
+		out += char(0x80 | (cp & 0x3f));
+	} else {
+		out += char(0xf0 | (cp >> 18));
+		out += char(0x80 | ((cp >> 12) & 0x3f));
+		out += char(0x80 | ((cp >> 6) & 0x3f));
+		out += char(0x80 | (cp & 0x3f));
+	}
+	return true;
+}
 
-		if (remain == 0) {
-			break;
+/// Decode the value of an attribute, as libxml2 would return it. Returns
+/// false for anything that isn't handled here, e.g. entities other than the
+/// predefined ones.
+static bool decode_attribute(const char *p, const char * const end, std::string &out) {
+	out.clear();
+	while (p < end) {
+		const char c = *p;
+		if (c == '<' || c == '\r') {
+			// an error, or line end normalisation
+			return false;
+		}
+		if (c == '\t' || c == '\n') {
+			// attribute value normalisation
+			out += ' ';
+			++p;
+			continue;
+		}
+		if (c != '&') {
+			out += c;
+			++p;
+			continue;
 		}
 
-		out.clear();
-		if (Z_OK == decompress_it(cur, remain, &next, out)) {
-			if (!next) {
-				break;
+		const char * const semi = std::find(p, end, ';');
+		if (semi == end) {
+			return false;
+		}
+		const std::string ref(p+1, semi);
+		p = semi+1;
+
+		if (ref == "lt") {
+			out += '<';
+		} else if (ref == "gt") {
+			out += '>';
+		} else if (ref == "amp") {
+			out += '&';
+		} else if (ref == "quot") {
+			out += '"';
+		} else if (ref == "apos") {
+			out += '\'';
+		} else if (ref.size() > 1 && ref[0] == '#') {
+			const bool hex = ref[1] == 'x';
+			const size_t first = hex ? 2 : 1;
+			if (first == ref.size() || ref.size() - first > 6) {
+				return false;
 			}
-			if (build_index(out, index, ByteRangeT(input, input+(next-cur)))) {
-				break;
+			uint32_t cp = 0;
+			for (size_t i=first; i<ref.size(); ++i) {
+				const char d = ref[i];
+				if (d >= '0' && d <= '9') {
+					cp = cp*(hex ? 16 : 10) + (d-'0');
+				} else if (hex && d >= 'a' && d <= 'f') {
+					cp = cp*16 + (d-'a'+10);
+				} else if (hex && d >= 'A' && d <= 'F') {
+					cp = cp*16 + (d-'A'+10);
+				} else {
+					return false;
+				}
 			}
-
-			if (i % 50 == 0) {
-				cerr << std::setprecision(2) << std::fixed <<
-					((float(input)/total_bytes)*100) << "%\t" <<
-					std::setprecision(prec) <<
-					index.size() << " entries\n";
+			if (!append_utf8(cp, out)) {
+				return false;
 			}
-
-			input += next-cur;
 		} else {
-			// error, skip ahead until we find valid compressed block
-			++input;
+			return false;
 		}
 	}
+	return true;
+}
 
-	cerr.flags(flags);
+static inline bool is_name_char(const char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		(c >= '0' && c <= '9') ||
+		c == '_' || c == ':' || c == '-' || c == '.';
 }
 
-static int read_one_entry(
-	std::ifstream &infile,
-	const EntryPosition &pos,
-	std::string &entry_text
-) {
-	entry_text.clear();
+/// Returns true if [p, end) starts with 'x'
+static inline bool starts_at(const char * const p, const char * const end, const char * const x) {
+	const size_t n = strlen(x);
+	return size_t(end - p) >= n && !memcmp(p, x, n);
+}
 
-	std::string content;
+/// Returns a pointer past the first 'x' in [p, end), or NULL
+static const char *skip_past(const char * const p, const char * const end, const char * const x) {
+	const char * const found = std::search(p, end, x, x + strlen(x));
+	return found == end ? NULL : found + strlen(x);
+}
 
-	// read range from compressed file
-	{
-		const ByteRangeT r = pos.file_range;
-		const size_t nbytes = r.second - r.first;
-		infile.seekg(r.first);
-		content.resize(nbytes);
-		if (!infile.read(&content[0], nbytes)) {
-			cerr << "failed to read byte range [" << r.first << ", " << r.second << ")\n";
-			return 1;
+/// Returns true if the elements from 'p', just after the <d:entry> start
+/// tag, nest properly and the entry ends with its end tag at 'end'.
+/// Comments, CDATA and processing instructions are skipped; attributes and
+/// text aren't checked.
+static bool elements_nest(const char *p, const char * const end) {
+	// names of the elements open within the entry
+	std::vector<std::string> open;
+	std::string name;
+
+	while (true) {
+		p = std::find(p, end, '<');
+		if (p == end) {
+			return false;
+		}
+		++p;
+
+		if (starts_at(p, end, "!--")) {
+			p = skip_past(p, end, "-->");
+		} else if (starts_at(p, end, "![CDATA[")) {
+			p = skip_past(p, end, "]]>");
+		} else if (starts_at(p, end, "?")) {
+			p = skip_past(p, end, "?>");
+		} else if (starts_at(p, end, "!")) {
+			return false;
+		} else if (starts_at(p, end, "/")) {
+			const char * const name_first = ++p;
+			while (p < end && *p != '>' && !is_xml_space(*p)) {
+				++p;
+			}
+			name.assign(name_first, p);
+			while (p < end && is_xml_space(*p)) {
+				++p;
+			}
+			if (p == end || *p != '>') {
+				return false;
+			}
+			++p;
+			if (open.empty()) {
+				return p == end && name == "d:entry";
+			}
+			if (name != open.back()) {
+				return false;
+			}
+			open.pop_back();
+		} else {
+			const char * const name_first = p;
+			while (p < end && *p != '>' && *p != '/' && !is_xml_space(*p)) {
+				++p;
+			}
+			if (p == name_first) {
+				return false;
+			}
+			name.assign(name_first, p);
+			// to the end of the tag, skipping quoted values
+			while (p < end && *p != '>') {
+				if (*p == '"' || *p == '\'') {
+					p = std::find(p+1, end, *p);
+					if (p == end) {
+						return false;
+					}
+				} else if (*p == '<') {
+					return false;
+				}
+				++p;
+			}
+			if (p == end) {
+				return false;
+			}
+			if (*(p-1) != '/') {
+				open.push_back(name);
+			}
+			++p;
 		}
 
-		if (!entry_text.capacity()) {
-			entry_text.reserve(nbytes);
+		if (!p) {
+			return false;
 		}
 	}
+}
+
+/// Read the title from the <d:entry> start tag without parsing the whole
+/// entry. Returns 0 and sets 'name' to the title, as name_from_entry would
+/// return it for a well-formed entry. Returns 1 if the start tag has
+/// anything which isn't handled here, or the elements don't nest, in which
+/// case name_from_entry should be used instead. This is more lenient than
+/// libxml2: the rest of the entry is only checked with elements_nest, so an
+/// entry libxml2 would reject for e.g. a bad attribute or entity in a later
+/// element still gets a title.
+static int scan_entry_title(
+	const std::string &entry_text,
+	std::string &name
+) {
+	name.clear();
 
-	if (Z_OK == decompress_it(
-		    reinterpret_cast<const unsigned char*>(&content[0]),
-		    content.size(), NULL, entry_text)
+	if (	!startswith(entry_text, "<d:entry") ||
+		!valid_xml_text(entry_text)
 	) {
-		// keep range in uncompressed block corresponding to the entry
-		const size_t nbytes = entry_text.size();
-		const ByteRangeT r = pos.uncompressed_range;
-		if (	r.first > nbytes ||
-			r.second > nbytes
-		) {
-			cerr << "uncompressed block is " << nbytes << " bytes, "
-				"entry [" << r.first << ", " << r.second << ") was out-of-range\n";
-			return 1;
-		}
-		entry_text.erase(r.second, nbytes-r.second);
-		entry_text.erase(0, r.first);
-	} else {
-		cerr << "failed to decompress entry from file range [" <<
-			pos.file_range.first << ", " <<
-			pos.file_range.second << ")\n";
 		return 1;
 	}
 
-	return 0;
-}
+	const char *p = entry_text.data() + 8;
+	const char * const end = entry_text.data() + entry_text.size();
 
-struct FindLinks {
-public:
-	FindLinks(
-		const IndexT &index,
-		LinksT &links,
-		BackLinksT &backlinks
-	) : _index(index),
-	    _links(links),
-	    _backlinks(backlinks) {}
+	bool have_ns = false;
+	int num_titles = 0;
+	std::vector<std::string> names;
 
-	/// 'r' is the range of index entries for a single word. Some words have
-	/// multiple definitions.
-	void operator()(const EntryRangeT &r) {
-		if (r.first == r.second) {
-			return;
+	while (true) {
+		// attributes must be separated by whitespace
+		if (p == end || !(is_xml_space(*p) || *p == '>')) {
+			return 1;
 		}
-		const std::string &key = r.first->first;
-
-		xmlDocPtr doc = parse_entry_for_links(r);
-		if (!doc) {
-			return;
+		while (p < end && is_xml_space(*p)) {
+			++p;
+		}
+		if (p == end || *p == '/') {
+			return 1;
+		}
+		if (*p == '>') {
+			break;
 		}
 
-		_words.clear();
-		find_words(doc, g_xpath_also_words);
-
-		// other spellings and abbreviations
-		for (const std::string &w : _words) {
-			if (w != key && _index.find(w) != _index.end()) {
-				// e.g. rum -> rhum
-				_backlinks.insert(BackLinksT::value_type(w, key));
-			}
+		// attribute name, ASCII only
+		const char * const name_first = p;
+		if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_')) {
+			return 1;
+		}
+		while (p < end && is_name_char(*p)) {
+			++p;
+		}
+		const std::string attr(name_first, p);
+		if (std::find(names.begin(), names.end(), attr) != names.end()) {
+			// duplicate attribute is an error
+			return 1;
 		}
+		names.push_back(attr);
 
-		find_words(doc, g_xpath_derivatives);
-		find_words(doc, g_xpath_other_words);
-		find_words(doc, g_xpath_phrases);
-		find_words(doc, g_xpath_phrases_other);
-		find_words(doc, g_xpath_phrasal_verbs);
-		_words.erase(key);
+		while (p < end && is_xml_space(*p)) {
+			++p;
+		}
+		if (p == end || *p != '=') {
+			return 1;
+		}
+		++p;
+		while (p < end && is_xml_space(*p)) {
+			++p;
+		}
+		if (p == end || (*p != '"' && *p != '\'')) {
+			return 1;
+		}
+		const char quote = *p++;
+		const char * const value_first = p;
+		p = std::find(p, end, quote);
+		if (p == end) {
+			return 1;
+		}
+		const char * const value_last = p++;
 
-		xmlFreeDoc(doc);
+		const std::string::size_type colon = attr.find(':');
+		if (colon != std::string::npos && attr.find(':', colon+1) != std::string::npos) {
+			return 1;
+		}
+		const std::string prefix = colon == std::string::npos ? "" : attr.substr(0, colon);
+		const std::string local = colon == std::string::npos ? attr : attr.substr(colon+1);
 
-		for (const std::string &w : _words) {
-			if (_index.find(w) != _index.end()) {
-				continue;
+		if (attr == "xmlns:d") {
+			if (value_first == value_last) {
+				return 1;
+			}
+			have_ns = true;
+		} else if (local == "title" && prefix != "xmlns") {
+			if (	(prefix != "" && prefix != "d") ||
+				!decode_attribute(value_first, value_last, name)
+			) {
+				return 1;
 			}
-			_links.insert(LinksT::value_type(w, key));
+			++num_titles;
 		}
+	}
 
+	if (!have_ns || num_titles != 1 || !elements_nest(p+1, end)) {
+		name.clear();
+		return 1;
 	}
+	return 0;
+}
 
-private:
-	std::set<std::string> _tmp, _words;
-	const IndexT &_index;
-	LinksT &_links;
-	BackLinksT &_backlinks;
+/// Counts of how the headwords were read while building the index
+struct HeadwordCounts {
+	HeadwordCounts() : scanned(0), parsed(0), mismatched(0) {}
 
-	void find_words(xmlDocPtr doc, const char * const xpath) {
-		_tmp.clear();
-		eval_xpath(doc, xpath, _tmp);
-		for (const std::string &t : _tmp) {
-			std::string s(t);
-			strip(s);
-			downcase(s);
-			_words.insert(s);
+	/// Read by scan_entry_title
+	std::atomic<size_t> scanned;
+	/// Read by name_from_entry
+	std::atomic<size_t> parsed;
+	/// Verified entries where the two differ
+	std::atomic<size_t> mismatched;
+};
+
+/// Read the title of an entry. Uses scan_entry_title, falling back to
+/// parsing with libxml2. If 'verify' is set, both are used and compared,
+/// and the libxml2 result is returned.
+static int headword_from_entry(
+	const std::string &entry_text,
+	const bool verify,
+	HeadwordCounts &counts,
+	std::string &name
+) {
+	if (!verify) {
+		if (!scan_entry_title(entry_text, name)) {
+			++counts.scanned;
+			return 0;
 		}
+		++counts.parsed;
+		return name_from_entry(entry_text, name);
 	}
 
-	/// Caller must free returned object
-	static xmlDocPtr parse_entry_for_links(const EntryRangeT &r) {
-		const size_t num = std::distance(r.first, r.second);
-		if (num > 1) {
-			std::string content("<div>");
-			for (	IndexT::const_iterator
-				it=r.first; it!=r.second; ++it
-			) {
-				content += it->second._content;
+	std::string scanned;
+	const int scan_ret = scan_entry_title(entry_text, scanned);
+	const int ret = name_from_entry(entry_text, name);
+	++counts.parsed;
+	if (!scan_ret) {
+		++counts.scanned;
+		if (ret || scanned != name) {
+			if (counts.mismatched++ < 10) {
+				cerr << "Headword mismatch, scanner \"" << scanned <<
+					"\", libxml2 \"" << name << "\" in " <<
+					entry_text.substr(0, 200) << "\n";
 			}
-			content += "</div>";
+		}
+	}
+	return ret;
+}
+
+/// Add the entries of the inflated block 'input' to 'entries', which is
+/// the last block of the table. Returns true if we've reached the end and
+/// parsing should stop.
+static bool build_index(
+	const std::string &input,
+	EntryTable &entries,
+	const bool verify,
+	HeadwordCounts &counts
+) {
+	std::string::size_type pos = 4;
+	std::string entry_text, name;
 
-			return xmlParseDoc((xmlChar*)content.c_str());
+	while (true) {
 
-		} else if (num == 1) {
-			const std::string &content = r.first->second._content;
-			return xmlParseDoc((xmlChar*)content.c_str());
+		const std::string::size_type eol = input.find('\n', pos);
+		if (eol == std::string::npos) {
+			break;
 		}
-		return NULL;
-	}
+		entry_text.assign(input, pos, eol-pos);
 
-	// non-copyable
-	FindLinks(const FindLinks &);
-	FindLinks &operator=(const FindLinks &);
-};
+		if (	!startswith(entry_text, "<d:entry") ||
+			!endswith(entry_text, "</d:entry>") ||
+			headword_from_entry(entry_text, verify, counts, name) ||
+			name.empty()
+		) {
+			return true;
+		}
 
+		entries.add(name, ByteRangeT(pos, eol));
 
-static inline bool file_exists(const char * const fn) {
-	struct stat s;
-	return 0 == stat(fn, &s) && (S_ISREG(s.st_mode));
+		// skip bytes between entries
+		pos = eol + 5;
+	}
+
+	return false;
 }
 
-static inline void write_string(const std::string &s, std::ostream &out) {
-	unsigned int n = s.size();
-	out.write((const char*)&n, sizeof(n));
-	out.write(s.c_str(), n);
+static inline uint32_t read_le32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
-static inline std::istream &read_string(std::string &s, std::istream &in) {
-	unsigned int n;
-	if (in.read((char*)&n, sizeof(n))) {
-		s.resize(n);
-		in.read((char*)&s[0], n);
+/// Body.data starts with 0x40 bytes we don't use, then the size of the rest
+/// of the file at 0x40 as a little-endian uint32, and the blocks from 0x60.
+/// Each block has a header of three little-endian uint32:
+///   - size of the rest of the block, i.e. the zlib stream plus 8
+///   - size of the zlib stream plus 4
+///   - size of the inflated block
+/// followed by the zlib stream.
+static const size_t g_body_size_offset = 0x40;
+static const size_t g_body_blocks_offset = 0x60;
+static const size_t g_block_header_size = 12;
+
+/// End of the blocks in Body.data
+static size_t body_end(const MappedFile &content) {
+	const size_t size = content.size();
+	if (size < g_body_blocks_offset) {
+		return size;
 	}
-	return in;
+	const size_t limit = g_body_size_offset + read_le32(content.data() + g_body_size_offset);
+	return limit >= g_body_blocks_offset && limit <= size ? limit : size;
 }
 
-static void write_index(
-	const IndexT &index,
-	const LinksT &links,
-	const BackLinksT &backlinks,
-	std::ostream &out
+/// Follows the block headers of Body.data from the one at 'input', adding
+/// a block to 'blocks' for each valid header. Returns where the headers
+/// stopped making sense, which is 'end' if they all did.
+static size_t read_block_headers(
+	const MappedFile &content,
+	size_t input,
+	const size_t end,
+	BlockDirectoryT &blocks
 ) {
-	out.write("DICT", 4);
-
-	unsigned char version = 1;
-	out.write((const char*)&version, sizeof(version));
+	const unsigned char * const data = content.data();
+	while (input < end && end - input >= g_block_header_size + 2) {
+		const unsigned char * const h = data + input;
+		const size_t block_size = read_le32(h);
+		const size_t stream_size = read_le32(h + 4);
+		const size_t uncompressed_size = read_le32(h + 8);
+		const size_t first = input + g_block_header_size;
+		// zlib header: deflate, and a check of the first two bytes
+		if (	block_size < 8 + 2 ||
+			block_size - 8 > end - first ||
+			stream_size != block_size - 4 ||
+			(h[12] & 0x0f) != 8 ||
+			((h[12] << 8) | h[13]) % 31
+		) {
+			return input;
+		}
+		const size_t last = first + block_size - 8;
+		blocks.push_back(BlockInfo(ByteRangeT(first, last), uncompressed_size));
+		input = last;
+	}
+	// anything left is too short to be a block
+	return end;
+}
 
-	size_t n = index.size();
-	out.write((const char*)&n, sizeof(n));
-	for (	IndexT::const_iterator
-		it=index.begin(); it!=index.end(); ++it
-	) {
-		write_string(it->first, out);
-		write_string(it->second._name, out);
+/// Inflate 'block' into 'out'. When the size of the block is known the
+/// inflate goes straight into a buffer of that size. Sets the size of
+/// 'block' to the actual size.
+static int inflate_body_block(
+	const MappedFile &content,
+	BlockInfo &block,
+	std::string &out
+) {
+	PhaseTimer timer(Stats::PHASE_INFLATE);
 
-		const EntryPosition &pos = it->second._pos;
-		out.write((const char*)&pos.file_range.first,	       sizeof(size_t));
-		out.write((const char*)&pos.file_range.second,	       sizeof(size_t));
-		out.write((const char*)&pos.uncompressed_range.first,  sizeof(size_t));
-		out.write((const char*)&pos.uncompressed_range.second, sizeof(size_t));
+	const ByteRangeT &r = block.file_range;
+	if (r.first > r.second || r.second > content.size()) {
+		return 1;
 	}
-
-	n = links.size();
-	out.write((const char*)&n, sizeof(n));
-	for (	LinksT::const_iterator
-		it=links.begin(); it!=links.end(); ++it
-	) {
-		write_string(it->first, out);
-		write_string(it->second, out);
+	const unsigned char * const in = content.data() + r.first;
+	const size_t nbytes = r.second - r.first;
+
+	Stats &stats = process_stats();
+	stats.add(Stats::BLOCKS_INFLATED);
+	stats.add(Stats::BYTES_IN, nbytes);
+
+	if (block.uncompressed_size) {
+		out.resize(block.uncompressed_size);
+		size_t produced = 0;
+		if (0 == inflate_block(in, nbytes, NULL,
+				       (unsigned char*)&out[0], out.size(), produced)
+		) {
+			out.resize(produced);
+			block.uncompressed_size = produced;
+			stats.add(Stats::BYTES_OUT, produced);
+			return 0;
+		}
+		// the header was wrong
 	}
 
-	n = backlinks.size();
-	out.write((const char*)&n, sizeof(n));
-	for (	BackLinksT::const_iterator
-		it=backlinks.begin(); it!=backlinks.end(); ++it
-	) {
-		write_string(it->first, out);
-		write_string(it->second, out);
+	out.clear();
+	if (inflate_block(in, nbytes, NULL, &out)) {
+		return 1;
 	}
+	block.uncompressed_size = out.size();
+	stats.add(Stats::BYTES_OUT, out.size());
+	return 0;
 }
 
-static int read_index(
-	IndexT &index,
-	LinksT &links,
-	BackLinksT &backlinks,
-	std::istream &in
-) {
+/// Called each time entries are added to the index while it is built,
+/// with the fraction of Body.data read. Returns false to stop building.
+typedef bool (*IndexProgressFuncT)(
+	EntryTable &index,
+	const BlockDirectoryT &blocks,
+	const double progress,
+	void *data);
+
+/// Entries parsed from one compressed block
+struct BlockEntries {
+	BlockEntries(const BlockInfo &b) : block(b), stop(false), done(false) {}
+
+	BlockInfo block;
+	/// With the inflated block as its only block
+	EntryTable entries;
+	/// An invalid entry was found, nothing after it should be indexed
+	bool stop;
+	/// Set by the worker once 'entries' and 'stop' are final
+	bool done;
+};
+
+/// Reads all entries with a pipeline of threads. One thread finds the
+/// compressed blocks from their headers, a pool of workers inflates the
+/// blocks and parses the headwords, and the calling thread merges the
+/// results into the index in file order, so the index is the same as if
+/// the blocks were read one after another. If the headers are damaged the
+/// rest of the blocks are found by trying to inflate at each byte.
+class BlockPipeline {
+public:
+	BlockPipeline(
+		const MappedFile &content,
+		const unsigned int nthreads,
+		const bool verify,
+		HeadwordCounts &counts,
+		IndexProgressFuncT progress,
+		void *progress_data
+	) : _content(content),
+	    _nthreads(std::max(nthreads, 1U)),
+	    _verify(verify),
+	    _counts(counts),
+	    _progress(progress),
+	    _progress_data(progress_data),
+	    _found(0),
+	    _claimed(0),
+	    _merged(0),
+	    _finding_done(false),
+	    _stop(false) {}
+
+	void run(EntryTable &index, BlockDirectoryT &blocks) {
+		std::vector<std::thread> threads;
+		threads.push_back(std::thread(&BlockPipeline::find_blocks, this));
+		for (unsigned int i=0; i<_nthreads; ++i) {
+			threads.push_back(std::thread(&BlockPipeline::inflate_blocks, this));
+		}
+
+		merge(index, blocks);
+
+		for (size_t i=0; i<threads.size(); ++i) {
+			threads[i].join();
+		}
+	}
+
+private:
+	const MappedFile &_content;
+	const unsigned int _nthreads;
+	const bool _verify;
+	HeadwordCounts &_counts;
+	IndexProgressFuncT _progress;
+	void *_progress_data;
+
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	/// Blocks found but not yet merged. References to the elements stay
+	/// valid while other elements are pushed or popped.
+	std::deque<BlockEntries> _pending;
+	/// Number of blocks found, given to a worker, and merged
+	size_t _found, _claimed, _merged;
+	bool _finding_done;
+	bool _stop;
+
+	/// Limit on blocks held in memory waiting to be merged
+	size_t max_pending() const {
+		return 16 * _nthreads;
+	}
+
+	/// Queue a block for the workers. Returns false if the pipeline
+	/// stopped.
+	bool push_block(const BlockInfo &block) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		_cond.wait(lock, [this]() {
+			return _stop || _found - _merged < max_pending();
+		});
+		if (_stop) {
+			return false;
+		}
+		_pending.emplace_back(block);
+		++_found;
+		_cond.notify_all();
+		return true;
+	}
+
+	void find_blocks() {
+		const size_t end = body_end(_content);
+		size_t input = std::min(g_body_blocks_offset, end);
+		bool resync = false;
+
+		while (input < end) {
+			BlockDirectoryT headers;
+			size_t next;
+			{
+				PhaseTimer timer(Stats::PHASE_FILE_READ);
+				next = read_block_headers(_content, input, end, headers);
+			}
+			for (size_t i=0; i<headers.size(); ++i) {
+				if (!push_block(headers[i])) {
+					return;
+				}
+			}
+			input = next;
+			if (input >= end) {
+				break;
+			}
+
+			if (!resync) {
+				cerr << "Block header at " << input << " is invalid, "
+					"searching for the next block\n";
+				resync = true;
+			}
+			size_t consumed = 0;
+			{
+				PhaseTimer timer(Stats::PHASE_FILE_READ);
+				while (input < end) {
+					const unsigned char * const cur = _content.data() + input;
+					if (0 == inflate_block(cur, end - input, &consumed, NULL)) {
+						break;
+					}
+					// error, skip ahead until we find valid compressed block
+					process_stats().add(Stats::RESYNC_FAILED);
+					++input;
+				}
+			}
+			if (input < end) {
+				if (!push_block(BlockInfo(ByteRangeT(input, input+consumed), 0))) {
+					return;
+				}
+				// carry on from the header of the next block
+				input += consumed;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_finding_done = true;
+		_cond.notify_all();
+	}
+
+	void inflate_blocks() {
+		// libxml2 settings are per thread
+		xmlKeepBlanksDefault(0);
+
+		std::string out;
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true) {
+			_cond.wait(lock, [this]() {
+				return _stop || _claimed < _found || _finding_done;
+			});
+			if (_stop || _claimed == _found) {
+				return;
+			}
+
+			BlockEntries &b = _pending[_claimed - _merged];
+			++_claimed;
+			lock.unlock();
+
+			if (0 == inflate_body_block(_content, b.block, out)) {
+				const std::string &text =
+					b.entries.add_block(b.block.file_range, out);
+				PhaseTimer timer(Stats::PHASE_HEADWORDS);
+				b.stop = build_index(text, b.entries, _verify, _counts);
+			} else {
+				b.stop = true;
+			}
+
+			lock.lock();
+			b.done = true;
+			_cond.notify_all();
+		}
+	}
+
+	void merge(EntryTable &index, BlockDirectoryT &blocks) {
+		const std::ios_base::fmtflags flags = cerr.flags();
+		const std::streamsize prec = cerr.precision();
+
+		const size_t total_bytes = _content.size();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true) {
+			_cond.wait(lock, [this]() {
+				return (_merged < _found && _pending.front().done) ||
+					(_finding_done && _merged == _found);
+			});
+			if (_merged == _found) {
+				break;
+			}
+
+			EntryTable entries;
+			entries.append(_pending.front().entries);
+			const ByteRangeT r = _pending.front().block.file_range;
+			const bool stop = _pending.front().stop;
+			blocks.push_back(_pending.front().block);
+			_pending.pop_front();
+			const size_t i = _merged++;
+			_cond.notify_all();
+			lock.unlock();
+
+			index.append(entries);
+
+			if (!stop && i % 50 == 0) {
+				cerr << std::setprecision(2) << std::fixed <<
+					((float(r.first)/total_bytes)*100) << "%\t" <<
+					std::setprecision(prec) <<
+					index.size() << " entries\n";
+			}
+
+			const bool cancel =
+				!stop && _progress &&
+				!_progress(index, blocks, double(r.second)/total_bytes,
+					   _progress_data);
+
+			lock.lock();
+			if (stop || cancel) {
+				_stop = true;
+				_cond.notify_all();
+				break;
+			}
+		}
+
+		cerr.flags(flags);
+	}
+
+	// non-copyable
+	BlockPipeline(const BlockPipeline &);
+	BlockPipeline &operator=(const BlockPipeline &);
+};
+
+/// Index all the entries of 'content', and list the blocks they are in.
+/// 'progress' may be NULL.
+static void read_all_entries(
+	const MappedFile &content,
+	const unsigned int nthreads,
+	const bool verify,
+	HeadwordCounts &counts,
+	IndexProgressFuncT progress,
+	void *progress_data,
+	EntryTable &index,
+	BlockDirectoryT &blocks
+) {
+	BlockPipeline pipeline(content, nthreads, verify, counts, progress, progress_data);
+	pipeline.run(index, blocks);
+}
+
+/// Inflate the compressed block at 'r', or get it from the cache.
+/// 'uncompressed_size' is the size of the block if known, otherwise 0.
+static int read_block(
+	const MappedFile &infile,
+	BlockCache &cache,
+	const ByteRangeT &r,
+	const size_t uncompressed_size,
+	BlockCache::PtrT &block
+) {
+	block = cache.get(r);
+	if (block) {
+		return 0;
+	}
+
+	if (r.first > r.second || r.second > infile.size()) {
+		cerr << "byte range [" << r.first << ", " << r.second << ") is outside the file\n";
+		return 1;
+	}
+
+	std::shared_ptr<std::string> out = std::make_shared<std::string>();
+	BlockInfo info(r, uncompressed_size);
+	if (inflate_body_block(infile, info, *out)) {
+		cerr << "failed to decompress entry from file range [" <<
+			r.first << ", " << r.second << ")\n";
+		return 1;
+	}
+
+	block = out;
+	cache.put(r, block);
+	return 0;
+}
+
+/// Read the text of each entry in 'pos' into 'entry_texts'. Entries in the
+/// same compressed block are read with one inflate. The text of an entry
+/// which fails to read is left empty.
+static void read_entries(
+	const MappedFile &infile,
+	const MappedIndex &index,
+	BlockCache &cache,
+	const std::vector<EntryPosition> &pos,
+	std::vector<std::string> &entry_texts
+) {
+	entry_texts.assign(pos.size(), std::string());
+
+	// group by block
+	std::vector<size_t> order(pos.size());
+	for (size_t i=0; i<order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&pos](size_t a, size_t b) {
+			return pos[a].file_range < pos[b].file_range;
+		});
+
+	BlockCache::PtrT block;
+	for (size_t k=0; k<order.size(); ++k) {
+		const EntryPosition &p = pos[order[k]];
+
+		if (k == 0 || pos[order[k-1]].file_range != p.file_range) {
+			if (read_block(infile, cache, p.file_range,
+				       index.uncompressed_size(p.file_range), block)
+			) {
+				block.reset();
+			}
+		}
+		if (!block) {
+			continue;
+		}
+
+		// keep range in uncompressed block corresponding to the entry
+		const size_t nbytes = block->size();
+		const ByteRangeT r = p.uncompressed_range;
+		if (	r.first > nbytes ||
+			r.second > nbytes ||
+			r.first > r.second
+		) {
+			cerr << "uncompressed block is " << nbytes << " bytes, "
+				"entry [" << r.first << ", " << r.second << ") was out-of-range\n";
+			continue;
+		}
+		entry_texts[order[k]].assign(*block, r.first, r.second - r.first);
+	}
+}
+
+/// Finds the same text nodes as the XPath queries, in one pass over the
+/// text of the entries with the libxml2 SAX2 parser, without building a
+/// tree. Whitespace-only text is ignored.
+class LinkScanner {
+public:
+	LinkScanner() : _also(NULL), _other(NULL) {
+		memset(&_sax, 0, sizeof(_sax));
+		_sax.initialized	 = XML_SAX2_MAGIC;
+		_sax.startElementNs	 = start_element;
+		_sax.endElementNs	 = end_element;
+		_sax.characters		 = characters;
+		_sax.ignorableWhitespace = characters;
+		_sax.cdataBlock		 = cdata_block;
+		_sax.comment		 = comment;
+		_sax.processingInstruction = processing_instruction;
+		_sax.warning		 = xmlParserWarning;
+		_sax.error		 = xmlParserError;
+		_sax.fatalError		 = xmlParserError;
+	}
+
+	/// Returns non-zero if 'text' isn't well-formed XML. 'also' gets the
+	/// text matched by g_xpath_also_words, 'other' the text matched by the
+	/// other queries.
+	int operator()(
+		const std::string &text,
+		std::set<std::string> &also,
+		std::set<std::string> &other
+	) {
+		_also = &also;
+		_other = &other;
+		_stack.clear();
+		_text.clear();
+
+		process_stats().add(Stats::XML_PARSES);
+		xmlParserCtxtPtr ctxt = xmlCreatePushParserCtxt(&_sax, this, NULL, 0, NULL);
+		if (!ctxt) {
+			return 1;
+		}
+		xmlParseChunk(ctxt, text.data(), text.size(), 1);
+		const int ret = ctxt->wellFormed ? 0 : 1;
+		xmlFreeParserCtxt(ctxt);
+		return ret;
+	}
+
+private:
+	struct Element {
+		/// <span> without a namespace, as the queries match
+		bool span;
+		// classes and roles tested by the queries
+		bool hg, vg, v, fg, f;
+		bool derivatives, x_xoh, text_not_gg;
+		bool phrases, phrasal_verbs, text_l;
+		/// A span above this element has the class
+		bool in_derivatives, in_phrases, in_phrasal_verbs;
+	};
+
+	xmlSAXHandler _sax;
+	std::vector<Element> _stack;
+	/// Text of the current text node
+	std::string _text;
+	std::set<std::string> *_also, *_other;
+
+	static inline bool contains(const std::string &s, const char * const x) {
+		return s.find(x) != std::string::npos;
+	}
+
+	/// Add the text node 'text', a child of the element on top of the stack
+	void text_node(const std::string &text) {
+		const size_t n = _stack.size();
+		if (!n) {
+			return;
+		}
+		bool blank = true;
+		for (size_t i=0; i<text.size() && blank; ++i) {
+			blank = std::isspace(static_cast<unsigned char>(text[i]));
+		}
+		if (blank) {
+			return;
+		}
+
+		const Element &e = _stack[n-1];
+		const Element * const parent = n > 1 ? &_stack[n-2] : NULL;
+		const Element * const grandparent = n > 2 ? &_stack[n-3] : NULL;
+
+		// g_xpath_also_words
+		if (e.v && parent && parent->vg && grandparent && grandparent->hg) {
+			_also->insert(text);
+		}
+
+		if (	// g_xpath_derivatives
+			(e.text_not_gg && parent && parent->x_xoh && parent->in_derivatives) ||
+			// g_xpath_other_words
+			(e.f && parent && parent->fg) ||
+			// g_xpath_phrases
+			(e.text_l && e.in_phrases) ||
+			// g_xpath_phrases_other
+			(e.v && parent && parent->vg && parent->in_phrases) ||
+			// g_xpath_phrasal_verbs
+			(e.text_l && e.in_phrasal_verbs)
+		) {
+			_other->insert(text);
+		}
+	}
+
+	void flush_text() {
+		if (!_text.empty()) {
+			text_node(_text);
+			_text.clear();
+		}
+	}
+
+	static void start_element(
+		void *ctx,
+		const xmlChar *localname,
+		const xmlChar *prefix,
+		const xmlChar *URI,
+		int nb_namespaces,
+		const xmlChar **namespaces,
+		int nb_attributes,
+		int nb_defaulted,
+		const xmlChar **attributes
+	) {
+		LinkScanner &self = *(LinkScanner*)ctx;
+		self.flush_text();
+
+		Element e;
+		memset(&e, 0, sizeof(e));
+		if (!self._stack.empty()) {
+			const Element &parent = self._stack.back();
+			e.in_derivatives   = parent.in_derivatives   || parent.derivatives;
+			e.in_phrases	   = parent.in_phrases	     || parent.phrases;
+			e.in_phrasal_verbs = parent.in_phrasal_verbs || parent.phrasal_verbs;
+		}
+
+		e.span = !URI && !strcmp((const char*)localname, "span");
+		if (e.span) {
+			bool have_class = false;
+			std::string cls, role, value;
+			for (int i=0; i<nb_attributes; ++i) {
+				const xmlChar ** const attr = attributes + i*5;
+				if (attr[2]) {
+					// in a namespace
+					continue;
+				}
+				const char * const first = (const char*)attr[3];
+				const char * const last = (const char*)attr[4];
+				if (	std::find(first, last, '&') == last ||
+					!decode_attribute(first, last, value)
+				) {
+					value.assign(first, last);
+				}
+				if (!strcmp((const char*)attr[0], "class")) {
+					cls = value;
+					have_class = true;
+				} else if (!strcmp((const char*)attr[0], "role")) {
+					role = value;
+				}
+			}
+
+			e.hg		= contains(cls, "hg");
+			e.vg		= have_class && cls == "vg";
+			e.v		= have_class && cls == "v";
+			e.fg		= have_class && cls == "fg";
+			e.f		= have_class && cls == "f";
+			e.derivatives	= contains(cls, "t_derivatives");
+			e.x_xoh		= contains(cls, "x_xoh");
+			e.text_not_gg	= role == "text" && !(have_class && (cls == "gg" || cls == "posg"));
+			e.phrases	= contains(cls, "t_phrases");
+			e.phrasal_verbs = contains(cls, "t_phrasalVerbs");
+			e.text_l	= role == "text" && contains(cls, "l");
+		}
+
+		self._stack.push_back(e);
+	}
+
+	static void end_element(
+		void *ctx,
+		const xmlChar *localname,
+		const xmlChar *prefix,
+		const xmlChar *URI
+	) {
+		LinkScanner &self = *(LinkScanner*)ctx;
+		self.flush_text();
+		if (!self._stack.empty()) {
+			self._stack.pop_back();
+		}
+	}
+
+	static void characters(void *ctx, const xmlChar *ch, int len) {
+		LinkScanner &self = *(LinkScanner*)ctx;
+		// adjacent text is one node
+		self._text.append((const char*)ch, len);
+	}
+
+	static void cdata_block(void *ctx, const xmlChar *value, int len) {
+		LinkScanner &self = *(LinkScanner*)ctx;
+		self.flush_text();
+		// a separate node, but also matched by text()
+		self.text_node(std::string((const char*)value, len));
+	}
+
+	static void comment(void *ctx, const xmlChar *value) {
+		((LinkScanner*)ctx)->flush_text();
+	}
+
+	static void processing_instruction(void *ctx, const xmlChar *target, const xmlChar *data) {
+		((LinkScanner*)ctx)->flush_text();
+	}
+
+	// non-copyable
+	LinkScanner(const LinkScanner &);
+	LinkScanner &operator=(const LinkScanner &);
+};
+
+/// Counts of how links were found while building the index
+struct LinkCounts {
+	LinkCounts() : verified(0), mismatched(0) {}
+
+	/// Headwords for which both the XPath queries and LinkScanner were used
+	std::atomic<size_t> verified;
+	/// Verified headwords where the two differ
+	std::atomic<size_t> mismatched;
+};
+
+struct FindLinks {
+public:
+	/// If 'verify' is set, the XPath queries are used as well as
+	/// LinkScanner, and differences are counted.
+	FindLinks(
+		const EntryTable &index,
+		PairTable &links,
+		PairTable &backlinks,
+		const bool verify,
+		LinkCounts &counts
+	) : _index(index),
+	    _links(links),
+	    _backlinks(backlinks),
+	    _verify(verify),
+	    _counts(counts) {}
+
+	/// 'r' is the range of index entries for a single word. Some words have
+	/// multiple definitions.
+	void operator()(const EntryRangeT &r) {
+		if (r.first == r.second) {
+			return;
+		}
+		_index.key(_index.sorted()[r.first], _key);
+		const std::string &key = _key;
+
+		entry_text_for_links(r, _text);
+
+		if (_verify) {
+			if (find_words_xpath(_text, _also, _other)) {
+				return;
+			}
+			std::set<std::string> also, other;
+			const bool same = !find_words_scan(_text, also, other) &&
+				also == _also && other == _other;
+			++_counts.verified;
+			if (!same && _counts.mismatched++ < 10) {
+				cerr << "Links mismatch between XPath and scanner for \"" << key << "\"\n";
+			}
+		} else if (find_words_scan(_text, _also, _other)) {
+			return;
+		}
+
+		// other spellings and abbreviations
+		for (const std::string &w : _also) {
+			if (w != key && _index.contains(w)) {
+				// e.g. rum -> rhum
+				_backlinks.add(w, key);
+			}
+		}
+
+		_other.insert(_also.begin(), _also.end());
+		_other.erase(key);
+
+		for (const std::string &w : _other) {
+			if (_index.contains(w)) {
+				continue;
+			}
+			// the first link of a word wins when the links are sorted
+			_links.add(w, key);
+		}
+
+	}
+
+private:
+	std::string _key, _text;
+	std::set<std::string> _tmp, _also, _other;
+	LinkScanner _scan;
+	const EntryTable &_index;
+	PairTable &_links;
+	PairTable &_backlinks;
+	const bool _verify;
+	LinkCounts &_counts;
+
+	/// Strip, downcase, and add the words in 'tmp' to 'words'
+	static void add_words(const std::set<std::string> &tmp, std::set<std::string> &words) {
+		for (const std::string &t : tmp) {
+			std::string s(t);
+			strip(s);
+			if (s.empty()) {
+				continue;
+			}
+			downcase(s);
+			words.insert(s);
+		}
+	}
+
+	/// Returns non-zero if the text couldn't be parsed
+	int find_words_scan(
+		const std::string &text,
+		std::set<std::string> &also,
+		std::set<std::string> &other
+	) {
+		std::set<std::string> tmp_also;
+		_tmp.clear();
+		if (_scan(text, tmp_also, _tmp)) {
+			return 1;
+		}
+		also.clear();
+		other.clear();
+		add_words(tmp_also, also);
+		add_words(_tmp, other);
+		return 0;
+	}
+
+	/// Returns non-zero if the text couldn't be parsed
+	int find_words_xpath(
+		const std::string &text,
+		std::set<std::string> &also,
+		std::set<std::string> &other
+	) {
+		process_stats().add(Stats::XML_PARSES);
+		xmlDocPtr doc = xmlParseDoc((const xmlChar*)text.c_str());
+		if (!doc) {
+			return 1;
+		}
+		also.clear();
+		other.clear();
+
+		static const char * const others[] = {
+			g_xpath_derivatives,
+			g_xpath_other_words,
+			g_xpath_phrases,
+			g_xpath_phrases_other,
+			g_xpath_phrasal_verbs,
+		};
+
+		_tmp.clear();
+		eval_xpath(doc, g_xpath_also_words, _tmp);
+		add_words(_tmp, also);
+		for (size_t i=0; i<sizeof(others)/sizeof(others[0]); ++i) {
+			_tmp.clear();
+			eval_xpath(doc, others[i], _tmp);
+			add_words(_tmp, other);
+		}
+
+		xmlFreeDoc(doc);
+		return 0;
+	}
+
+	void entry_text_for_links(const EntryRangeT &r, std::string &content) const {
+		const std::vector<uint32_t> &rows = _index.sorted();
+		const size_t num = r.second - r.first;
+		if (num > 1) {
+			content = "<div>";
+			for (size_t i=r.first; i<r.second; ++i) {
+				const StringRef t = _index.text(rows[i]);
+				content.append(t.data, t.size);
+			}
+			content += "</div>";
+		} else {
+			const StringRef t = _index.text(rows[r.first]);
+			content.assign(t.data, t.size);
+		}
+	}
+
+	// non-copyable
+	FindLinks(const FindLinks &);
+	FindLinks &operator=(const FindLinks &);
+};
+
+/// Links found in a range of the index. The range starts at the first
+/// entry of a headword, and ends at the first entry of another.
+struct LinksShard {
+	LinksShard(
+		const size_t f,
+		const size_t l
+	) : first(f), last(l), done(false) {}
+
+	/// Range of EntryTable::sorted()
+	size_t first, last;
+	/// In the order they were found
+	PairTable links;
+	PairTable backlinks;
+	bool done;
+};
+
+static void find_shard_links(
+	const EntryTable &index,
+	const bool verify,
+	LinkCounts &counts,
+	LinksShard &shard
+) {
+	PhaseTimer timer(Stats::PHASE_LINKS);
+	FindLinks find_links(index, shard.links, shard.backlinks, verify, counts);
+	const std::vector<uint32_t> &rows = index.sorted();
+
+	size_t last, it;
+	for (last = it = shard.first; it!=shard.last; ++it) {
+		if (!index.same_key(rows[last], rows[it])) {
+			find_links(EntryRangeT(last, it));
+			last = it;
+		}
+	}
+	find_links(EntryRangeT(last, it));
+}
+
+/// Find links for every word in the index. The index is split into
+/// shards which are processed by 'nthreads' threads, and the results of
+/// each shard are merged in index order, so the links are the same as if
+/// the words were processed one after another. Once 'cancel' is set the
+/// remaining shards are skipped. 'links' and 'backlinks' are sorted by
+/// key.
+static void find_all_links(
+	EntryTable &index,
+	const unsigned int nthreads,
+	const std::atomic<bool> &cancel,
+	const bool verify,
+	LinkCounts &counts,
+	PairTable &links,
+	PairTable &backlinks
+) {
+	const std::ios_base::fmtflags flags = cerr.flags();
+	const std::streamsize prec = cerr.precision();
+	const size_t index_size = index.size();
+
+	index.sort();
+	const std::vector<uint32_t> &rows = index.sorted();
+
+	// split into more shards than threads so that the work is balanced
+	std::deque<LinksShard> shards;
+	{
+		const size_t nshards = 16 * std::max(nthreads, 1U);
+		const size_t step = std::max(index_size / nshards, (size_t)1);
+
+		size_t it = 0;
+		while (it != index_size) {
+			const size_t first = it;
+			it = std::min(it + step, index_size);
+			// don't split the entries of a headword
+			while (it != index_size && index.same_key(rows[it], rows[it-1])) {
+				++it;
+			}
+			shards.emplace_back(first, it);
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::atomic<size_t> next_shard(0);
+
+	std::vector<std::thread> threads;
+	for (unsigned int t=0; t<std::max(nthreads, 1U); ++t) {
+		threads.push_back(std::thread([&]() {
+			// libxml2 settings are per thread
+			xmlKeepBlanksDefault(0);
+
+			size_t i;
+			while ((i = next_shard++) < shards.size()) {
+				if (!cancel) {
+					find_shard_links(index, verify, counts, shards[i]);
+				}
+
+				std::lock_guard<std::mutex> lock(mutex);
+				shards[i].done = true;
+				cond.notify_all();
+			}
+		}));
+	}
+
+	size_t num_entries = 0;
+	for (size_t i=0; i<shards.size(); ++i) {
+		LinksShard &shard = shards[i];
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [&shard]() { return shard.done; });
+		}
+
+		// in the order they would be found if the words were
+		// processed in order
+		links.append(shard.links);
+		backlinks.append(shard.backlinks);
+		num_entries += shard.last - shard.first;
+
+		shard.links.clear();
+		shard.backlinks.clear();
+
+		cerr << std::setprecision(2) << std::fixed <<
+			((float(num_entries)/index_size)*100) << "%\t" <<
+			std::setprecision(prec) <<
+			links.size() << " links\n";
+	}
+
+	for (size_t i=0; i<threads.size(); ++i) {
+		threads[i].join();
+	}
+
+	{
+		PhaseTimer timer(Stats::PHASE_LINKS);
+		// the first link of a word wins
+		links.sort(PairTable::TIES_FIRST);
+		backlinks.sort(PairTable::TIES_LAST_FIRST);
+	}
+
+	cerr.flags(flags);
+}
+
+/// Build the full-text index of the entries. The documents are the entries
+/// in index order, so they are the rows of the index cache. Contiguous
+/// shards of the entries are tokenized by 'nthreads' threads and joined in
+/// order.
+static void build_fulltext(
+	EntryTable &index,
+	const unsigned int nthreads,
+	const uint64_t body_size,
+	std::string &out
+) {
+	cerr << "Building full-text index...\n";
+
+	index.sort();
+	const std::vector<uint32_t> &rows = index.sorted();
+
+	const size_t nshards = 16 * std::max(nthreads, 1U);
+	const size_t step = std::max(index.size() / nshards, (size_t)1);
+
+	std::vector<EntryRangeT> shards;
+	for (size_t it=0; it!=rows.size(); ) {
+		const size_t first = it;
+		it = std::min(it + step, rows.size());
+		shards.push_back(EntryRangeT(first, it));
+	}
+
+	std::deque<FullTextBuilder> builders(shards.size());
+	std::atomic<size_t> next_shard(0);
+
+	std::vector<std::thread> threads;
+	for (unsigned int t=0; t<std::max(nthreads, 1U); ++t) {
+		threads.push_back(std::thread([&]() {
+			std::vector<std::string> words;
+			size_t i;
+			while ((i = next_shard++) < shards.size()) {
+				for (size_t k=shards[i].first; k<shards[i].second; ++k) {
+					words.clear();
+					tokenize_entry(index.text(rows[k]), words);
+					builders[i].add_document(words);
+				}
+			}
+		}));
+	}
+	for (size_t i=0; i<threads.size(); ++i) {
+		threads[i].join();
+	}
+
+	FullTextBuilder all;
+	for (size_t i=0; i<builders.size(); ++i) {
+		all.append(builders[i]);
+	}
+	all.write(body_size, out);
+
+	cerr << all.num_documents() << " documents in full-text index\n";
+}
+
+static inline std::string fulltext_file_name(const std::string &index_cache) {
+	return index_cache + ".fts";
+}
+
+static inline bool file_exists(const char * const fn) {
+	struct stat s;
+	return 0 == stat(fn, &s) && (S_ISREG(s.st_mode));
+}
+
+static inline void write_string(const std::string &s, std::ostream &out) {
+	unsigned int n = s.size();
+	out.write((const char*)&n, sizeof(n));
+	out.write(s.c_str(), n);
+}
+
+static inline std::istream &read_string(std::string &s, std::istream &in) {
+	unsigned int n;
+	if (in.read((char*)&n, sizeof(n))) {
+		s.resize(n);
+		in.read((char*)&s[0], n);
+	}
+	return in;
+}
+
+/// Write the version 2 index cache to 'out'. 'links' and 'backlinks'
+/// must be sorted. Returns non-zero on error.
+static int write_index(
+	EntryTable &index,
+	const PairTable &links,
+	const PairTable &backlinks,
+	const BlockDirectoryT &blocks,
+	std::string &out,
+	std::ostream &err
+) {
+	IndexBuilder builder;
+
+	index.sort();
+	const std::vector<uint32_t> &rows = index.sorted();
+	std::string key;
+	for (size_t i=0; i<rows.size(); ++i) {
+		index.key(rows[i], key);
+		builder.add_entry(key, index.name(rows[i]).str(), index.position(rows[i]));
+	}
+
+	for (size_t i=0; i<links.size(); ++i) {
+		builder.add_link(links.key(i).str(), links.value(i).str());
+	}
+
+	for (size_t i=0; i<backlinks.size(); ++i) {
+		builder.add_backlink(backlinks.key(i).str(), backlinks.value(i).str());
+	}
+
+	for (size_t i=0; i<blocks.size(); ++i) {
+		builder.add_block(blocks[i]);
+	}
+
+	return builder.write(out, err);
+}
+
+/// Write 'data' to 'fn' by renaming a temporary file, so that other
+/// processes never map a partly written file
+static int write_file(const std::string &fn, const std::string &data) {
+	std::ostringstream tmp;
+	tmp << fn << ".tmp." << getpid();
+	{
+		std::ofstream outfile(
+			tmp.str().c_str(),
+			std::ios::out|std::ios::trunc|std::ios::binary);
+		if (	!outfile.is_open() ||
+			!outfile.write(data.data(), data.size()) ||
+			!outfile.flush()
+		) {
+			unlink(tmp.str().c_str());
+			return 1;
+		}
+	}
+	if (rename(tmp.str().c_str(), fn.c_str())) {
+		unlink(tmp.str().c_str());
+		return 1;
+	}
+	return 0;
+}
+
+/// Read a version 1 index cache. The keys of the entries aren't kept, as
+/// they were always the downcased names.
+static int read_index(
+	EntryTable &index,
+	PairTable &links,
+	PairTable &backlinks,
+	std::istream &in
+) {
+
+	char magic[5];
+	if (!in.read(magic, 4)) {
+		return 1;
+	}
+	magic[4] = '\0';
+	if (strcmp(magic, "DICT")) {
+		cerr << "Expecting file magic to be DICT\n";
+		return 1;
+	}
+
+	unsigned char version = 0;
+	if (!in.read((char*)&version, sizeof(version))) {
+		cerr << "Failed to read index version\n";
+		return 1;
+	}
+
+
+	size_t n;
+	std::string name, key, val;
+
+	// index
+	if (!in.read((char*)&n, sizeof(n))) {
+		return 1;
+	}
+	for (size_t i=0; i<n; ++i) {
+		if (!read_string(key, in)) {
+			return 1;
+		}
+		if (!read_string(name, in)) {
+			return 1;
+		}
+		EntryPosition pos;
+		if (	!in.read((char*)&pos.file_range.first,		sizeof(size_t)) ||
+			!in.read((char*)&pos.file_range.second,		sizeof(size_t)) ||
+			!in.read((char*)&pos.uncompressed_range.first,  sizeof(size_t)) ||
+			!in.read((char*)&pos.uncompressed_range.second, sizeof(size_t))
+		) {
+			return 1;
+		}
+		index.add(name, pos);
+	}
+
+	// links
+	if (!in.read((char*)&n, sizeof(n))) {
+		return 1;
+	}
+	for (size_t i=0; i<n; ++i) {
+		if (	!read_string(key, in) |
+			!read_string(val, in)
+		) {
+			return 1;
+		}
+		links.add(key, val);
+	}
+
+	// backlinks
+	if (!in.read((char*)&n, sizeof(n))) {
+		return 1;
+	}
+	for (size_t i=0; i<n; ++i) {
+		if (	!read_string(key, in) |
+			!read_string(val, in)
+		) {
+			return 1;
+		}
+		backlinks.add(key, val);
+	}
+
+	links.sort(PairTable::TIES_FIRST);
+	backlinks.sort(PairTable::TIES_LAST_FIRST);
+	return 0;
+}
+
+static void entry_positions(
+	const MappedIndex &index,
+	const RowRangeT r,
+	std::vector<EntryPosition> &out
+) {
+	for (size_t i=r.first; i<r.second; ++i) {
+		out.push_back(index.entry_position(i));
+	}
+}
+
+/// Entries for the key 'w', or the entries it links to. If there are
+/// none and 'fold' is set, 'w' is replaced by the first key with the same
+/// folded key, so "CAFÉ" finds "café" and "dog-and-bone" finds "dog and
+/// bone".
+static inline RowRangeT lookup(
+	std::string &w,
+	const MappedIndex &index,
+	const bool fold = true
+) {
+	const RowRangeT r = index.entries(w);
+	if (r.first != r.second) {
+		return r;
+	}
+	StringRef target;
+	if (index.link(w, target)) {
+		return index.entries(target.str());
+	}
+
+	if (fold && index.num_folds()) {
+		std::string folded;
+		fold_key(w, folded);
+		const RowRangeT fr = index.folds(folded);
+		if (!folded.empty() && fr.first != fr.second) {
+			const size_t row = index.fold_row(fr.first);
+			if (!index.fold_is_link(fr.first) && row < index.num_entries()) {
+				w = index.entry_key(row).str();
+				return index.entries(w);
+			}
+			if (index.fold_is_link(fr.first) && row < index.num_links()) {
+				w = index.link_key(row).str();
+				return index.entries(index.link_target(row).str());
+			}
+		}
+	}
+	return RowRangeT(0, 0);
+}
+
+/// Total size of the rendered definitions kept, which are looked up again
+/// e.g. when going back to a word or switching the theme twice
+static const size_t g_page_cache_size = 32 << 20;
+
+/// DefaultStyle.css in the same directory as 'fn', or empty if 'fn' has
+/// no directory
+static std::string default_css_path(const std::string &fn) {
+	char * const dirc = strdup(fn.c_str());
+	const char * const dir = dirname(dirc);
+	const std::string css = dir ? std::string(dir) + "/DefaultStyle.css" : std::string();
+	free(dirc);
+	return css;
+}
+
+struct DictionaryRef {
+	DictionaryRef(
+		const MappedFile &infile,
+		const std::string &fn,
+		const SharedIndex &index,
+		BlockCache &blocks,
+		PageCache &pages,
+		const FullTextIndex &fulltext
+	) : _infile(infile),
+	    _fn(fn),
+	    _index(index),
+	    _blocks(blocks),
+	    _pages(pages),
+	    _fulltext(fulltext),
+	    _css_fn(default_css_path(fn)),
+	    _css_read(false)
+		{}
+
+	const MappedFile &_infile;
+	const std::string &_fn;
+	/// May be a partial index while the index is built
+	const SharedIndex &_index;
+	/// Inflated blocks of Body.data
+	BlockCache &_blocks;
+	/// Rendered definitions
+	PageCache &_pages;
+	/// Not open if there isn't one
+	const FullTextIndex &_fulltext;
+	/// DefaultStyle.css in the same directory as Body.data
+	const std::string _css_fn;
+
+	/// The contents of DefaultStyle.css, which is read the first time
+	/// they're needed. Returns NULL if it couldn't be read.
+	const std::string *css() const {
+		std::call_once(_css_once, [this]() {
+			std::ifstream in(_css_fn.c_str(), std::ios::binary);
+			std::ostringstream css;
+			if (in.is_open() && (css << in.rdbuf())) {
+				_css = css.str();
+				_css_read = true;
+			}
+		});
+		return _css_read ? &_css : NULL;
+	}
+
+private:
+	mutable std::once_flag _css_once;
+	mutable std::string _css;
+	mutable bool _css_read;
+};
+
+void output_color_css(const char *text, const char *background, std::ostream &out) {
+	out <<
+		"  color: " << text << ";\n"
+		"  background-color: " << background << ";\n";
+}
+
+void output_body_css(const bool dark, std::ostream &out) {
+	out <<
+		"body {\n"
+		"  font-family: Sans-Serif;\n";
+	output_color_css(dark ? "white"   : "black",
+			 dark ? "#1d1d1d" : "white", out);
+	out << "}\n";
+}
+
+/// Write the html up to and including <body>. The stylesheet is either
+/// embedded or linked, at 'css_href' if that is set.
+static int output_definition_head(
+	const DictionaryRef &d,
+	const bool embed_default_css,
+	const char * const css_href,
+	const bool dark,
+	std::ostream &out,
+	std::ostream &err
+) {
+	out <<
+		"<html lang=\"en\">\n"
+		"<head>\n"
+		"<meta charset=\"utf-8\">\n"
+		"<title>Dictionary</title>\n";
+
+	if (d._css_fn.empty()) {
+		err << "Failed to get dirname from path " << d._fn << "\n";
+		return 1;
+	}
+
+	if (embed_default_css) {
+		const std::string * const css = d.css();
+		if (!css) {
+			err << "Failed to open \"" << d._css_fn << "\"\n";
+			return 1;
+		}
+		out << "<style>\n";
+		out << *css;
+		out << "</style>\n";
+	} else {
+		out << "<link rel=\"stylesheet\" href=\"" <<
+			(css_href ? css_href : d._css_fn.c_str()) << "\">\n";
+	}
+
+	out << "<style>\n";
+
+	output_body_css(dark, out);
+
+	out <<
+		".x_xoLblBlk {\n"
+		"    border-bottom: 1px solid #cccccc;\n"
+		"    padding-bottom: 50px;\n"
+		"    color: #888888;\n"
+		"}\n"
+		".note {\n"
+		"    border: 1px solid #cccccc;\n"
+		"}\n"
+		".reg,.tg_gg,.tg_hw,.sy,.gg,.ex,.sn,.ph,.prx,.tg_vg,.vg {\n"
+		"    color: #777777;\n"
+		"}\n"
+		".v,.bold {\n"
+		"    color: " << (dark ? "white" : "black") << ";\n"
+		"}\n"
+		"</style>\n"
+		"</head>\n";
+
+	out << "<body>\n";
+	return 0;
+}
+
+/// Positions of the entries which make up the definition of 'target',
+/// followed by those of the pages which link to it. 'multi' is set if
+/// there is more than one. Returns false if there are none.
+static bool definition_positions(
+	const MappedIndex &index,
+	const std::string &target,
+	std::vector<EntryPosition> &pos,
+	bool &multi
+) {
+	PhaseTimer timer(Stats::PHASE_LOOKUP);
+	// the key found, if 'target' is folded
+	std::string key = target;
+	const RowRangeT r = lookup(key, index);
+	if (r.first == r.second) {
+		return false;
+	}
+
+	multi = r.second - r.first > 1;
+	entry_positions(index, r, pos);
+
+	const RowRangeT br = index.backlinks(key);
+	if (br.first != br.second) {
+		multi = true;
+		for (size_t i=br.first; i<br.second; ++i) {
+			// append the other page
+			entry_positions(index,
+					index.entries(index.backlink_target(i).str()),
+					pos);
+		}
+	}
+	return true;
+}
+
+/// Join the text of the entries of one definition
+static void join_entries(
+	const std::vector<const std::string*> &entry_texts,
+	const bool multi,
+	std::string &content
+) {
+	content.clear();
+	if (multi) {
+		content += "<div>";
+	}
+	for (size_t i=0; i<entry_texts.size(); ++i) {
+		content += *entry_texts[i];
+	}
+	if (multi) {
+		content += "</div>";
+	}
+}
+
+/// Parse the joined entries and write them in a div. Returns non-zero if
+/// they aren't valid XML.
+static int output_entries(const std::string &content, std::ostream &out) {
+	PhaseTimer timer(Stats::PHASE_RENDER);
+	process_stats().add(Stats::XML_PARSES);
+	xmlDocPtr doc = xmlParseDoc((xmlChar*)content.c_str());
+	if (!doc) {
+		return 1;
+	}
+
+	out << "<div class=\"div-entry\">\n";
+
+	xmlChar *s;
+	int size;
+	xmlDocDumpMemoryEnc(doc, &s, &size, "UTF-8");
+	if (s) {
+		out.write((char*)s, size);
+		out << "\n";
+		xmlFree(s);
+	}
+
+	out << "</div>\n";
+
+	xmlFreeDoc(doc);
+	return 0;
+}
+
+static int render_definition(
+	const DictionaryRef &d,
+	const std::string &target,
+	const bool embed_default_css,
+	const bool dark,
+	std::ostream &out,
+	std::ostream &err
+) {
+	if (output_definition_head(d, embed_default_css, NULL, dark, out, err)) {
+		return 1;
+	}
+
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	std::string key = target;
+	downcase(key);
+
+	std::vector<EntryPosition> pos;
+	bool multi = false;
+	if (!definition_positions(*index, key, pos, multi)) {
+		err << "No entries found";
+		std::string similar;
+		suggest_words(d, target,
+			[](const std::string &word, void *data) {
+				std::string &similar = *(std::string*)data;
+				similar += similar.empty() ? "" : ", ";
+				similar += word;
+			}, &similar);
+		if (!similar.empty()) {
+			err << ", did you mean " << similar << "?";
+		}
+		err << "\n";
+		return 2;
+	}
+
+	std::string content;
+	{
+		std::vector<std::string> entry_texts;
+		read_entries(d._infile, *index, d._blocks, pos, entry_texts);
+
+		std::vector<const std::string*> texts(entry_texts.size());
+		for (size_t i=0; i<entry_texts.size(); ++i) {
+			texts[i] = &entry_texts[i];
+		}
+		join_entries(texts, multi, content);
+	}
+
+	const int ret = output_entries(content, out);
+	out << "</body>\n";
+
+	if (ret) {
+		err << "Failed to parse entry for \"" << target << "\"\n";
+	}
+	return ret;
+}
+
+void init_lookup_thread() {
+	// libxml2 settings are per thread
+	xmlKeepBlanksDefault(0);
+}
+
+int output_definition(
+	const DictionaryRef &d,
+	const std::string &target,
+	const bool embed_default_css,
+	const bool dark,
+	std::ostream &out,
+	std::ostream &err
+) {
+	// before the index is used, so a page is never cached as newer than
+	// the index it came from
+	const unsigned int generation = d._index.generation();
+	const PageCache::Key key(target, dark, embed_default_css);
+
+	PageCache::PageT page = d._pages.get(key, generation);
+	if (page) {
+		out.write(page->data(), page->size());
+		return 0;
+	}
+
+	std::ostringstream html;
+	const int ret = render_definition(d, target, embed_default_css, dark, html, err);
+	page = std::make_shared<std::string>(html.str());
+	out.write(page->data(), page->size());
+	if (!ret) {
+		d._pages.put(key, generation, page);
+	}
+	return ret;
+}
+
+/// Output formats of the batch mode
+enum BatchFormat {
+	/// The page of each word as with -o, one after another
+	BATCH_HTML,
+	/// One JSON object per line with the word and its definition
+	BATCH_JSONL
+};
+
+/// Append 's' as a JSON string
+static void append_json_string(const std::string &s, std::string &out) {
+	out += '"';
+	for (size_t i=0; i<s.size(); ++i) {
+		const unsigned char c = s[i];
+		switch (c) {
+		case '"':  out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if (c < 0x20) {
+				char buf[8];
+				snprintf(buf, sizeof(buf), "\\u%04x", c);
+				out += buf;
+			} else {
+				out += c;
+			}
+		}
+	}
+	out += '"';
+}
 
-	char magic[5];
-	if (!in.read(magic, 4)) {
-		return 1;
+/// Write the definition of each of 'words' to 'out'. The entries of all
+/// the words are found first and read in file order, so each block of
+/// Body.data is inflated at most once for the whole batch, and entries
+/// shared by several words are read once. Only the text of the entries
+/// is kept until the definitions are written, in the order of 'words'.
+/// Returns the number of words which weren't found.
+static size_t output_batch(
+	const DictionaryRef &d,
+	const std::vector<std::string> &words,
+	const BatchFormat format,
+	const bool dark,
+	std::ostream &out,
+	std::ostream &err
+) {
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	struct Word {
+		Word() : found(false), multi(false) {}
+
+		bool found;
+		bool multi;
+		/// Into the sorted positions of the whole batch
+		std::vector<size_t> entries;
+	};
+	std::vector<Word> resolved(words.size());
+
+	// resolve every word before reading anything
+	std::vector<EntryPosition> pos;
+	std::vector<std::pair<size_t, size_t> > word_pos(words.size());
+	for (size_t i=0; i<words.size(); ++i) {
+		std::string key = words[i];
+		downcase(key);
+		word_pos[i].first = pos.size();
+		resolved[i].found = definition_positions(*index, key, pos, resolved[i].multi);
+		word_pos[i].second = pos.size();
 	}
-	magic[4] = '\0';
-	if (strcmp(magic, "DICT")) {
-		cerr << "Expecting file magic to be DICT\n";
-		return 1;
+
+	const auto less = [](const EntryPosition &a, const EntryPosition &b) {
+		return a.file_range < b.file_range ||
+			(a.file_range == b.file_range &&
+			 a.uncompressed_range < b.uncompressed_range);
+	};
+	std::vector<EntryPosition> unique_pos(pos);
+	std::sort(unique_pos.begin(), unique_pos.end(), less);
+	unique_pos.erase(
+		std::unique(unique_pos.begin(), unique_pos.end(),
+			    [](const EntryPosition &a, const EntryPosition &b) {
+				    return a.file_range == b.file_range &&
+					    a.uncompressed_range == b.uncompressed_range;
+			    }),
+		unique_pos.end());
+
+	for (size_t i=0; i<words.size(); ++i) {
+		for (size_t k=word_pos[i].first; k<word_pos[i].second; ++k) {
+			resolved[i].entries.push_back(
+				std::lower_bound(unique_pos.begin(), unique_pos.end(),
+						 pos[k], less) - unique_pos.begin());
+		}
 	}
+	std::vector<EntryPosition>().swap(pos);
+
+	std::vector<std::string> entry_texts;
+	read_entries(d._infile, *index, d._blocks, unique_pos, entry_texts);
+
+	size_t not_found = 0;
+	std::string content, record;
+	std::vector<const std::string*> texts;
+	for (size_t i=0; i<words.size(); ++i) {
+		const Word &w = resolved[i];
+
+		std::ostringstream html;
+		int ret = 2;
+		if (w.found) {
+			texts.resize(w.entries.size());
+			for (size_t k=0; k<w.entries.size(); ++k) {
+				texts[k] = &entry_texts[w.entries[k]];
+			}
+			join_entries(texts, w.multi, content);
+			ret = output_entries(content, html);
+		}
 
-	unsigned char version = 0;
-	if (!in.read((char*)&version, sizeof(version))) {
-		cerr << "Failed to read index version\n";
-		return 1;
+		if (ret == 2) {
+			++not_found;
+			err << "No entries found for \"" << words[i] << "\"\n";
+		} else if (ret) {
+			err << "Failed to parse entry for \"" << words[i] << "\"\n";
+		}
+
+		if (format == BATCH_JSONL) {
+			record = "{\"word\":";
+			append_json_string(words[i], record);
+			if (ret == 0) {
+				record += ",\"html\":";
+				append_json_string(html.str(), record);
+			} else {
+				record += ",\"error\":";
+				append_json_string(ret == 2 ? "No entries found" :
+						   "Failed to parse entry", record);
+			}
+			record += "}\n";
+			out << record;
+		} else if (ret == 0) {
+			if (output_definition_head(d, false, NULL, dark, out, err)) {
+				break;
+			}
+			out << html.str();
+			out << "</body>\n";
+		}
+	}
+
+	return not_found;
+}
+
+/// Read one word per line, skipping empty lines
+static int read_words(const std::string &fn, std::vector<std::string> &words) {
+	std::ifstream infile;
+	if (fn != "-") {
+		infile.open(fn.c_str());
+		if (!infile.is_open()) {
+			return 1;
+		}
 	}
+	std::istream &in = fn == "-" ? std::cin : infile;
 
+	std::string line;
+	while (std::getline(in, line)) {
+		strip(line);
+		if (!line.empty()) {
+			words.push_back(line);
+		}
+	}
+	return in.bad() ? 1 : 0;
+}
 
-	size_t n;
-	std::string name, key, val;
+/// Make 'key' safe to use as a file name
+static std::string file_name_of(const std::string &key) {
+	std::string r;
+	for (size_t i=0; i<key.size(); ++i) {
+		const unsigned char c = key[i];
+		if (	(c >= 'a' && c <= 'z') ||
+			(c >= '0' && c <= '9') ||
+			c == '-' || c == '_' || c >= 0x80 ||
+			(c == '.' && i > 0)
+		) {
+			r += c;
+		} else {
+			r += '_';
+		}
+	}
+	return r;
+}
 
-	// index
-	if (!in.read((char*)&n, sizeof(n))) {
+static int make_dir(const std::string &dir) {
+	if (mkdir(dir.c_str(), 0755) && errno != EEXIST) {
 		return 1;
 	}
-	for (size_t i=0; i<n; ++i) {
-		if (!read_string(key, in)) {
-			return 1;
+	return 0;
+}
+
+/// Writes the definition of every headword in the index, as a directory
+/// of html files or a JSONL stream.
+///
+/// The headwords are sorted by the position of their first entry and cut
+/// into chunks, so each chunk reads few blocks. Runs of chunks are dealt
+/// out to a queue per thread in turn. A thread takes the front of its own
+/// queue, and once that's empty steals the front of another, so all the
+/// threads work on nearby parts of the file and none sits idle while
+/// there is work left. The calling thread writes the results in chunk
+/// order, so the output is the same for any number of threads, and
+/// workers only run up to 'window' chunks ahead of it, which bounds the
+/// memory used.
+class Exporter {
+public:
+	Exporter(
+		const DictionaryRef &d,
+		const MappedIndex &index,
+		const BatchFormat format,
+		const std::string &dest,
+		const bool dark,
+		const unsigned int nthreads
+	) : _d(d),
+	    _index(index),
+	    _format(format),
+	    _dest(dest),
+	    _dark(dark),
+	    _nthreads(std::max(nthreads, 1U)),
+	    _queues(_nthreads),
+	    _results(window()),
+	    _written(0),
+	    _failed(false) {}
+
+	/// JSONL is written to 'out', html files to the directory 'dest' with
+	/// an index.tsv of the words and files. Returns non-zero on error.
+	int run(std::ostream &out, std::ostream &err) {
+		find_headwords();
+
+		if (_format == BATCH_HTML) {
+			if (make_dir(_dest)) {
+				err << "Failed to create \"" << _dest << "\"\n";
+				return 1;
+			}
+			// the pages are still readable without it
+			copy_css(err);
+			_tsv.open((_dest + "/index.tsv").c_str(), std::ios::out|std::ios::trunc|std::ios::binary);
+			if (!_tsv.is_open()) {
+				err << "Failed to create \"" << _dest << "/index.tsv\"\n";
+				return 1;
+			}
 		}
-		if (!read_string(name, in)) {
+
+		// deal out runs of chunks so the threads start near each other
+		const size_t nchunks = num_chunks();
+		for (size_t c=0; c<nchunks; ++c) {
+			_queues[(c / g_export_run) % _nthreads].push_back(c);
+		}
+
+		std::vector<std::thread> threads;
+		for (unsigned int i=0; i<_nthreads; ++i) {
+			threads.push_back(std::thread(&Exporter::work, this, i));
+		}
+
+		write(nchunks, out);
+
+		for (size_t i=0; i<threads.size(); ++i) {
+			threads[i].join();
+		}
+
+		if (_failed) {
+			err << _error;
 			return 1;
 		}
-		EntryPosition pos;
-		if (	!in.read((char*)&pos.file_range.first,		sizeof(size_t)) ||
-			!in.read((char*)&pos.file_range.second,		sizeof(size_t)) ||
-			!in.read((char*)&pos.uncompressed_range.first,  sizeof(size_t)) ||
-			!in.read((char*)&pos.uncompressed_range.second, sizeof(size_t))
-		) {
+		if (_format == BATCH_HTML && !_tsv.flush()) {
+			err << "Failed to write \"" << _dest << "/index.tsv\"\n";
 			return 1;
 		}
-		index.insert(IndexT::value_type(key, Entry(name, pos)));
+		cerr << _headwords.size() << " headwords exported\n";
+		return 0;
 	}
 
-	// links
-	if (!in.read((char*)&n, sizeof(n))) {
-		return 1;
+private:
+	/// Headwords in a chunk
+	static const size_t g_export_chunk = 256;
+	/// Chunks dealt out to a thread at a time
+	static const size_t g_export_run = 4;
+
+	struct Result {
+		Result() : done(false) {}
+
+		std::string out;
+		/// Entries which failed to parse, reported by the writer
+		std::string errors;
+		bool done;
+	};
+
+	const DictionaryRef &_d;
+	const MappedIndex &_index;
+	const BatchFormat _format;
+	const std::string _dest;
+	const bool _dark;
+	const unsigned int _nthreads;
+
+	/// First row of each headword, in the order of their entries in the file
+	std::vector<size_t> _headwords;
+
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	/// Chunks not yet started, per thread
+	std::vector<std::deque<size_t> > _queues;
+	/// Chunk 'c' goes in _results[c % window()]
+	std::vector<Result> _results;
+	/// Chunks written so far
+	size_t _written;
+	bool _failed;
+	std::string _error;
+	std::ofstream _tsv;
+
+	size_t window() const {
+		return 4 * _nthreads;
 	}
-	for (size_t i=0; i<n; ++i) {
-		if (	!read_string(key, in) |
-			!read_string(val, in)
-		) {
-			return 1;
+
+	size_t num_chunks() const {
+		return (_headwords.size() + g_export_chunk - 1) / g_export_chunk;
+	}
+
+	void find_headwords() {
+		const size_t n = _index.num_entries();
+		for (size_t i=0; i<n; ++i) {
+			const StringRef key = _index.entry_key(i);
+			if (i > 0) {
+				const StringRef prev = _index.entry_key(i-1);
+				if (prev.size == key.size && !memcmp(prev.data, key.data, key.size)) {
+					continue;
+				}
+			}
+			_headwords.push_back(i);
 		}
-		links.insert(LinksT::value_type(key, val));
+
+		const MappedIndex &index = _index;
+		std::sort(_headwords.begin(), _headwords.end(), [&index](size_t a, size_t b) {
+				const EntryPosition pa = index.entry_position(a);
+				const EntryPosition pb = index.entry_position(b);
+				if (pa.file_range != pb.file_range) {
+					return pa.file_range < pb.file_range;
+				}
+				if (pa.uncompressed_range != pb.uncompressed_range) {
+					return pa.uncompressed_range < pb.uncompressed_range;
+				}
+				return a < b;
+			});
 	}
 
-	// backlinks
-	if (!in.read((char*)&n, sizeof(n))) {
-		return 1;
+	void copy_css(std::ostream &err) {
+		const std::string * const css = _d.css();
+		if (!css) {
+			err << "Failed to read \"" << _d._css_fn << "\"\n";
+			return;
+		}
+		std::ofstream out((_dest + "/DefaultStyle.css").c_str(),
+				  std::ios::out|std::ios::trunc|std::ios::binary);
+		if (!out.is_open() || !out.write(css->data(), css->size())) {
+			err << "Failed to copy \"" << _d._css_fn << "\"\n";
+		}
 	}
-	for (size_t i=0; i<n; ++i) {
-		if (	!read_string(key, in) |
-			!read_string(val, in)
-		) {
-			return 1;
+
+	/// Take the next chunk for thread 'self', waiting while they are all
+	/// too far ahead of the writer. Returns false when there are none
+	/// left. Called with the lock held.
+	bool next_chunk(const unsigned int self, std::unique_lock<std::mutex> &lock, size_t &chunk) {
+		while (!_failed) {
+			const size_t limit = _written + window();
+			bool left = false;
+
+			// own queue first, then steal the lowest chunk
+			std::deque<size_t> *from = NULL;
+			if (!_queues[self].empty()) {
+				left = true;
+				if (_queues[self].front() < limit) {
+					from = &_queues[self];
+				}
+			}
+			for (unsigned int i=0; !from && i<_nthreads; ++i) {
+				std::deque<size_t> &q = _queues[i];
+				if (q.empty()) {
+					continue;
+				}
+				left = true;
+				if (q.front() < limit && (!from || q.front() < from->front())) {
+					from = &q;
+				}
+			}
+
+			if (from) {
+				chunk = from->front();
+				from->pop_front();
+				return true;
+			}
+			if (!left) {
+				return false;
+			}
+			_cond.wait(lock);
 		}
-		backlinks.insert(BackLinksT::value_type(key, val));
+		return false;
 	}
 
-	return 0;
-}
+	/// Append an error of libxml2 to the std::string 'ctx'
+	static void collect_xml_error(void *ctx, const char *msg, ...) {
+		char buf[1024];
+		va_list args;
+		va_start(args, msg);
+		const int n = vsnprintf(buf, sizeof(buf), msg, args);
+		va_end(args);
+		if (n > 0) {
+			((std::string*)ctx)->append(buf, std::min(size_t(n), sizeof(buf) - 1));
+		}
+	}
 
-static void concat_entries(
-	std::ifstream &infile,
-	const EntryRangeT r,
-	std::string &out
-) {
-	std::string entry_text;
-	for (	IndexT::const_iterator
-		it=r.first; it!=r.second; ++it
+	void work(const unsigned int self) {
+		// libxml2 settings are per thread
+		xmlKeepBlanksDefault(0);
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		size_t chunk;
+		while (next_chunk(self, lock, chunk)) {
+			lock.unlock();
+
+			// so errors of the parser are reported in chunk order too
+			std::string out, errors, error;
+			xmlSetGenericErrorFunc(&errors, collect_xml_error);
+			const int ret = export_chunk(chunk, out, errors, error);
+
+			lock.lock();
+			if (ret) {
+				_failed = true;
+				_error = error;
+			}
+			Result &r = _results[chunk % window()];
+			r.out.swap(out);
+			r.errors.swap(errors);
+			r.done = true;
+			_cond.notify_all();
+		}
+		xmlSetGenericErrorFunc(NULL, NULL);
+	}
+
+	/// Render the headwords of 'chunk'. JSONL records, or the lines of
+	/// index.tsv for html files, are appended to 'out', and the entries
+	/// which failed to parse to 'errors'. Returns non-zero, with the
+	/// reason in 'error', if the export can't go on.
+	int export_chunk(
+		const size_t chunk,
+		std::string &out,
+		std::string &errors,
+		std::string &error
 	) {
-		if (read_one_entry(infile, it->second._pos, entry_text)) {
-			continue;
+		const size_t first = chunk * g_export_chunk;
+		const size_t last = std::min(first + g_export_chunk, _headwords.size());
+
+		std::ostringstream dir;
+		if (_format == BATCH_HTML) {
+			dir << std::setw(5) << std::setfill('0') << chunk;
+			if (make_dir(_dest + "/" + dir.str())) {
+				error = "Failed to create \"" + _dest + "/" + dir.str() + "\"\n";
+				return 1;
+			}
+		}
+
+		// the entries of all the headwords in the chunk, read together
+		std::vector<EntryPosition> pos;
+		std::vector<std::pair<size_t, size_t> > ranges;
+		std::vector<bool> multi;
+		for (size_t h=first; h<last; ++h) {
+			const std::string key = _index.entry_key(_headwords[h]).str();
+			const size_t begin = pos.size();
+			bool m = false;
+			definition_positions(_index, key, pos, m);
+			ranges.push_back(std::make_pair(begin, pos.size()));
+			multi.push_back(m);
+		}
+		std::vector<std::string> entry_texts;
+		read_entries(_d._infile, _index, _d._blocks, pos, entry_texts);
+
+		std::string content;
+		std::vector<const std::string*> texts;
+		for (size_t h=first; h<last; ++h) {
+			const size_t row = _headwords[h];
+			const std::pair<size_t, size_t> &range = ranges[h-first];
+			const std::string word = _index.entry_name(row).str();
+
+			texts.clear();
+			for (size_t k=range.first; k<range.second; ++k) {
+				texts.push_back(&entry_texts[k]);
+			}
+			join_entries(texts, multi[h-first], content);
+
+			std::ostringstream html;
+			const int ret = output_entries(content, html);
+
+			if (_format == BATCH_JSONL) {
+				out += "{\"word\":";
+				append_json_string(word, out);
+				if (ret == 0) {
+					out += ",\"html\":";
+					append_json_string(html.str(), out);
+				} else {
+					out += ",\"error\":";
+					append_json_string("Failed to parse entry", out);
+				}
+				out += "}\n";
+				continue;
+			}
+
+			if (ret) {
+				errors += "Failed to parse entry for \"" + word + "\"\n";
+				continue;
+			}
+
+			// the row keeps names unique if some characters were replaced
+			const std::string key = _index.entry_key(row).str();
+			std::string name = file_name_of(key);
+			if (name != key || name.empty()) {
+				std::ostringstream n;
+				n << name << "~" << row;
+				name = n.str();
+			}
+			const std::string path = dir.str() + "/" + name + ".html";
+
+			std::ofstream file((_dest + "/" + path).c_str(),
+					   std::ios::out|std::ios::trunc|std::ios::binary);
+			if (!file.is_open()) {
+				error = "Failed to create \"" + _dest + "/" + path + "\"\n";
+				return 1;
+			}
+			std::ostringstream err;
+			if (output_definition_head(_d, false, "../DefaultStyle.css", _dark, file, err)) {
+				error = err.str();
+				return 1;
+			}
+			file << html.str();
+			file << "</body>\n";
+			if (!file.flush()) {
+				error = "Failed to write \"" + _dest + "/" + path + "\"\n";
+				return 1;
+			}
+
+			out += word;
+			out += '\t';
+			out += path;
+			out += '\n';
+		}
+		return 0;
+	}
+
+	/// Write the results in chunk order
+	void write(const size_t nchunks, std::ostream &out) {
+		const std::ios_base::fmtflags flags = cerr.flags();
+		const std::streamsize prec = cerr.precision();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (_written < nchunks) {
+			Result &r = _results[_written % window()];
+			_cond.wait(lock, [this, &r]() { return _failed || r.done; });
+			if (_failed) {
+				break;
+			}
+
+			std::string s, errors;
+			s.swap(r.out);
+			errors.swap(r.errors);
+			r.done = false;
+			lock.unlock();
+
+			cerr << errors;
+
+			std::ostream &o = _format == BATCH_JSONL ? out : _tsv;
+			if (!o.write(s.data(), s.size())) {
+				lock.lock();
+				_failed = true;
+				_error = "Failed to write the export\n";
+				_cond.notify_all();
+				break;
+			}
+
+			if (_written % 50 == 0) {
+				cerr << std::setprecision(2) << std::fixed <<
+					((float(_written)/nchunks)*100) << "%\t" <<
+					std::setprecision(prec) <<
+					std::min(_written * g_export_chunk, _headwords.size()) <<
+					" headwords\n";
+			}
+
+			lock.lock();
+			++_written;
+			_cond.notify_all();
+		}
+
+		cerr.flags(flags);
+	}
+
+	// non-copyable
+	Exporter(const Exporter &);
+	Exporter &operator=(const Exporter &);
+};
+
+/// Rows of the words for which a key is a prefix: entries, then links, or
+/// if there are none, the folded keys for which its folded key is a prefix
+struct WordRanges {
+	RowRangeT entries;
+	RowRangeT links;
+	RowRangeT folds;
+
+	size_t size() const {
+		return (entries.second - entries.first) +
+			(links.second - links.first) +
+			(folds.second - folds.first);
+	}
+};
+
+static void word_ranges(const MappedIndex &index, const std::string &key, WordRanges &r) {
+	index.words_with_prefix(key, r.entries, r.links);
+	r.folds = RowRangeT(0, 0);
+	if (r.size() == 0 && index.num_folds()) {
+		std::string folded;
+		fold_key(key, folded);
+		if (!folded.empty()) {
+			r.folds = index.folds_with_prefix(folded);
 		}
-		out += entry_text;
 	}
 }
 
-static inline EntryRangeT lookup(
-	const std::string &w,
-	const IndexT &index,
-	const LinksT &links
+void list_words(
+	const DictionaryRef &d,
+	const std::string &target,
+	void (*func)(const std::string &, void *data),
+	void *data
 ) {
-	const EntryRangeT r = index.equal_range(w);
-	if (r.first != r.second) {
-		return r;
+	list_words(d, target, 0, size_t(-1), func, data);
+}
+
+void list_words(
+	const DictionaryRef &d,
+	const std::string &target,
+	const size_t first,
+	const size_t count,
+	void (*func)(const std::string &, void *data),
+	void *data
+) {
+	PhaseTimer timer(Stats::PHASE_LOOKUP);
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	std::string key = target;
+	downcase(key);
+
+	WordRanges r;
+	word_ranges(*index, key, r);
+
+	const size_t nentries = r.entries.second - r.entries.first;
+	const size_t nlinks = r.links.second - r.links.first;
+	const size_t total = r.size();
+	const size_t begin = std::min(first, total);
+	const size_t end = begin + std::min(count, total - begin);
+
+	for (size_t i=begin; i<std::min(end, nentries); ++i) {
+		func(index->entry_name(r.entries.first + i).str(), data);
 	}
-	const LinksT::const_iterator it = links.find(w);
-	if (it != links.end()) {
-		return index.equal_range(it->second);
+	for (size_t i=std::max(begin, nentries); i<std::min(end, nentries + nlinks); ++i) {
+		func(index->link_key(r.links.first + i - nentries).str(), data);
+	}
+	for (size_t i=std::max(begin, nentries + nlinks); i<end; ++i) {
+		const size_t f = r.folds.first + i - nentries - nlinks;
+		const size_t row = index->fold_row(f);
+		if (index->fold_is_link(f)) {
+			if (row < index->num_links()) {
+				func(index->link_key(row).str(), data);
+			}
+		} else if (row < index->num_entries()) {
+			func(index->entry_name(row).str(), data);
+		}
 	}
-	return EntryRangeT(index.end(), index.end());
 }
 
-struct DictionaryRef {
-	DictionaryRef(
-		std::ifstream &infile,
-		const std::string &fn,
-		const IndexT &index,
-		const LinksT &links,
-		const BackLinksT &backlinks
-	) : _infile(infile),
-	    _fn(fn),
-	    _index(index),
-	    _links(links),
-	    _backlinks(backlinks)
-		{}
+size_t count_words(const DictionaryRef &d, const std::string &target) {
+	PhaseTimer timer(Stats::PHASE_LOOKUP);
+	const SharedIndex::IndexPtrT index = d._index.get();
 
-	std::ifstream &_infile;
-	const std::string &_fn;
-	const IndexT &_index;
-	const LinksT &_links;
-	const BackLinksT &_backlinks;
-};
+	std::string key = target;
+	downcase(key);
 
-void output_color_css(const char *text, const char *background, std::ostream &out) {
-	out <<
-		"  color: " << text << ";\n"
-		"  background-color: " << background << ";\n";
+	WordRanges r;
+	word_ranges(*index, key, r);
+	return r.size();
 }
 
-void output_body_css(const bool dark, std::ostream &out) {
-	out <<
-		"body {\n"
-		"  font-family: Sans-Serif;\n";
-	output_color_css(dark ? "white"   : "black",
-			 dark ? "#1d1d1d" : "white", out);
-	out << "}\n";
+/// Keys of at most this many bytes only get suggestions one edit away
+static const size_t g_suggest_short = 4;
+static const size_t g_max_suggestions = 10;
+static const size_t g_max_search_results = 200;
+
+void suggest_words(
+	const DictionaryRef &d,
+	const std::string &target,
+	void (*func)(const std::string &, void *data),
+	void *data
+) {
+	PhaseTimer timer(Stats::PHASE_LOOKUP);
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	std::string key = target;
+	downcase(key);
+
+	// a second typo in a short word leaves too little of it
+	const unsigned int max_distance = key.size() > g_suggest_short ? 2 : 1;
+
+	std::vector<Suggestion> found;
+	index->suggestions(key, max_distance, g_max_suggestions, found);
+	for (size_t i=0; i<found.size(); ++i) {
+		const Suggestion &s = found[i];
+		func((s.is_link ? index->link_key(s.row) : index->entry_name(s.row)).str(), data);
+	}
+}
+
+int search_words(
+	const DictionaryRef &d,
+	const std::string &query,
+	void (*func)(const std::string &, void *data),
+	void *data,
+	std::ostream &err
+) {
+	if (!d._fulltext.is_open()) {
+		err << "No full-text index, build it with -T\n";
+		return 1;
+	}
+
+	std::vector<FullTextHit> hits;
+	if (d._fulltext.search(query, size_t(-1), hits, err)) {
+		return 1;
+	}
+
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	// entries with the same name show the same definition
+	std::set<std::string> seen;
+	for (size_t i=0; i<hits.size() && seen.size()<g_max_search_results; ++i) {
+		if (hits[i].row >= index->num_entries()) {
+			continue;
+		}
+		const std::string name = index->entry_name(hits[i].row).str();
+		if (seen.insert(name).second) {
+			func(name, data);
+		}
+	}
+	return 0;
 }
 
-int output_definition(
+bool word_exists(const DictionaryRef &d, const std::string &target) {
+	PhaseTimer timer(Stats::PHASE_LOOKUP);
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	std::string key = target;
+	downcase(key);
+	const RowRangeT r = lookup(key, *index);
+	return r.first != r.second;
+}
+
+bool resolve_link(
 	const DictionaryRef &d,
-	const std::string &target,
-	const bool embed_default_css,
-	const bool dark,
-	std::ostream &out,
-	std::ostream &err
+	const std::string &href,
+	const std::string &text,
+	std::string &word
 ) {
-	out <<
-		"<html lang=\"en\">\n"
-		"<head>\n"
-		"<meta charset=\"utf-8\">\n"
-		"<title>Dictionary</title>\n";
+	PhaseTimer timer(Stats::PHASE_LOOKUP);
+	const SharedIndex::IndexPtrT index = d._index.get();
+
+	// x-dictionary:d:word[:dictionary] names the word, the others, such as
+	// x-dictionary:r:id[:dictionary], only have it as their text
+	static const char g_word_scheme[] = "x-dictionary:d:";
+	static const size_t g_word_scheme_size = sizeof(g_word_scheme) - 1;
+
+	std::vector<std::string> candidates;
+	if (href.compare(0, g_word_scheme_size, g_word_scheme) == 0) {
+		const size_t end = href.find(':', g_word_scheme_size);
+		candidates.push_back(href.substr(g_word_scheme_size,
+			end == std::string::npos ? end : end - g_word_scheme_size));
+	}
+	candidates.push_back(text);
 
-	// DefaultStyle.css in the same directory as Body.data
-	std::ostringstream css;
-	{
-		char * const dirc = strdup(d._fn.c_str());
-		const char * const dir = dirname(dirc);
-		if (!dir) {
-			err << "Failed to get dirname from path " << d._fn << "\n";
-			free(dirc);
-			return 1;
+	for (size_t i=0; i<candidates.size(); ++i) {
+		std::string key = candidates[i];
+		strip(key);
+		downcase(key);
+		if (key.empty()) {
+			continue;
+		}
+		const RowRangeT r = lookup(key, *index);
+		if (r.first != r.second) {
+			word = key;
+			return true;
 		}
-		css << dir << "/DefaultStyle.css";
-		free(dirc);
 	}
+	return false;
+}
 
-	if (embed_default_css) {
-		std::ifstream cssfile(css.str().c_str(), std::ios::binary);
-		if (!cssfile.is_open()) {
-			err << "Failed to open \"" << css.str() << "\"\n";
-			return 1;
+IndexStatus index_status(const DictionaryRef &d) {
+	IndexStatus status;
+	status.generation = d._index.generation();
+	status.progress = d._index.progress();
+	status.complete = d._index.complete();
+	return status;
+}
+
+/// Wait until the index has entries for 'target', or is complete
+static void wait_for_word(const DictionaryRef &d, const std::string &target) {
+	std::string key = target;
+	downcase(key);
+
+	while (true) {
+		const unsigned int generation = d._index.generation();
+		const SharedIndex::IndexPtrT index = d._index.get();
+		// a word spelt differently may be found later, so only the
+		// complete index is folded
+		const RowRangeT r = lookup(key, *index, false);
+		if (r.first != r.second || d._index.complete()) {
+			return;
 		}
-		out << "<style>\n";
-		out << cssfile.rdbuf();
-		out << "</style>\n";
-	} else {
-		out << "<link rel=\"stylesheet\" href=\"" << css.str() << "\">\n";
+		d._index.wait(generation);
 	}
+}
 
-	out << "<style>\n";
+static void list_all_words(
+	const DictionaryRef &d,
+	void (*func)(const std::string &, void *data),
+	void *data
+) {
+	const SharedIndex::IndexPtrT index = d._index.get();
 
-	output_body_css(dark, out);
+	for (size_t i=0; i<index->num_entries(); ++i) {
+		func(index->entry_name(i).str(), data);
+	}
+	for (size_t i=0; i<index->num_links(); ++i) {
+		func(index->link_key(i).str(), data);
+	}
+}
 
-	out <<
-		".x_xoLblBlk {\n"
-		"    border-bottom: 1px solid #cccccc;\n"
-		"    padding-bottom: 50px;\n"
-		"    color: #888888;\n"
-		"}\n"
-		".note {\n"
-		"    border: 1px solid #cccccc;\n"
-		"}\n"
-		".reg,.tg_gg,.tg_hw,.sy,.gg,.ex,.sn,.ph,.prx,.tg_vg,.vg {\n"
-		"    color: #777777;\n"
-		"}\n"
-		".v,.bold {\n"
-		"    color: " << (dark ? "white" : "black") << ";\n"
-		"}\n"
-		"</style>\n"
-		"</head>\n";
+/// Publishes partial indexes to a SharedIndex while the entries are read.
+/// Each one is a copy of the whole index so far, so they're spaced out by
+/// a multiple of the time the last one took.
+struct SnapshotPublisher {
+	SnapshotPublisher(SharedIndex &s) : shared(s), next() {}
 
-	out << "<body>\n";
+	SharedIndex &shared;
+	std::chrono::steady_clock::time_point next;
 
-	std::string key = target;
-	downcase(key);
-	const EntryRangeT r = lookup(key, d._index, d._links);
-	if (r.first == r.second) {
-		err << "No entries found\n";
-		return 2;
+	static bool publish(
+		EntryTable &index,
+		const BlockDirectoryT &blocks,
+		const double progress,
+		void *data
+	) {
+		SnapshotPublisher &p = *(SnapshotPublisher*)data;
+		if (p.shared.cancelled()) {
+			return false;
+		}
+
+		const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+		if (start < p.next) {
+			p.shared.publish(SharedIndex::IndexPtrT(), progress, false);
+			return true;
+		}
+
+		std::string buf;
+		const std::shared_ptr<MappedIndex> snapshot = std::make_shared<MappedIndex>();
+		if (	0 == write_index(index, PairTable(), PairTable(), blocks, buf, cerr) &&
+			0 == snapshot->assign(buf, cerr)
+		) {
+			p.shared.publish(snapshot, progress, false);
+		}
+
+		const std::chrono::steady_clock::time_point end =
+			std::chrono::steady_clock::now();
+		p.next = end + std::max<std::chrono::steady_clock::duration>(
+			std::chrono::milliseconds(100), (end - start)*4);
+		return true;
 	}
+};
 
-	std::string content;
+/// Build the index, publishing the partial index to 'shared' as it grows
+/// and the complete one at the end, and write it to 'index_cache' if that
+/// is set. The full-text index is also built if 'fulltext' isn't NULL,
+/// and written next to the index cache. Returns non-zero on error.
+static int build_index_cache(
+	const char * const bin,
+	MappedFile &infile,
+	const std::string &fn,
+	const std::string &index_cache,
+	const unsigned int nthreads,
+	const bool verify,
+	SharedIndex &shared,
+	std::string * const fulltext
+) {
+	cerr << "Reading " << fn << "\n";
+
+	std::string data;
 	{
-		bool multi = std::distance(r.first, r.second) > 1;
+		EntryTable entries;
+		PairTable links;
+		PairTable backlinks;
+		BlockDirectoryT blocks;
+
+		HeadwordCounts counts;
+		SnapshotPublisher publisher(shared);
+
+		infile.advise(MappedFile::SEQUENTIAL);
+		read_all_entries(infile, nthreads, verify, counts,
+				 SnapshotPublisher::publish, &publisher, entries, blocks);
+		if (shared.cancelled()) {
+			return 0;
+		}
 
-		concat_entries(d._infile, r, content);
+		cerr << entries.size() << " index entries\n";
 
-		const BackLinksRangeT br = d._backlinks.equal_range(key);
-		if (br.first != br.second) {
-			multi = true;
-			for (	BackLinksT::const_iterator
-				it=br.first; it!=br.second; ++it
-			) {
-				// append the other page
-				concat_entries(d._infile, d._index.equal_range(it->second), content);
+		if (verify) {
+			cerr << counts.scanned << " headwords scanned, " <<
+				counts.parsed << " parsed with libxml2, " <<
+				counts.mismatched << " differences\n";
+			if (counts.mismatched) {
+				cerr << bin << " : headword scanner doesn't match libxml2\n";
+				return 1;
 			}
 		}
 
-		if (multi) {
-			content += "</div>";
-			content = std::string("<div>") + content;
+		// all the entries, while the links are found
+		publisher.next = std::chrono::steady_clock::time_point();
+		SnapshotPublisher::publish(entries, blocks, 1, &publisher);
+
+		cerr << "Finding links...\n";
+
+		LinkCounts link_counts;
+		find_all_links(entries, nthreads, shared.cancel_flag(), verify,
+			       link_counts, links, backlinks);
+		if (shared.cancelled()) {
+			return 0;
 		}
-	}
 
-	xmlDocPtr doc = xmlParseDoc((xmlChar*)content.c_str());
-	if (doc) {
-		out << "<div class=\"div-entry\">\n";
+		if (verify) {
+			cerr << link_counts.verified << " headwords verified for links, " <<
+				link_counts.mismatched << " differences\n";
+			if (link_counts.mismatched) {
+				cerr << bin << " : link scanner doesn't match the XPath queries\n";
+				return 1;
+			}
+		}
+
+		cerr << links.size() << " links\n";
+		cerr << backlinks.size() << " backlinks\n";
 
-		xmlChar *s;
-		int size;
-		xmlDocDumpMemoryEnc(doc, &s, &size, "UTF-8");
-		if (s) {
-			out.write((char*)s, size);
-			out << "\n";
-			xmlFree(s);
+		if (fulltext) {
+			// while the text of the entries is still here
+			build_fulltext(entries, nthreads, infile.size(), *fulltext);
 		}
 
-		out << "</div>\n";
+		PhaseTimer timer(Stats::PHASE_CACHE_WRITE);
+		if (write_index(entries, links, backlinks, blocks, data, cerr)) {
+			cerr << bin << " : failed to write index\n";
+			return 1;
+		}
 	}
 
-	out << "</body>\n";
+	if (!index_cache.empty()) {
+		// save index
+		if (fulltext) {
+			const std::string fts = fulltext_file_name(index_cache);
+			cerr << "Writing full-text index to \"" << fts << "\"\n";
+			if (write_file(fts, *fulltext)) {
+				cerr << bin << " : failed to write full-text index to \"" << fts << "\"\n";
+			}
+		}
+		cerr << "Writing index to \"" << index_cache << "\"\n";
+		PhaseTimer timer(Stats::PHASE_CACHE_WRITE);
+		if (write_file(index_cache, data)) {
+			cerr << bin << " : failed to write index cache to \"" << index_cache << "\"\n";
+		}
+	}
 
-	if (doc) {
-		xmlFreeDoc(doc);
-		return 0;
+	const std::shared_ptr<MappedIndex> index = std::make_shared<MappedIndex>();
+	if (index->assign(data, cerr)) {
+		cerr << bin << " : failed to read generated index\n";
+		return 1;
 	}
 
-	err << "Failed to parse entry for \"" << target << "\"\n";
-	return 1;
+	infile.advise(MappedFile::RANDOM);
+	shared.publish(index, 1, true);
+	return 0;
 }
 
-void list_words(
-	const DictionaryRef &d,
-	const std::string &target,
-	void (*func)(const std::string &, void *data),
-	void *data
+/// Build the full-text index for an index cache that was built without
+/// it, which means reading all the entries again. Written next to
+/// 'index_cache' if that is set.
+static void build_fulltext_cache(
+	const char * const bin,
+	MappedFile &infile,
+	const std::string &fn,
+	const std::string &index_cache,
+	const unsigned int nthreads,
+	std::string &out
 ) {
-	std::string key = target;
-	downcase(key);
+	cerr << "Reading " << fn << "\n";
 
-	for (	IndexT::const_iterator it=d._index.lower_bound(key);
-		it!=d._index.end() && startswith(it->first, key.c_str()); ++it
-	) {
-		func(it->second._name, data);
-	}
-	for (	LinksT::const_iterator it=d._links.lower_bound(key);
-		it!=d._links.end() && startswith(it->first, key.c_str()); ++it
-	) {
-		func(it->first, data);
-	}
-}
+	EntryTable entries;
+	BlockDirectoryT blocks;
+	HeadwordCounts counts;
 
-static void list_all_words(
-	const DictionaryRef &d,
-	void (*func)(const std::string &, void *data),
-	void *data
-) {
-	for (	IndexT::const_iterator
-		it=d._index.begin(); it!=d._index.end(); ++it
-	) {
-		func(it->second._name, data);
-	}
-	for (	LinksT::const_iterator
-		it=d._links.begin(); it!=d._links.end(); ++it
-	) {
-		func(it->first, data);
+	infile.advise(MappedFile::SEQUENTIAL);
+	read_all_entries(infile, nthreads, false, counts, NULL, NULL, entries, blocks);
+	infile.advise(MappedFile::RANDOM);
+
+	build_fulltext(entries, nthreads, infile.size(), out);
+
+	if (!index_cache.empty()) {
+		const std::string fts = fulltext_file_name(index_cache);
+		cerr << "Writing full-text index to \"" << fts << "\"\n";
+		if (write_file(fts, out)) {
+			cerr << bin << " : failed to write full-text index to \"" << fts << "\"\n";
+		}
 	}
 }
 
 static void usage(const char * const bin) {
-	cerr << bin << " [-h] -d /path/to/Body.data [-i index] [-D] [-c] [-a] [[-l | -o out.html] word]\n";
+	cerr << bin << " [-h] -d /path/to/Body.data [-i index] [-j threads] [-m MiB] [-z backend] [-V] [-D] [-c] [-p n] [-a] [--serve address] [-b words [-f format] [-o out]] [-e dest [-f format]] [-T] [-s query] [--stats file] [[-l | -o out.html] word]\n";
 	cerr << "\n";
 	cerr << "-h    Print help.\n";
 	cerr << "-d    Absolute path to Body.data file. The DefaultStyle.css in the same directory will also be read.\n";
 	cerr << "-i    Index cache file to write (if it doesn't exist), otherwise read. Recommended for speed.\n";
+	cerr << "-j    Number of threads used to build the index. Defaults to the number of cores.\n";
+	cerr << "-m    Memory for the cache of decompressed blocks, in MiB. Defaults to 16, 0 disables it.\n";
+	cerr << "-z    Library used to decompress Body.data: " << inflate_backends_available() << ". Defaults to zlib.\n";
+	cerr << "-V    Verify the headword and link scanners against libxml2 while building the index.\n";
 	cerr << "-D    Dark mode.\n";
 	cerr << "-c    Centre the window on the screen.\n";
+	cerr << "-p    Definitions the GUI renders while idle, before they're asked for: those of the\n";
+	cerr << "      words next to the selected one and of the first words of the list. Defaults\n";
+	cerr << "      to 4, 0 disables it.\n";
 	cerr << "-l    List words to stdout for which 'word' is a prefix, instead of starting GUI.\n";
+	cerr << "      If there are none, list words spelt like 'word'.\n";
 	cerr << "-a    List all words to stdout, one per line, instead of starting GUI.\n";
 	cerr << "-o    Output html file containing the definition of 'word', instead of starting GUI.\n";
+	cerr << "      While the index is built this is done as soon as 'word' is found, without\n";
+	cerr << "      the entries and links of the rest of the dictionary.\n";
+	cerr << "-b    Output the definitions of the words in file 'words', one per line, or - for stdin.\n";
+	cerr << "      Written to stdout, or the file given with -o.\n";
+	cerr << "-f    Format for -b: html (default), the page of each word, or jsonl, one JSON object\n";
+	cerr << "      per word with \"word\" and either \"html\" or \"error\".\n";
+	cerr << "-e    Export the definitions of all the words, using -j threads. With -f html, 'dest' is\n";
+	cerr << "      a directory for the html files, listed in its index.tsv. With -f jsonl, 'dest' is\n";
+	cerr << "      the output file, or - for stdout.\n";
+	cerr << "-T    Build a full-text index of the definitions next to the index cache, if there\n";
+	cerr << "      isn't one. Start a search with ? in the GUI to use it.\n";
+	cerr << "-s    List words to stdout of the entries which match the full-text 'query', best\n";
+	cerr << "      first, instead of starting GUI. All the words of 'query' must be in an entry.\n";
+	cerr << "      Use \"a phrase\" for words in order, -word to exclude a word, and OR between\n";
+	cerr << "      alternatives.\n";
+	cerr << "--serve  Answer lookups over HTTP on 'address', instead of starting GUI. 'address' is\n";
+	cerr << "      a port on localhost, host:port, or the path of a Unix socket. Endpoints are\n";
+	cerr << "      /define?w=word[&dark=1], /list?w=prefix[&start=n][&n=n], /count?w=prefix,\n";
+	cerr << "      /exists?w=word, /search?q=query and /stats.\n";
+	cerr << "--stats  Write the wall and CPU time of each phase, counts such as blocks inflated\n";
+	cerr << "      and cache hits, and the peak RSS to 'file' as JSON on exit, or - for stderr.\n";
 	cerr << "word  Word to lookup.\n";
 }
 
 int main(int argc, char *argv[]) {
 
-	std::string fn, index_cache, target, out_fn;
+	std::string fn, index_cache, target, out_fn, serve, batch, export_dest, search, stats_fn;
+	BatchFormat batch_format = BATCH_HTML;
 	bool list = false;
 	bool all = false;
 	bool dark = false;
 	bool centre = false;
+	unsigned int nthreads = std::thread::hardware_concurrency();
+	size_t block_cache_mb = 16;
+#ifdef WANT_GUI
+	unsigned int prefetch = 4;
+#endif
+	bool verify = false;
+	bool fulltext = false;
 
 	// command line options
 	{
+		// long options without a short one
+		enum {
+			OPT_SERVE = 256,
+			OPT_STATS
+		};
+		static const struct option long_options[] = {
+			{ "serve", required_argument, NULL, OPT_SERVE },
+			{ "stats", required_argument, NULL, OPT_STATS },
+			{ "help",  no_argument,       NULL, 'h' },
+			{ NULL, 0, NULL, 0 }
+		};
+
 		int opt;
-		while ((opt = getopt(argc, argv, "hd:i:o:laDc")) != -1) {
+		while ((opt = getopt_long(argc, argv, "hd:i:o:laDcj:m:z:Vb:f:e:Ts:p:",
+					  long_options, NULL)) != -1) {
 			switch (opt) {
+			case OPT_SERVE:
+				serve = optarg;
+				break;
+			case OPT_STATS:
+				stats_fn = optarg;
+				process_stats().enable();
+				break;
 			case 'h':
 				usage(argv[0]);
 				return 0;
@@ -953,6 +3319,70 @@ int main(int argc, char *argv[]) {
 			case 'c':
 				centre = true;
 				break;
+			case 'V':
+				verify = true;
+				break;
+			case 'b':
+				batch = optarg;
+				break;
+			case 'e':
+				export_dest = optarg;
+				break;
+			case 'T':
+				fulltext = true;
+				break;
+			case 's':
+				search = optarg;
+				break;
+			case 'f':
+				if (!strcmp(optarg, "html")) {
+					batch_format = BATCH_HTML;
+				} else if (!strcmp(optarg, "jsonl")) {
+					batch_format = BATCH_JSONL;
+				} else {
+					cerr << argv[0] << " : -f expects html or jsonl\n";
+					return 1;
+				}
+				break;
+			case 'j': {
+				const int n = atoi(optarg);
+				if (n < 1) {
+					cerr << argv[0] << " : -j expects a positive number of threads\n";
+					return 1;
+				}
+				nthreads = n;
+				break;
+			}
+			case 'm': {
+				const int n = atoi(optarg);
+				if (n < 0) {
+					cerr << argv[0] << " : -m expects a size in MiB\n";
+					return 1;
+				}
+				block_cache_mb = n;
+				break;
+			}
+#ifdef WANT_GUI
+			case 'p': {
+				const int n = atoi(optarg);
+				if (n < 0) {
+					cerr << argv[0] << " : -p expects a number of definitions\n";
+					return 1;
+				}
+				prefetch = n;
+				break;
+			}
+#endif
+			case 'z': {
+				InflateBackend b;
+				if (inflate_backend_from_name(optarg, b)) {
+					cerr << argv[0] << " : -z expects one of " <<
+						inflate_backends_available() << "\n";
+					return 1;
+				}
+				set_inflate_backend(b);
+				break;
+			}
 			default:
 				usage(argv[0]);
 				return 1;
@@ -976,104 +3406,204 @@ int main(int argc, char *argv[]) {
 
 
 	LIBXML_TEST_VERSION
+	// must be called before libxml2 is used from other threads
+	xmlInitParser();
 	xmlKeepBlanksDefault(0);
 
-	IndexT index;
-	LinksT links;
-	BackLinksT backlinks;
-
-	std::ifstream infile(fn.c_str(), std::ios::binary);
-	if (!infile.is_open()) {
-		cerr << argv[0] << " : failed to open \"" << fn << "\"\n";
-		return 1;
+	MappedFile infile;
+	{
+		PhaseTimer timer(Stats::PHASE_FILE_READ);
+		if (infile.open(fn, cerr)) {
+			cerr << argv[0] << " : failed to open \"" << fn << "\"\n";
+			return 1;
+		}
 	}
 
-	if (index_cache.empty() || !file_exists(index_cache.c_str())) {
-
-		// generate index
+	SharedIndex shared;
+	std::thread builder;
+	int build_result = 0;
+	std::string fulltext_data;
 
-		cerr << "Reading " << fn << "\n";
+	if (index_cache.empty() || !file_exists(index_cache.c_str())) {
 
-		std::string content;
-		{
-			infile.seekg(0, std::ios::end);
-			content.resize(infile.tellg());
-			infile.seekg(0, std::ios::beg);
-			if (!infile.read(&content[0], content.size())) {
-				cerr << argv[0] << " : failed to read " << content.size() << " bytes from \"" << fn << "\"\n";
+		// generate index in the background, lookups use the part
+		// built so far
+		builder = std::thread([&]() {
+			build_result = build_index_cache(
+				argv[0], infile, fn, index_cache, nthreads, verify, shared,
+				fulltext ? &fulltext_data : NULL);
+			// wake anyone waiting, even if the build failed
+			shared.publish(SharedIndex::IndexPtrT(), 1, true);
+		});
+
+		if (	verify || all || list || fulltext || !search.empty() ||
+			!batch.empty() || !export_dest.empty()
+		) {
+			// these need the whole index
+			builder.join();
+			if (build_result) {
 				return 1;
 			}
 		}
 
-		read_all_entries(100, content, index);
-
-		cerr << index.size() << " index entries\n";
-
-		cerr << "Finding links...\n";
+	} else {
+		// load index
+		PhaseTimer timer(Stats::PHASE_CACHE_LOAD);
+		const std::shared_ptr<MappedIndex> index = std::make_shared<MappedIndex>();
+		int ret = index->open(index_cache, cerr);
+
+		if (ret == 2) {
+			// version 1, read it into memory and replace it
+			cerr << "Upgrading index cache \"" << index_cache << "\"\n";
+
+			std::string data;
+			{
+				std::ifstream idxfile(index_cache.c_str(), std::ios::binary);
+				if (!idxfile.is_open()) {
+					cerr << argv[0] << " : failed to open index cache \"" << index_cache << "\"\n";
+					return 1;
+				}
 
-		FindLinks find_links(index, links, backlinks);
-		{
-			const std::ios_base::fmtflags flags = cerr.flags();
-			const std::streamsize prec = cerr.precision();
-			const size_t index_size = index.size();
-			size_t i = 0, k = 0;
-
-			IndexT::const_iterator last, it;
-			for (last = it = index.begin(); it!=index.end(); ++it, ++i) {
-				if (last->first != it->first) {
-					find_links(EntryRangeT(last, it));
-					last = it;
-
-					if (k++ % 2000 == 0) {
-						cerr << std::setprecision(2) << std::fixed <<
-							((float(i)/index_size)*100) << "%\t" <<
-							std::setprecision(prec) <<
-							links.size() << " links\n";
-					}
+				EntryTable entries;
+				PairTable links;
+				PairTable backlinks;
+				if (read_index(entries, links, backlinks, idxfile)) {
+					cerr << argv[0] << " : failed to read index cache \"" << index_cache << "\"\n";
+					return 1;
+				}
+				// the block headers are cheap to read, unlike
+				// finding the blocks by inflating them
+				BlockDirectoryT blocks;
+				read_block_headers(infile, g_body_blocks_offset,
+						   body_end(infile), blocks);
+				if (write_index(entries, links, backlinks, blocks, data, cerr)) {
+					cerr << argv[0] << " : failed to convert index cache \"" << index_cache << "\"\n";
+					return 1;
 				}
 			}
-			find_links(EntryRangeT(last, it));
-
-			cerr.flags(flags);
-		}
-
-		cerr << links.size() << " links\n";
-		cerr << backlinks.size() << " backlinks\n";
 
-		if (!index_cache.empty()) {
-			// save index
-			cerr << "Writing index to \"" << index_cache << "\"\n";
-			std::ofstream outfile(
-				index_cache.c_str(),
-				std::ios::out|std::ios::trunc|std::ios::binary);
-			if (!outfile.is_open()) {
+			if (write_file(index_cache, data)) {
 				cerr << argv[0] << " : failed to write index cache to \"" << index_cache << "\"\n";
+				ret = index->assign(data, cerr);
 			} else {
-				write_index(index, links, backlinks, outfile);
+				ret = index->open(index_cache, cerr);
 			}
 		}
 
-	} else {
-		// load index
-		std::ifstream idxfile(index_cache.c_str(), std::ios::binary);
-		if (!idxfile.is_open()) {
-			cerr << argv[0] << " : failed to open index cache \"" << index_cache << "\"\n";
-			return 1;
-		}
-		if (read_index(index, links, backlinks, idxfile)) {
+		if (ret) {
 			cerr << argv[0] << " : failed to read index cache \"" << index_cache << "\"\n";
 			return 1;
 		}
-		if (index.empty()) {
+		if (!index->num_entries()) {
 			cerr << argv[0] << " : index was empty after load from \"" << index_cache << "\"\n";
 			return 1;
 		}
+
+		infile.advise(MappedFile::RANDOM);
+		shared.publish(index, 1, true);
+	}
+
+	FullTextIndex fulltext_index;
+	if (!fulltext_data.empty()) {
+		if (fulltext_index.assign(fulltext_data, cerr)) {
+			cerr << argv[0] << " : failed to read generated full-text index\n";
+			return 1;
+		}
+	} else if (!index_cache.empty() && !builder.joinable()) {
+		// the index is complete, so it can be checked against the
+		// full-text index
+		const std::string fts = fulltext_file_name(index_cache);
+		if (	file_exists(fts.c_str()) &&
+			0 == fulltext_index.open(fts, cerr) &&
+			!fulltext_index.matches(shared.get()->num_entries(), infile.size())
+		) {
+			cerr << argv[0] << " : full-text index \"" << fts << "\" is out of date\n";
+			fulltext_index.close();
+		}
+	}
+	if (fulltext && !fulltext_index.is_open()) {
+		build_fulltext_cache(argv[0], infile, fn, index_cache, nthreads, fulltext_data);
+		if (fulltext_index.assign(fulltext_data, cerr)) {
+			cerr << argv[0] << " : failed to read generated full-text index\n";
+			return 1;
+		}
 	}
 
-	const DictionaryRef dict(infile, fn, index, links, backlinks);
+	BlockCache blocks(block_cache_mb << 20);
+
+	PageCache pages(g_page_cache_size);
+
+	const DictionaryRef dict(infile, fn, shared, blocks, pages, fulltext_index);
 	int res = 0;
 
 	do {
+		if (!serve.empty()) {
+			Server server(dict, dark);
+			if (server.listen(serve, cerr)) {
+				cerr << argv[0] << " : failed to start server\n";
+				res = 1;
+				break;
+			}
+			res = server.run(cerr);
+			break;
+		}
+
+		if (!batch.empty()) {
+			std::vector<std::string> words;
+			if (read_words(batch, words)) {
+				cerr << argv[0] << " : failed to read words from \"" << batch << "\"\n";
+				res = 1;
+				break;
+			}
+
+			std::ofstream outfile;
+			if (!out_fn.empty()) {
+				outfile.open(out_fn.c_str(), std::ios::out|std::ios::trunc|std::ios::binary);
+				if (!outfile.is_open()) {
+					cerr << argv[0] << " : failed to create output file " << out_fn << "\n";
+					res = 1;
+					break;
+				}
+			}
+
+			const size_t not_found = output_batch(
+				dict, words, batch_format, dark,
+				out_fn.empty() ? cout : outfile, cerr);
+			cerr << words.size() - not_found << " of " << words.size() << " words found\n";
+			break;
+		}
+
+		if (!export_dest.empty()) {
+			std::ofstream outfile;
+			if (batch_format == BATCH_JSONL && export_dest != "-") {
+				outfile.open(export_dest.c_str(), std::ios::out|std::ios::trunc|std::ios::binary);
+				if (!outfile.is_open()) {
+					cerr << argv[0] << " : failed to create output file " << export_dest << "\n";
+					res = 1;
+					break;
+				}
+			}
+
+			const SharedIndex::IndexPtrT index = shared.get();
+			Exporter exporter(dict, *index, batch_format, export_dest, dark, nthreads);
+			res = exporter.run(outfile.is_open() ? outfile : cout, cerr);
+			break;
+		}
+
+		if (!search.empty()) {
+			unsigned int num_found = 0U;
+			res = search_words(dict, search,
+				[](const std::string &word, void *data) {
+					unsigned int &num_found = *((unsigned int*)data);
+					cout << word << "\n";
+					++num_found;
+				}, &num_found, cerr);
+			if (!res) {
+				cerr << num_found << " found\n";
+			}
+			break;
+		}
+
 		if (all) {
 			list_all_words(dict,
 				[](const std::string &word, void *data) {
@@ -1096,7 +3626,25 @@ int main(int argc, char *argv[]) {
 						++num_found;
 					}, &num_found);
 
-				cerr << num_found << " found\n";
+				if (num_found) {
+					cerr << num_found << " found\n";
+					break;
+				}
+
+				// nothing starts with it, perhaps a typo
+				unsigned int num_similar = 0U;
+				suggest_words(dict, target,
+					[](const std::string &word, void *data) {
+						unsigned int &num_similar = *((unsigned int*)data);
+						cout << word << "\n";
+						++num_similar;
+					}, &num_similar);
+
+				cerr << "0 found";
+				if (num_similar) {
+					cerr << ", " << num_similar << " similar";
+				}
+				cerr << "\n";
 				break;
 
 			} else if (!out_fn.empty()) {
@@ -1104,9 +3652,13 @@ int main(int argc, char *argv[]) {
 				std::ofstream outfile(out_fn.c_str(), std::ios::out|std::ios::trunc);
 				if (!outfile.is_open()) {
 					cerr << argv[0] << " : failed to create output file " << out_fn << "\n";
-					return 1;
+					res = 1;
+					break;
 				}
 
+				// answer from the partial index as soon as
+				// it has the word
+				wait_for_word(dict, target);
 				res = output_definition(dict, target, false, dark, outfile, cerr);
 				break;
 			}
@@ -1115,7 +3667,7 @@ int main(int argc, char *argv[]) {
 #ifdef WANT_GUI
 		QApplication app(argc, argv);
 
-		Window * const w = new Window(dict, dark, target);
+		Window * const w = new Window(dict, dark, target, prefetch);
 		w->resize(850, 600);
 
 		if (centre) {
@@ -1131,11 +3683,45 @@ int main(int argc, char *argv[]) {
 
 		w->show();
 
-		return app.exec();
+		res = app.exec();
 #endif
 
 	} while (0);
 
+	if (builder.joinable()) {
+		if (index_cache.empty()) {
+			// nobody will use the rest of the index
+			shared.cancel();
+		} else {
+			cerr << "Finishing index cache \"" << index_cache << "\"\n";
+		}
+		builder.join();
+		if (build_result) {
+			res = 1;
+		}
+	}
+
+	if (!stats_fn.empty()) {
+		Stats &stats = process_stats();
+		const BlockCache::Stats block_stats = blocks.stats();
+		const PageCache::Stats page_stats = pages.stats();
+		stats.set(Stats::BLOCK_CACHE_HITS, block_stats.hits);
+		stats.set(Stats::BLOCK_CACHE_MISSES, block_stats.misses);
+		stats.set(Stats::PAGE_CACHE_HITS, page_stats.hits);
+		stats.set(Stats::PAGE_CACHE_MISSES, page_stats.misses);
+
+		if (stats_fn == "-") {
+			stats.write_json(cerr);
+		} else {
+			std::ofstream out(stats_fn.c_str(), std::ios::out|std::ios::trunc);
+			stats.write_json(out);
+			out.close();
+			if (!out) {
+				cerr << argv[0] << " : failed to write stats to \"" << stats_fn << "\"\n";
+				res = 1;
+			}
+		}
+	}
 
 	xmlCleanupParser();
 